@@ -0,0 +1,146 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// measures how quickly each crypto provider this processor supports encrypts
+// and decrypts, both in bulk and as many short credentials, each with its own
+// key schedule.  it fails if any provider disagrees with tiny-AES-c.
+//
+// usage: crypto_benchmark [megabytes]
+
+#include "Crypto.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+// a credential of the current format, of a typical length
+static constexpr std::size_t CredentialLength = 48;
+
+template <typename F>
+double Seconds(F&& f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    f();
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        auto const megabytes = argc > 1 ? std::stoul(argv[1]) : 64ul;
+
+        if (!megabytes)
+            throw std::runtime_error("The buffer must not be empty");
+
+        std::mt19937 random(12345);
+
+        std::vector<std::uint8_t> key(CryptoProvider::KeyLength);
+        std::vector<std::uint8_t> iv(CryptoProvider::BlockLength);
+        std::vector<std::uint8_t> plain(megabytes * 1024 * 1024);
+
+        for (auto* bytes : {&key, &iv, &plain})
+            for (auto& byte : *bytes)
+                byte = static_cast<std::uint8_t>(random());
+
+        auto const& software =
+            GetCryptoProvider(CryptoImplementation::Software);
+
+        auto expected = plain;
+        software.Encrypt(key.data(), iv.data(), expected.data(),
+                         expected.size());
+
+        std::cout << megabytes << " MiB in bulk, and " << CredentialLength
+                  << " byte credentials\n";
+
+        for (auto const implementation :
+             {CryptoImplementation::Software, CryptoImplementation::AesNi})
+        {
+            if (!IsSupported(implementation))
+                continue;
+
+            auto const& provider = GetCryptoProvider(implementation);
+            auto buffer = plain;
+
+            auto const encrypt = Seconds(
+                [&]()
+                {
+                    provider.Encrypt(key.data(), iv.data(), buffer.data(),
+                                     buffer.size());
+                });
+
+            if (buffer != expected)
+                throw std::runtime_error(std::string(provider.Name()) +
+                                         " disagrees with tiny-AES-c");
+
+            auto const decrypt = Seconds(
+                [&]()
+                {
+                    provider.Decrypt(key.data(), iv.data(), buffer.data(),
+                                     buffer.size());
+                });
+
+            if (buffer != plain)
+                throw std::runtime_error(std::string(provider.Name()) +
+                                         " failed to decrypt");
+
+            // as when every credential in a config file is decrypted
+            auto const credentials = plain.size() / CredentialLength;
+            auto const each = Seconds(
+                [&]()
+                {
+                    for (auto i = 0u; i < credentials; ++i)
+                        provider.Decrypt(key.data(), iv.data(),
+                                         &buffer[i * CredentialLength],
+                                         CredentialLength);
+                });
+
+            std::cout << "  " << provider.Name() << ": encrypt "
+                      << plain.size() / encrypt / 1e6 << " MB/s, decrypt "
+                      << plain.size() / decrypt / 1e6 << " MB/s, "
+                      << credentials / each << " credentials per second\n";
+        }
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "crypto_benchmark: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,53 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Placement.hpp"
+#include "ProcessBackend.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+
+// launch a client with the calls on the backend which BootClient and the
+// ejection which follows it make.  the settings section and the export lookup
+// are left out, as they need windows.
+inline void FakeLaunch(ProcessBackend& backend,
+                       const ProcessPlacement& placement)
+{
+    // where the boot function would be found within our dll
+    static constexpr std::uintptr_t BootRva = 0x1000;
+
+    auto const client =
+        backend.CreateSuspended("Wow.exe", {L"-console"}, "wowreeb.dll");
+
+    client->Place(placement);
+
+    if (!!client->Call(client->GetModule() + BootRva))
+        throw std::runtime_error("Boot failed");
+
+    client->Resume();
+    client->Eject();
+}
@@ -0,0 +1,117 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// measures how quickly a group of clients is launched by the scheduler as the
+// number launched at once grows, with the fake backend standing in for the
+// clients.  as in a group whose realms ask for it, each client is given its own
+// physical cores.
+//
+// usage: group_benchmark [clients] [most at once] [microseconds per round-trip]
+
+#include "FakeBackend.hpp"
+#include "FakeLaunch.hpp"
+#include "Placement.hpp"
+#include "Scheduler.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        auto const clients = argc > 1 ? std::stoul(argv[1]) : 64ul;
+        auto const mostAtOnce = argc > 2 ? std::stoul(argv[2]) : 8ul;
+        auto const latency =
+            std::chrono::microseconds(argc > 3 ? std::stoul(argv[3]) : 200ul);
+
+        if (!clients || !mostAtOnce)
+            throw std::runtime_error("At least one client is required");
+
+        FakeBackend backend(latency);
+
+        auto const cores = backend.GetPhysicalCores();
+
+        std::vector<std::string> names;
+
+        for (auto i = 0ul; i < clients; ++i)
+            names.push_back("Client " + std::to_string(i));
+
+        std::cout << clients << " clients, " << latency.count()
+                  << "us per round-trip\n";
+
+        for (auto parallelism = 1ul; parallelism <= mostAtOnce;
+             parallelism *= 2)
+        {
+            GroupPolicy policy {};
+            policy.Parallelism = static_cast<unsigned int>(parallelism);
+
+            // the admission checks are made, but always pass
+            policy.MinFreeMemory = 1;
+            policy.MaxDiskQueue = 1.f;
+
+            auto const start = std::chrono::steady_clock::now();
+
+            auto const report = LaunchGroup(
+                backend, policy, names,
+                [&backend, &cores, clients](std::size_t index)
+                {
+                    ProcessPlacement placement {};
+                    placement.Affinity = PlanAffinity(cores, clients, index);
+
+                    FakeLaunch(backend, placement);
+                });
+
+            auto const elapsed = std::chrono::duration<double>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count();
+
+            if (!report.Errors.empty())
+                throw std::runtime_error(report.Errors.front());
+
+            if (report.AdmissionTimeouts)
+                throw std::runtime_error("A launch was not admitted");
+
+            std::cout << "  " << parallelism << " at once: "
+                      << clients / elapsed << " launches per second\n";
+        }
+
+        if (backend.LiveClients())
+            throw std::runtime_error("A client was left running");
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "group_benchmark: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// checks that each hex kernel this processor supports encodes random data as a
+// naive encoder does, decodes it again in either case, and rejects any
+// character which is not a hex digit, for every length from 0 to 100 bytes.
+// then measures how quickly each encodes and decodes.  it fails if any kernel
+// is wrong.
+//
+// usage: hex_benchmark [megabytes] [trials per length]
+
+#include "Hex.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct NamedKernel
+{
+    HexKernel Kernel;
+    const char* Name;
+};
+
+const NamedKernel Kernels[] = {
+    {HexKernel::Scalar, "scalar"},
+    {HexKernel::Ssse3, "ssse3"},
+    {HexKernel::Avx2, "avx2"},
+};
+
+static constexpr std::size_t MaxLength = 100;
+
+std::string EncodeNaive(const std::vector<std::uint8_t>& data)
+{
+    static constexpr char digits[] = "0123456789abcdef";
+
+    std::string result;
+
+    for (auto const byte : data)
+    {
+        result += digits[byte >> 4];
+        result += digits[byte & 0xf];
+    }
+
+    return result;
+}
+
+void Fail(const NamedKernel& kernel, const std::string& what,
+          std::size_t length)
+{
+    throw std::runtime_error(std::string(kernel.Name) + " " + what + " for " +
+                             std::to_string(length) + " bytes");
+}
+
+void Verify(const NamedKernel& kernel, std::size_t trials,
+            std::mt19937& random)
+{
+    for (std::size_t length = 0; length <= MaxLength; ++length)
+    {
+        for (auto trial = 0u; trial < trials; ++trial)
+        {
+            std::vector<std::uint8_t> data(length);
+
+            for (auto& byte : data)
+                byte = static_cast<std::uint8_t>(random());
+
+            auto const hex =
+                DataToHexWith(kernel.Kernel, data.data(), data.size());
+
+            if (hex != EncodeNaive(data))
+                Fail(kernel, "encoded wrongly", length);
+
+            // each digit in either case, at random
+            auto mixed = hex;
+
+            for (auto& c : mixed)
+                if (random() % 2)
+                    c = static_cast<char>(::toupper(c));
+
+            std::vector<std::uint8_t> decoded(length);
+
+            if (!HexToDataWith(kernel.Kernel, mixed.c_str(), decoded.data(),
+                               length) ||
+                decoded != data)
+                Fail(kernel, "decoded wrongly", length);
+
+            if (!length)
+                continue;
+
+            // any character but a hex digit, anywhere, is rejected
+            char bad;
+
+            do
+                bad = static_cast<char>(random());
+            while (::isxdigit(static_cast<unsigned char>(bad)));
+
+            mixed[random() % mixed.length()] = bad;
+
+            if (HexToDataWith(kernel.Kernel, mixed.c_str(), decoded.data(),
+                              length))
+                Fail(kernel, "accepted \"" + std::to_string(
+                                  static_cast<unsigned char>(bad)) + "\"",
+                     length);
+        }
+    }
+}
+
+template <typename F>
+double Seconds(F&& f)
+{
+    auto const start = std::chrono::steady_clock::now();
+    f();
+
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        auto const megabytes = argc > 1 ? std::stoul(argv[1]) : 64ul;
+        auto const trials = argc > 2 ? std::stoul(argv[2]) : 1000ul;
+
+        std::mt19937 random(12345);
+
+        std::vector<std::uint8_t> data(megabytes * 1024 * 1024);
+
+        for (auto& byte : data)
+            byte = static_cast<std::uint8_t>(random());
+
+        std::cout << megabytes << " MiB of random bytes\n";
+
+        for (auto const& kernel : Kernels)
+        {
+            if (!SupportsKernel(kernel.Kernel))
+            {
+                std::cout << "  " << kernel.Name << ": not supported\n";
+                continue;
+            }
+
+            Verify(kernel, trials, random);
+
+            std::string hex;
+            std::vector<std::uint8_t> decoded(data.size());
+            auto valid = false;
+
+            auto const encode = Seconds(
+                [&]()
+                {
+                    hex = DataToHexWith(kernel.Kernel, data.data(),
+                                        data.size());
+                });
+
+            auto const decode = Seconds(
+                [&]()
+                {
+                    valid = HexToDataWith(kernel.Kernel, hex.c_str(),
+                                          decoded.data(), decoded.size());
+                });
+
+            if (!valid || decoded != data)
+                Fail(kernel, "failed the round trip", data.size());
+
+            std::cout << "  " << kernel.Name << ": encode "
+                      << data.size() / encode / 1e9 << " GB/s, decode "
+                      << data.size() / decode / 1e9 << " GB/s\n";
+        }
+
+        std::cout << "every kernel agreed for " << trials
+                  << " random inputs of each length up to " << MaxLength
+                  << " bytes\n";
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "hex_benchmark: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
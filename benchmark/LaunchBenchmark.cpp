@@ -0,0 +1,131 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// measures how many clients can be launched per second and how many
+// cross-process round-trips each launch makes, with the fake backend standing
+// in for the clients.
+//
+// usage: launch_benchmark [launches] [microseconds per round-trip]
+
+#include "FakeBackend.hpp"
+#include "FakeLaunch.hpp"
+#include "Placement.hpp"
+#include "ProcessBackend.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Totals
+{
+    unsigned int RoundTrips;
+    unsigned int Reads;
+    unsigned int Writes;
+    unsigned int Allocations;
+};
+
+Totals Snapshot(const BackendCounters& counters)
+{
+    return {counters.RoundTrips(), counters.Reads, counters.Writes,
+            counters.Allocations};
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        auto const launches = argc > 1 ? std::stoul(argv[1]) : 1000ul;
+        auto const latency =
+            std::chrono::microseconds(argc > 2 ? std::stoul(argv[2]) : 0ul);
+
+        if (!launches)
+            throw std::runtime_error("At least one launch is required");
+
+        FakeBackend backend(latency);
+        ProcessPlacement placement {};
+
+        std::vector<double> times;
+        times.reserve(launches);
+
+        auto const before = Snapshot(backend.Counters);
+
+        for (auto i = 0ul; i < launches; ++i)
+        {
+            auto const start = std::chrono::steady_clock::now();
+
+            FakeLaunch(backend, placement);
+
+            times.push_back(std::chrono::duration<double, std::micro>(
+                                std::chrono::steady_clock::now() - start)
+                                .count());
+        }
+
+        auto const after = Snapshot(backend.Counters);
+
+        double total = 0.0;
+
+        for (auto const t : times)
+            total += t;
+
+        std::sort(times.begin(), times.end());
+
+        auto const perLaunch = [launches](unsigned int from, unsigned int to)
+        { return static_cast<double>(to - from) / launches; };
+
+        std::cout << "launches:            " << launches << "\n"
+                  << "launches per second: " << launches * 1e6 / total << "\n"
+                  << "mean latency:        " << total / launches << "us\n"
+                  << "median latency:      " << times[times.size() / 2]
+                  << "us\n"
+                  << "99th percentile:     " << times[times.size() * 99 / 100]
+                  << "us\n"
+                  << "round-trips/launch:  "
+                  << perLaunch(before.RoundTrips, after.RoundTrips) << "\n"
+                  << "reads/launch:        "
+                  << perLaunch(before.Reads, after.Reads) << "\n"
+                  << "writes/launch:       "
+                  << perLaunch(before.Writes, after.Writes) << "\n"
+                  << "allocations/launch:  "
+                  << perLaunch(before.Allocations, after.Allocations) << "\n";
+
+        if (backend.LiveClients())
+            throw std::runtime_error("A client was left running");
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "launch_benchmark: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,243 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// measures how much sooner a client reads its archives when they are
+// prefetched from the moment its launch is requested.  archives are written to
+// a client folder in the temporary directory and evicted from the page cache,
+// then read as a client would, once cold and once after the prefetcher has had
+// the head start which the rest of the launch gives it.
+//
+// usage: prefetch_benchmark [megabytes of archives] [milliseconds head start]
+
+#include "Prefetcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+static constexpr std::size_t BlockSize = 64 * 1024;
+
+// as a client's data folder, with its locale archives in a folder beneath
+const char* const Archives[] = {
+    "common.MPQ",
+    "expansion.MPQ",
+    "patch.MPQ",
+    "enUS/locale-enUS.MPQ",
+};
+
+using Clock = std::chrono::steady_clock;
+
+// drop the file from the page cache, so that it is next read from the disk
+void Evict(const fs::path& file)
+{
+#ifdef _WIN32
+    // opening a file without buffering discards what is cached of it
+    auto const handle = ::CreateFileW(
+        file.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+
+    if (handle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to evict " + file.string());
+
+    ::CloseHandle(handle);
+#else
+    auto const fd = ::open(file.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        throw std::runtime_error("Failed to evict " + file.string());
+
+    // only pages which have been written back can be dropped
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#endif
+}
+
+void WriteArchives(const fs::path& data, std::size_t megabytes)
+{
+    std::mt19937_64 random(1);
+    std::vector<std::uint64_t> block(BlockSize / sizeof(std::uint64_t));
+
+    auto const blocks = megabytes * 1024 * 1024 / BlockSize /
+                        (sizeof(Archives) / sizeof(Archives[0]));
+
+    for (auto const name : Archives)
+    {
+        auto const file = data / name;
+        fs::create_directories(file.parent_path());
+
+        std::ofstream fd(file, std::ios::binary | std::ios::trunc);
+
+        // random, so that no layer beneath can store it compressed
+        for (auto i = 0u; i < blocks; ++i)
+        {
+            for (auto& word : block)
+                word = random();
+
+            fd.write(reinterpret_cast<const char*>(block.data()), BlockSize);
+        }
+
+        if (!fd)
+            throw std::runtime_error("Failed to write " + file.string());
+    }
+}
+
+// the client reads blocks scattered through each archive, not the archives
+// from start to end.  returns how long it took.
+Clock::duration ReadAsClient(const fs::path& data)
+{
+    std::mt19937 random(2);
+    std::vector<char> buffer(BlockSize);
+
+    auto const start = Clock::now();
+
+    for (auto const name : Archives)
+    {
+        std::ifstream fd(data / name, std::ios::binary);
+
+        std::vector<std::size_t> order(fs::file_size(data / name) / BlockSize);
+
+        for (auto i = 0u; i < order.size(); ++i)
+            order[i] = i;
+
+        std::shuffle(order.begin(), order.end(), random);
+
+        for (auto const block : order)
+        {
+            fd.seekg(static_cast<std::streamoff>(block * BlockSize));
+            fd.read(buffer.data(), BlockSize);
+        }
+
+        if (!fd)
+            throw std::runtime_error(std::string("Failed to read ") + name);
+    }
+
+    return Clock::now() - start;
+}
+
+double Milliseconds(Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    auto const dir = fs::temp_directory_path() / "wowreeb-prefetch-benchmark";
+
+    try
+    {
+        auto const megabytes = argc > 1 ? std::stoul(argv[1]) : 512ul;
+        auto const headStart =
+            std::chrono::milliseconds(argc > 2 ? std::stoul(argv[2]) : 500ul);
+
+        if (!megabytes)
+            throw std::runtime_error("At least one megabyte is required");
+
+        auto const data = dir / "Data";
+
+        fs::remove_all(dir);
+        WriteArchives(data, megabytes);
+
+        auto const evict = [&data]()
+        {
+            for (auto const name : Archives)
+                Evict(data / name);
+        };
+
+        evict();
+        auto const cold = ReadAsClient(data);
+
+        // the launch is requested, and the client starts reading once the
+        // rest of the launch is done
+        evict();
+
+        std::promise<std::uint64_t> prefetched;
+        auto const start = Clock::now();
+
+        PrefetchClientData(dir, [&prefetched](std::uint64_t bytes)
+                           { prefetched.set_value(bytes); });
+
+        std::this_thread::sleep_for(headStart);
+
+        auto const warm = ReadAsClient(data);
+        auto const total = Clock::now() - start;
+
+        auto const bytes = prefetched.get_future().get();
+        auto const prefetchTime = Clock::now() - start;
+
+        evict();
+        auto const coldAgain = ReadAsClient(data);
+
+        std::cout << "archives:                 " << megabytes << "MB\n"
+                  << "head start:               " << headStart.count()
+                  << "ms\n"
+                  << "cold read:                " << Milliseconds(cold)
+                  << "ms, " << Milliseconds(coldAgain) << "ms again\n"
+                  << "read after head start:    " << Milliseconds(warm)
+                  << "ms\n"
+                  << "request to data read:     "
+                  << Milliseconds(headStart + (cold + coldAgain) / 2)
+                  << "ms cold, " << Milliseconds(total)
+                  << "ms prefetched\n"
+                  << "prefetched:               " << bytes / (1024 * 1024)
+                  << "MB in at most " << Milliseconds(prefetchTime)
+                  << "ms\n";
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "prefetch_benchmark: " << e.what() << std::endl;
+        fs::remove_all(dir);
+        return EXIT_FAILURE;
+    }
+
+    fs::remove_all(dir);
+
+    return EXIT_SUCCESS;
+}
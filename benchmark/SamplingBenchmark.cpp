@@ -0,0 +1,164 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// measures the processor time the supervisor spends sampling running clients,
+// with the fake backend standing in for the clients.  the fake samples cost
+// nothing, so this is the supervisor's own share, to which the system calls of
+// a real sample are added.
+//
+// usage: sampling_benchmark [clients] [seconds] [milliseconds between samples]
+
+#include "FakeBackend.hpp"
+#include "Supervisor.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Supervisor.cpp opens the clients through this
+ProcessBackend& GetProcessBackend()
+{
+    static FakeBackend backend;
+    return backend;
+}
+
+namespace
+{
+// user and kernel time used by every thread of this process
+std::chrono::microseconds ProcessorTime()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    ::GetProcessTimes(::GetCurrentProcess(), &creation, &exit, &kernel, &user);
+
+    auto const ticks = [](const FILETIME& time)
+    {
+        return (static_cast<unsigned long long>(time.dwHighDateTime) << 32) |
+               time.dwLowDateTime;
+    };
+
+    return std::chrono::microseconds((ticks(kernel) + ticks(user)) / 10);
+#else
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+
+    auto const micros = [](const timeval& time)
+    { return time.tv_sec * 1000000ll + time.tv_usec; };
+
+    return std::chrono::microseconds(micros(usage.ru_utime) +
+                                     micros(usage.ru_stime));
+#endif
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        auto const count = argc > 1 ? std::stoul(argv[1]) : 16ul;
+        auto const duration =
+            std::chrono::seconds(argc > 2 ? std::stoul(argv[2]) : 10ul);
+        auto const interval =
+            std::chrono::milliseconds(argc > 3 ? std::stoul(argv[3]) : 2000ul);
+
+        if (!count || !duration.count())
+            throw std::runtime_error("At least one client and second required");
+
+        auto& backend = static_cast<FakeBackend&>(GetProcessBackend());
+
+        ConfigureSupervisor(interval);
+
+        std::vector<std::unique_ptr<ClientProcess>> clients;
+
+        for (auto i = 0ul; i < count; ++i)
+        {
+            clients.push_back(
+                backend.CreateSuspended("Wow.exe", {}, "wowreeb.dll"));
+            clients.back()->Resume();
+
+            Supervise("Realm", clients.back()->GetId(), RestartPolicy {}, {});
+        }
+
+        // this thread only sleeps, and the stand-ins wait for requests, so
+        // nearly all the time used meanwhile is the sampling thread's
+        auto const start = std::chrono::steady_clock::now();
+        auto const before = ProcessorTime();
+
+        std::this_thread::sleep_for(duration);
+
+        auto const used = ProcessorTime() - before;
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+
+        auto const samples =
+            count * (std::chrono::duration<double>(elapsed) / interval);
+        auto const share =
+            100.0 * std::chrono::duration<double>(used).count() /
+            std::chrono::duration<double>(elapsed).count();
+
+        auto sampled = false;
+
+        for (auto const& stats : GetClientStats("Realm"))
+            sampled |= stats.WorkingSet != 0;
+
+        std::cout << "clients:            " << count << "\n"
+                  << "sample interval:    " << interval.count() << "ms\n"
+                  << "samples:            " << samples << "\n"
+                  << "processor time:     " << used.count() << "us\n"
+                  << "share of one core:  " << share << "%\n";
+
+        if (samples >= 1.0)
+            std::cout << "time per sample:    " << used.count() / samples
+                      << "us\n";
+
+        // the sampling thread exits once it sees every client has
+        for (auto const& client : clients)
+            client->Terminate();
+
+        while (!GetClientStats("Realm").empty())
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        if (samples >= count && !sampled)
+            throw std::runtime_error("No client was sampled");
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "sampling_benchmark: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
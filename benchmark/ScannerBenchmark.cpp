@@ -0,0 +1,211 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+// checks that each kernel the scanner may search with finds exactly what a
+// naive search does for random patterns, then measures how quickly each
+// searches a buffer of random bytes.  it fails if any kernel disagrees.
+//
+// usage: scanner_benchmark [megabytes] [patterns]
+
+#include "Scanner.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct NamedKernel
+{
+    ScanKernel Kernel;
+    const char* Name;
+};
+
+const NamedKernel Kernels[] = {
+    {ScanKernel::Scalar, "scalar"},
+    {ScanKernel::Sse2, "sse2"},
+    {ScanKernel::Avx2, "avx2"},
+};
+
+std::size_t FindNaive(const std::uint8_t* data, std::size_t length,
+                      const Pattern& pattern, const std::uint8_t** match,
+                      std::size_t limit)
+{
+    std::size_t found = 0;
+
+    for (std::size_t i = 0; i + pattern.Bytes.size() <= length; ++i)
+    {
+        if (!MatchPattern(data + i, pattern))
+            continue;
+
+        if (!found++)
+            *match = data + i;
+
+        if (found >= limit)
+            break;
+    }
+
+    return found;
+}
+
+// the bytes at data in the pattern syntax, with some left as ??
+std::string MakePattern(const std::uint8_t* data, std::size_t length,
+                        std::mt19937& random)
+{
+    std::stringstream str;
+    str << std::hex << std::setfill('0');
+
+    // the last byte is always given, so that the pattern is valid
+    for (auto i = 0u; i < length; ++i)
+    {
+        if (i + 1 < length && random() % 4 == 0)
+            str << "?? ";
+        else
+            str << std::setw(2) << static_cast<unsigned int>(data[i]) << ' ';
+    }
+
+    return str.str();
+}
+
+// search from every offset into a short buffer of few distinct bytes, so that
+// there are many candidates, matches and remainders of every length
+void Verify(std::size_t patterns, std::mt19937& random)
+{
+    std::vector<std::uint8_t> buffer(4096);
+
+    for (auto& byte : buffer)
+        byte = static_cast<std::uint8_t>(random() % 4);
+
+    for (auto n = 0u; n < patterns; ++n)
+    {
+        auto const length = 1 + random() % 12;
+        auto const text = MakePattern(
+            buffer.data() + random() % (buffer.size() - length), length,
+            random);
+
+        Pattern pattern;
+
+        if (!ParsePattern(text.c_str(), pattern))
+            throw std::runtime_error("Failed to parse pattern " + text);
+
+        auto const offset = random() % 64;
+        auto const size = random() % (buffer.size() - offset);
+        auto const limit = 1 + random() % 3;
+
+        const std::uint8_t* expectedMatch = nullptr;
+        auto const expected = FindNaive(buffer.data() + offset, size, pattern,
+                                        &expectedMatch, limit);
+
+        for (auto const& kernel : Kernels)
+        {
+            if (!SupportsKernel(kernel.Kernel))
+                continue;
+
+            const std::uint8_t* match = nullptr;
+            auto const found =
+                FindPatternWith(kernel.Kernel, buffer.data() + offset, size,
+                                pattern, &match, limit);
+
+            if (found != expected || (found && match != expectedMatch))
+                throw std::runtime_error(std::string(kernel.Name) +
+                                         " disagrees on pattern " + text);
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        auto const megabytes = argc > 1 ? std::stoul(argv[1]) : 256ul;
+        auto const patterns = argc > 2 ? std::stoul(argv[2]) : 10000ul;
+
+        if (!megabytes)
+            throw std::runtime_error("The buffer must not be empty");
+
+        std::mt19937 random(12345);
+
+        Verify(patterns, random);
+
+        std::cout << patterns << " random patterns found alike by each "
+                  << "kernel\n";
+
+        std::vector<std::uint8_t> buffer(megabytes * 1024 * 1024);
+
+        for (auto& byte : buffer)
+            byte = static_cast<std::uint8_t>(random());
+
+        // a signature found only at the end, so that all of the buffer is
+        // searched
+        auto const text =
+            MakePattern(buffer.data() + buffer.size() - 16, 16, random);
+
+        Pattern pattern;
+        ParsePattern(text.c_str(), pattern);
+
+        std::cout << megabytes << " MiB of random bytes\n";
+
+        for (auto const& kernel : Kernels)
+        {
+            if (!SupportsKernel(kernel.Kernel))
+            {
+                std::cout << "  " << kernel.Name << ": not supported\n";
+                continue;
+            }
+
+            const std::uint8_t* match = nullptr;
+
+            auto const start = std::chrono::steady_clock::now();
+            auto const found = FindPatternWith(
+                kernel.Kernel, buffer.data(), buffer.size(), pattern, &match);
+            auto const elapsed = std::chrono::duration<double>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count();
+
+            if (found != 1 || match != buffer.data() + buffer.size() - 16)
+                throw std::runtime_error(std::string(kernel.Name) +
+                                         " did not find the signature");
+
+            std::cout << "  " << kernel.Name << ": "
+                      << buffer.size() / elapsed / 1e9 << " GB/s\n";
+        }
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "scanner_benchmark: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
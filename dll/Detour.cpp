@@ -0,0 +1,276 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Detour.hpp"
+
+#include <Windows.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+// jmp rel32
+constexpr std::size_t JumpLength = 5;
+
+// jmp [rip+0] followed by the destination
+constexpr std::size_t RelayLength = 14;
+
+// the length of a modrm operand, including any sib byte and displacement, or
+// zero if it is relative to the instruction pointer and so cannot be moved
+std::size_t ModRMLength(const std::uint8_t* modrm)
+{
+    auto const mod = modrm[0] >> 6;
+    auto const rm = modrm[0] & 7;
+
+    if (mod == 3)
+        return 1;
+
+    std::size_t length = 1;
+
+    if (rm == 4)
+    {
+        ++length;
+
+        // no base register, only a displacement
+        if (mod == 0 && (modrm[1] & 7) == 5)
+            length += 4;
+    }
+    else if (mod == 0 && rm == 5)
+    {
+#ifdef _WIN64
+        return 0;
+#else
+        length += 4;
+#endif
+    }
+
+    if (mod == 1)
+        length += 1;
+    else if (mod == 2)
+        length += 4;
+
+    return length;
+}
+
+// the length of an instruction which may be moved elsewhere unchanged, or zero
+// if it is one we do not know, or depends on where it is
+std::size_t InstructionLength(const std::uint8_t* code)
+{
+    std::size_t prefix = 0;
+
+    // fs and gs segment overrides, as used to reach the thread information
+    if (code[0] == 0x64 || code[0] == 0x65)
+        ++prefix;
+
+    auto wide = false;
+
+#ifdef _WIN64
+    if ((code[prefix] & 0xf0) == 0x40)
+    {
+        wide = !!(code[prefix] & 8);
+        ++prefix;
+    }
+#endif
+
+    auto const opcode = code[prefix];
+    auto const operands = code + prefix + 1;
+
+    // mov, xor, test, add, sub, cmp and lea between registers and memory
+    static constexpr std::uint8_t modrmOpcodes[] = {
+        0x01, 0x03, 0x29, 0x2b, 0x31, 0x33, 0x39, 0x3b, 0x85, 0x89, 0x8b, 0x8d};
+
+    std::size_t length = 0;
+
+    // push and pop of a register, and nop
+    if ((opcode >= 0x50 && opcode <= 0x5f) || opcode == 0x90)
+        length = 1;
+#ifndef _WIN64
+    // inc and dec of a register, which are rex prefixes in 64 bit code
+    else if (opcode >= 0x40 && opcode <= 0x4f)
+        length = 1;
+#endif
+    // push imm8
+    else if (opcode == 0x6a)
+        length = 2;
+    // push imm32
+    else if (opcode == 0x68)
+        length = 5;
+    // mov eax, [address]
+    else if (opcode == 0xa1)
+        length = 1 + sizeof(void*);
+    // mov register, immediate
+    else if (opcode >= 0xb8 && opcode <= 0xbf)
+        length = wide ? 9 : 5;
+    else
+    {
+        std::size_t immediate;
+
+        if (std::find(std::begin(modrmOpcodes), std::end(modrmOpcodes),
+                      opcode) != std::end(modrmOpcodes))
+            immediate = 0;
+        // arithmetic with an immediate byte, such as sub esp, imm8
+        else if (opcode == 0x83)
+            immediate = 1;
+        // as above with an immediate dword, and mov r/m, imm32
+        else if (opcode == 0x81 || opcode == 0xc7)
+            immediate = 4;
+        else
+            return 0;
+
+        auto const modrm = ModRMLength(operands);
+
+        if (modrm)
+            length = 1 + modrm + immediate;
+    }
+
+    return length ? prefix + length : 0;
+}
+
+// somewhere for the trampoline which the target can reach with a jmp rel32
+std::uint8_t* AllocateNear(const std::uint8_t* target, std::size_t size)
+{
+#ifdef _WIN64
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+
+    auto const granularity =
+        static_cast<std::uintptr_t>(info.dwAllocationGranularity);
+    auto const start =
+        reinterpret_cast<std::uintptr_t>(target) & ~(granularity - 1);
+    auto const range = static_cast<std::uintptr_t>(0x7fff0000);
+    auto const lowest = start > range ? start - range : granularity;
+
+    // search downwards from the target, where there is usually free space below
+    // the executable
+    for (auto address = start - granularity; address >= lowest;
+         address -= granularity)
+    {
+        auto const memory =
+            ::VirtualAlloc(reinterpret_cast<void*>(address), size,
+                           MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+
+        if (memory)
+            return static_cast<std::uint8_t*>(memory);
+    }
+
+    return nullptr;
+#else
+    // every address can be reached
+    return static_cast<std::uint8_t*>(::VirtualAlloc(
+        nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+#endif
+}
+
+// write a jump which is to be executed at the given address into the buffer
+void WriteJump(std::uint8_t* buffer, const std::uint8_t* from,
+               const std::uint8_t* to)
+{
+    auto const displacement =
+        static_cast<std::int32_t>(to - (from + JumpLength));
+
+    buffer[0] = 0xe9;
+    ::memcpy(buffer + 1, &displacement, sizeof(displacement));
+}
+} // namespace
+
+Detour::Detour() : _target(nullptr), _trampoline(nullptr), _length(0)
+{
+}
+
+bool Detour::Apply(void* target, void* hook)
+{
+    _target = static_cast<std::uint8_t*>(target);
+    _length = 0;
+
+    // take whole instructions until there is room for the jump
+    while (_length < JumpLength)
+    {
+        auto const length = InstructionLength(_target + _length);
+
+        if (!length || _length + length > MaxPrologue)
+            return false;
+
+        _length += length;
+    }
+
+    // the moved instructions, then a jump back to those which follow them.  in
+    // 64 bit code the hook may be too far away to jump to directly, so the
+    // target jumps to a relay which follows the trampoline.
+    _trampoline = AllocateNear(_target, MaxPrologue + JumpLength + RelayLength);
+
+    if (!_trampoline)
+        return false;
+
+    ::memcpy(_original, _target, _length);
+    ::memcpy(_trampoline, _target, _length);
+    WriteJump(_trampoline + _length, _trampoline + _length, _target + _length);
+
+#ifdef _WIN64
+    auto const relay = _trampoline + _length + JumpLength;
+
+    static constexpr std::uint8_t jumpIndirect[] = {0xff, 0x25, 0, 0, 0, 0};
+    ::memcpy(relay, jumpIndirect, sizeof(jumpIndirect));
+    ::memcpy(relay + sizeof(jumpIndirect), &hook, sizeof(hook));
+#else
+    auto const relay = static_cast<std::uint8_t*>(hook);
+#endif
+
+    std::uint8_t patch[MaxPrologue];
+
+    // the rest of the last instruction replaced is never executed
+    ::memset(patch, 0x90, _length);
+    WriteJump(patch, _target, relay);
+
+    ::FlushInstructionCache(::GetCurrentProcess(), _trampoline,
+                            MaxPrologue + JumpLength + RelayLength);
+
+    return PatchMemory(_target, patch, _length);
+}
+
+void Detour::Remove()
+{
+    if (_target && _length)
+        PatchMemory(_target, _original, _length);
+
+    _length = 0;
+}
+
+bool PatchMemory(void* address, const void* data, std::size_t length)
+{
+    DWORD protection;
+
+    if (!::VirtualProtect(address, length, PAGE_EXECUTE_READWRITE, &protection))
+        return false;
+
+    ::memcpy(address, data, length);
+
+    ::VirtualProtect(address, length, protection, &protection);
+    ::FlushInstructionCache(::GetCurrentProcess(), address, length);
+
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// routes calls to a function through a hook by replacing the start of the
+// function with a jump.  the instructions replaced are moved to a trampoline,
+// through which the hook may call the original function.  only the handful of
+// instructions found at the start of the functions we hook are understood.
+class Detour
+{
+private:
+    static constexpr std::size_t MaxPrologue = 32;
+
+    std::uint8_t* _target;
+    std::uint8_t* _trampoline;
+
+    // the bytes of the target which were replaced
+    std::size_t _length;
+    std::uint8_t _original[MaxPrologue];
+
+public:
+    Detour();
+
+    Detour(const Detour&) = delete;
+    Detour& operator=(const Detour&) = delete;
+
+    // returns false if the start of the target is not code we know how to move
+    bool Apply(void* target, void* hook);
+
+    // the trampoline remains, as the hook may still be running when this is
+    // called
+    void Remove();
+
+    template <typename T> T Trampoline() const
+    {
+        return reinterpret_cast<T>(_trampoline);
+    }
+};
+
+// overwrite memory regardless of its protection
+bool PatchMemory(void* address, const void* data, std::size_t length);
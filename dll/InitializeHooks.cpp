@@ -23,421 +23,261 @@
 
 */
 
-#pragma comment(lib, "asmjit.lib")
-#pragma comment(lib, "udis86.lib")
-
 #include "InitializeHooks.hpp"
 
+#include "Detour.hpp"
+#include "Signatures.hpp"
+
+#include <Windows.h>
+#include <cstddef>
 #include <cstdint>
-#include <hadesmem/patcher.hpp>
+#include <cstring>
 
 namespace
 {
+class CVar
+{
+};
+
 enum class Version
 {
-    Classic = 0,
+    Classic,
     TBC,
     WotLK,
     Cata32,
     Cata64,
-    Total
 };
 
-enum class Offset
-{
-    CVar__Set = 0,
-    RealmListCVar,
-    Idle,
-    CGlueMgr__m_pendingServerAlert,
-    Login,
-    FoV,
-    Total
-};
+// everything the hooks depend on which differs between client builds.  to
+// support another build, specialize this and list it in ApplyClientInitHook.
+template <Version> struct BuildTraits;
 
-PVOID GetAddress(Version version, Offset offset)
+template <> struct BuildTraits<Version::Classic>
 {
-    static constexpr std::uint32_t offsets[static_cast<int>(
-        Version::Total)][static_cast<int>(Offset::Total)] = {
-        // clang-format off
-        // Classic
-        {
-            0x23DF50,
-            0x82812C,
-            0x6B930,
-            0x741E28,
-            0x6AFB0,
-            0x4089B4
-        },
-        // TBC
-        {
-            0x23F6C0,
-            0x943330,
-            0x70160,
-            0x807DB8,
-            0x6E560,
-            0x4B5A04
-        },
-        // WotLK
-        {
-            0x3668C0,
-            0x879D00,
-            0xDAB40,
-            0x76AF88,
-            0xD8A30,
-            0x5E8D88
-        },
-        // Cata32
-        {
-            0x2553B0,
-            0x9BE800,
-            0x405310,
-            0xABBF04,
-            0x400240,
-            0x00,   // not supported.  let me know if anyone actually wants this
-        },
-        // Cata64
-        {
-            0x2F61D0,
-            0xCA4328,
-            0x51A7C0,
-            0xDACCA8,
-            0x514100,
-            0x00,   // not supported.  let me know if anyone actually wants this
-        }
-        // clang-format on
-    };
-
-    auto const baseAddress =
-        reinterpret_cast<std::uint8_t*>(::GetModuleHandle(nullptr));
+    static constexpr unsigned int Build = 5875;
+    static constexpr std::size_t PointerSize = 4;
+    static constexpr bool SupportsFoV = true;
 
-    return baseAddress +
-           offsets[static_cast<int>(version)][static_cast<int>(offset)];
-}
-} // namespace
+    // indexed by SignatureTarget
+    static constexpr std::uint32_t Offsets[SignatureTargetCount] = {
+        0x23DF50, 0x82812C, 0x6B930, 0x741E28, 0x6AFB0, 0x4089B4};
 
-namespace Classic
-{
-class CVar
-{
+    using SetT = bool (__thiscall CVar::*)(const char*, char, char, char, char);
+    using IdleT = int(__cdecl*)();
+    using LoginT = void(__fastcall*)(char*, char*);
 };
 
-using SetT = bool (__thiscall CVar::*)(const char*, char, char, char, char);
-using IdleT = int(__cdecl*)();
-using LoginT = void(__fastcall*)(char*, char*);
-
-int IdleHook(hadesmem::PatchDetourBase* detour, GameSettings* settings)
+template <> struct BuildTraits<Version::TBC>
 {
-    auto const idle = detour->GetTrampolineT<IdleT>();
-    auto const ret = idle();
+    static constexpr unsigned int Build = 8606;
+    static constexpr std::size_t PointerSize = 4;
+    static constexpr bool SupportsFoV = true;
 
-    // if we are no longer waiting for the server alert, proceed with
-    // configuration
-    if (!*reinterpret_cast<std::uint32_t*>(
-            GetAddress(Version::Classic, Offset::CGlueMgr__m_pendingServerAlert)))
-    {
-        auto const cvar = *reinterpret_cast<CVar**>(
-            GetAddress(Version::Classic, Offset::RealmListCVar));
-        auto const set = hadesmem::detail::AliasCast<SetT>(
-            GetAddress(Version::Classic, Offset::CVar__Set));
+    static constexpr std::uint32_t Offsets[SignatureTargetCount] = {
+        0x23F6C0, 0x943330, 0x70160, 0x807DB8, 0x6E560, 0x4B5A04};
 
-        (cvar->*set)(settings->AuthServer, 1, 0, 1, 0);
-
-        detour->Remove();
+    using SetT = bool (__thiscall CVar::*)(const char*, char, char, char, char);
+    using IdleT = int(__cdecl*)();
+    using LoginT = void(__cdecl*)(char*, char*);
+};
 
-        if (settings->CredentialsSet)
-        {
-            auto const login = hadesmem::detail::AliasCast<LoginT>(
-                GetAddress(Version::Classic, Offset::Login));
-            login(settings->Username, settings->Password);
-        }
+template <> struct BuildTraits<Version::WotLK>
+{
+    static constexpr unsigned int Build = 12340;
+    static constexpr std::size_t PointerSize = 4;
+    static constexpr bool SupportsFoV = true;
 
-        settings->LoadComplete = true;
-    }
+    static constexpr std::uint32_t Offsets[SignatureTargetCount] = {
+        0x3668C0, 0x879D00, 0xDAB40, 0x76AF88, 0xD8A30, 0x5E8D88};
 
-    return ret;
-}
+    using SetT = bool (__thiscall CVar::*)(const char*, char, char, char, char);
+    using IdleT = int(__cdecl*)();
+    using LoginT = void(__cdecl*)(char*, char*);
+};
 
-void ApplyClientInitHook(GameSettings* settings)
+// FoV is not supported for cataclysm.  let me know if anyone actually wants
+// this.
+template <> struct BuildTraits<Version::Cata32>
 {
-    // just to make sure the value is initialized
-    *reinterpret_cast<std::uint32_t*>(
-        GetAddress(Version::Classic, Offset::CGlueMgr__m_pendingServerAlert)) = 1;
+    static constexpr unsigned int Build = 15595;
+    static constexpr std::size_t PointerSize = 4;
+    static constexpr bool SupportsFoV = false;
 
-    auto const proc = hadesmem::Process(::GetCurrentProcessId());
-    auto const idleOrig = hadesmem::detail::AliasCast<IdleT>(
-        GetAddress(Version::Classic, Offset::Idle));
-    auto idleDetour = new hadesmem::PatchDetour<IdleT>(
-        proc, idleOrig,
-        [settings](hadesmem::PatchDetourBase* detour)
-        { return IdleHook(detour, settings); });
+    static constexpr std::uint32_t Offsets[SignatureTargetCount] = {
+        0x2553B0, 0x9BE800, 0x405310, 0xABBF04, 0x400240, 0x00};
 
-    idleDetour->Apply();
-
-    if (settings->FoVSet)
-    {
-        auto const pFov = GetAddress(Version::Classic, Offset::FoV);
-        std::vector<std::uint8_t> patchData(sizeof(settings->FoV));
-        memcpy(&patchData[0], &settings->FoV, sizeof(settings->FoV));
-        auto patch = new hadesmem::PatchRaw(proc, pFov, patchData);
-        patch->Apply();
-    }
-}
-} // namespace Classic
-
-namespace TBC
-{
-class CVar
-{
+    using SetT = bool (__thiscall CVar::*)(const char*, char, char, char, char);
+    using IdleT = int(__cdecl*)();
+    using LoginT = void(__cdecl*)(char*, char*);
 };
 
-using SetT = bool (__thiscall CVar::*)(const char*, char, char, char, char);
-using IdleT = int(__cdecl*)();
-using LoginT = void(__cdecl*)(char*, char*);
-
-int IdleHook(hadesmem::PatchDetourBase* detour, GameSettings* settings)
+template <> struct BuildTraits<Version::Cata64>
 {
-    auto const idle = detour->GetTrampolineT<IdleT>();
-    auto const ret = idle();
+    static constexpr unsigned int Build = 15595;
+    static constexpr std::size_t PointerSize = 8;
+    static constexpr bool SupportsFoV = false;
 
-    // if we are no longer waiting for the server alert, proceed with
-    // configuration
-    if (!*reinterpret_cast<std::uint32_t*>(
-            GetAddress(Version::TBC, Offset::CGlueMgr__m_pendingServerAlert)))
-    {
-        auto const cvar = *reinterpret_cast<CVar**>(
-            GetAddress(Version::TBC, Offset::RealmListCVar));
-        auto const set = hadesmem::detail::AliasCast<SetT>(
-            GetAddress(Version::TBC, Offset::CVar__Set));
+    static constexpr std::uint32_t Offsets[SignatureTargetCount] = {
+        0x2F61D0, 0xCA4328, 0x51A7C0, 0xDACCA8, 0x514100, 0x00};
 
-        (cvar->*set)(settings->AuthServer, 1, 0, 1, 0);
+    using SetT = bool (__fastcall CVar::*)(const char*, char, char, char, char);
+    using IdleT = int(__stdcall*)();
+    using LoginT = void(__fastcall*)(char*, char*);
+};
 
-        detour->Remove();
+// the addresses used by the hooks, resolved once as they are installed so
+// that the idle hook does not look them up every frame
+template <typename Traits> struct Addresses
+{
+    typename Traits::SetT CVarSet;
+    CVar** RealmListCVar;
+    typename Traits::IdleT Idle;
+    std::uint32_t* PendingServerAlert;
+    typename Traits::LoginT Login;
+    void* FoV;
+};
 
-        if (settings->CredentialsSet)
-        {
-            auto const login = hadesmem::detail::AliasCast<LoginT>(
-                GetAddress(Version::TBC, Offset::Login));
-            login(settings->Username, settings->Password);
-        }
+// a pointer to a function, or to a member function, at the given address
+template <typename T> T AddressAs(PVOID address)
+{
+    static_assert(sizeof(T) >= sizeof(address), "Unexpected pointer size");
 
-        settings->LoadComplete = true;
-    }
+    T result;
+    ::memset(&result, 0, sizeof(result));
+    ::memcpy(&result, &address, sizeof(address));
 
-    return ret;
+    return result;
 }
 
-void ApplyClientInitHook(GameSettings* settings)
+// start with the offsets we know for the build, replacing any which the
+// signatures in the settings find to be elsewhere in this client
+template <typename Traits>
+bool ResolveAddresses(const GameSettings* settings,
+                      Addresses<Traits>& addresses)
 {
-    // just to make sure the value is initialized
-    *reinterpret_cast<std::uint32_t*>(
-        GetAddress(Version::TBC, Offset::CGlueMgr__m_pendingServerAlert)) = 1;
+    std::uint32_t offsets[SignatureTargetCount];
+    ::memcpy(offsets, Traits::Offsets, sizeof(offsets));
 
-    auto const proc = hadesmem::Process(::GetCurrentProcessId());
-    auto const idleOrig = hadesmem::detail::AliasCast<IdleT>(
-        GetAddress(Version::TBC, Offset::Idle));
-    auto idleDetour = new hadesmem::PatchDetour<IdleT>(
-        proc, idleOrig,
-        [settings](hadesmem::PatchDetourBase* detour)
-        { return IdleHook(detour, settings); });
+    if (!ResolveSignatures(settings, offsets))
+        return false;
 
-    idleDetour->Apply();
+    auto const baseAddress =
+        reinterpret_cast<std::uint8_t*>(::GetModuleHandle(nullptr));
 
-    if (settings->FoVSet)
-    {
-        auto const pFov = GetAddress(Version::TBC, Offset::FoV);
-        std::vector<std::uint8_t> patchData(sizeof(settings->FoV));
-        memcpy(&patchData[0], &settings->FoV, sizeof(settings->FoV));
-        auto patch = new hadesmem::PatchRaw(proc, pFov, patchData);
-        patch->Apply();
-    }
+    auto const address = [baseAddress, &offsets](SignatureTarget target)
+    { return static_cast<PVOID>(baseAddress + offsets[target]); };
+
+    addresses.CVarSet =
+        AddressAs<typename Traits::SetT>(address(SignatureCVarSet));
+    addresses.RealmListCVar =
+        static_cast<CVar**>(address(SignatureRealmListCVar));
+    addresses.Idle = AddressAs<typename Traits::IdleT>(address(SignatureIdle));
+    addresses.PendingServerAlert =
+        static_cast<std::uint32_t*>(address(SignaturePendingServerAlert));
+    addresses.Login =
+        AddressAs<typename Traits::LoginT>(address(SignatureLogin));
+    addresses.FoV = offsets[SignatureFoV] ? address(SignatureFoV) : nullptr;
+
+    return true;
 }
-} // namespace TBC
 
-namespace WOTLK
-{
-class CVar
+// the hook is a plain function, so what it needs is kept here.  there is one
+// of these for each build.
+template <typename Traits> struct IdleHookState
 {
+    static inline GameSettings* Settings;
+    static inline Addresses<Traits> Resolved;
+    static inline Detour Idle;
 };
 
-using SetT = bool (__thiscall CVar::*)(const char*, char, char, char, char);
-using IdleT = int(__cdecl*)();
-using LoginT = void(__cdecl*)(char*, char*);
-
-int IdleHook(hadesmem::PatchDetourBase* detour, GameSettings* settings)
+// the idle functions take no arguments, so the hook need not share their
+// calling convention
+template <typename Traits> int IdleHook()
 {
-    auto const idle = detour->GetTrampolineT<IdleT>();
+    using State = IdleHookState<Traits>;
+
+    auto const settings = State::Settings;
+    auto const& addresses = State::Resolved;
+
+    auto const idle = State::Idle.template Trampoline<typename Traits::IdleT>();
     auto const ret = idle();
 
     // if we are no longer waiting for the server alert, proceed with
     // configuration
-    if (!*reinterpret_cast<std::uint32_t*>(
-            GetAddress(Version::WotLK, Offset::CGlueMgr__m_pendingServerAlert)))
+    if (!*addresses.PendingServerAlert)
     {
-        auto const cvar = *reinterpret_cast<CVar**>(
-            GetAddress(Version::WotLK, Offset::RealmListCVar));
-        auto const set = hadesmem::detail::AliasCast<SetT>(
-            GetAddress(Version::WotLK, Offset::CVar__Set));
+        auto const cvar = *addresses.RealmListCVar;
 
-        (cvar->*set)(settings->AuthServer, 1, 0, 1, 0);
+        (cvar->*addresses.CVarSet)(
+            GetSettingsString(settings, settings->AuthServer), 1, 0, 1, 0);
+        ::InterlockedOr(&settings->Milestones, MilestoneAuthServerSet);
 
-        detour->Remove();
+        State::Idle.Remove();
 
         if (settings->CredentialsSet)
         {
-            auto const login = hadesmem::detail::AliasCast<LoginT>(
-                GetAddress(Version::WotLK, Offset::Login));
-            login(settings->Username, settings->Password);
+            addresses.Login(GetSettingsString(settings, settings->Username),
+                            GetSettingsString(settings, settings->Password));
+            ::InterlockedOr(&settings->Milestones, MilestoneLoginSent);
         }
 
-        settings->LoadComplete = true;
+        ::InterlockedOr(&settings->Milestones, MilestoneLoadComplete);
     }
 
     return ret;
 }
 
-void ApplyClientInitHook(GameSettings* settings)
+template <typename Traits> bool ApplyHooks(GameSettings* settings)
 {
-    // just to make sure the value is initialized
-    *reinterpret_cast<std::uint32_t*>(
-        GetAddress(Version::WotLK, Offset::CGlueMgr__m_pendingServerAlert)) = 1;
+    using State = IdleHookState<Traits>;
 
-    auto const proc = hadesmem::Process(::GetCurrentProcessId());
-    auto const idleOrig = hadesmem::detail::AliasCast<IdleT>(
-        GetAddress(Version::WotLK, Offset::Idle));
-    auto idleDetour = new hadesmem::PatchDetour<IdleT>(
-        proc, idleOrig,
-        [settings](hadesmem::PatchDetourBase* detour)
-        { return IdleHook(detour, settings); });
+    if (!ResolveAddresses(settings, State::Resolved))
+        return false;
 
-    idleDetour->Apply();
+    State::Settings = settings;
 
-    if (settings->FoVSet)
+    // just to make sure the value is initialized
+    *State::Resolved.PendingServerAlert = 1;
+
+    if constexpr (Traits::SupportsFoV)
     {
-        auto const pFov = GetAddress(Version::WotLK, Offset::FoV);
-        std::vector<std::uint8_t> patchData(sizeof(settings->FoV));
-        memcpy(&patchData[0], &settings->FoV, sizeof(settings->FoV));
-        auto patch = new hadesmem::PatchRaw(proc, pFov, patchData);
-        patch->Apply();
+        if (settings->FoVSet &&
+            !PatchMemory(State::Resolved.FoV, &settings->FoV,
+                         sizeof(settings->FoV)))
+            return false;
     }
-}
-} // namespace WOTLK
 
-namespace Cata32
-{
-class CVar
-{
-};
-
-using SetT = bool (__thiscall CVar::*)(const char*, char, char, char, char);
-using IdleT = int(__cdecl*)();
-using LoginT = void(__cdecl*)(char*, char*);
-
-int IdleHook(hadesmem::PatchDetourBase* detour, GameSettings* settings)
-{
-    auto const idle = detour->GetTrampolineT<IdleT>();
-    auto const ret = idle();
-
-    // if we are no longer waiting for the server alert, proceed with
-    // configuration
-    if (!*reinterpret_cast<std::uint32_t*>(
-            GetAddress(Version::Cata32, Offset::CGlueMgr__m_pendingServerAlert)))
+    if (!State::Idle.Apply(reinterpret_cast<PVOID>(State::Resolved.Idle),
+                           reinterpret_cast<PVOID>(&IdleHook<Traits>)))
     {
-        auto const cvar = *reinterpret_cast<CVar**>(
-            GetAddress(Version::Cata32, Offset::RealmListCVar));
-        auto const set = hadesmem::detail::AliasCast<SetT>(
-            GetAddress(Version::Cata32, Offset::CVar__Set));
-
-        (cvar->*set)(settings->AuthServer, 1, 0, 1, 0);
-
-        detour->Remove();
-
-        if (settings->CredentialsSet)
-        {
-            auto const login = hadesmem::detail::AliasCast<LoginT>(
-                GetAddress(Version::Cata32, Offset::Login));
-            login(settings->Username, settings->Password);
-        }
-
-        settings->LoadComplete = true;
+        ::OutputDebugStringA("wowreeb: idle function prologue not recognized");
+        return false;
     }
 
-    return ret;
-}
+    ::InterlockedOr(&settings->Milestones, MilestoneHookApplied);
 
-void ApplyClientInitHook(GameSettings* settings)
-{
-    // just to make sure the value is initialized
-    *reinterpret_cast<std::uint32_t*>(
-        GetAddress(Version::Cata32, Offset::CGlueMgr__m_pendingServerAlert)) = 1;
-
-    auto const proc = hadesmem::Process(::GetCurrentProcessId());
-    auto const idleOrig = hadesmem::detail::AliasCast<IdleT>(
-        GetAddress(Version::Cata32, Offset::Idle));
-    auto idleDetour = new hadesmem::PatchDetour<IdleT>(
-        proc, idleOrig,
-        [settings](hadesmem::PatchDetourBase* detour)
-        { return IdleHook(detour, settings); });
-
-    idleDetour->Apply();
+    return true;
 }
-} // namespace Cata32
 
-namespace Cata64
+// apply the hooks for whichever of the builds is running.  a build is only
+// supported by the dll of its own bitness.
+template <Version Current, Version... Rest>
+bool ApplyForBuild(unsigned int build, GameSettings* settings)
 {
-class CVar
-{
-};
+    using Traits = BuildTraits<Current>;
 
-using SetT = bool (__fastcall CVar::*)(const char*, char, char, char, char);
-using IdleT = int(__stdcall*)();
-using LoginT = void(__fastcall*)(char*, char*);
+    if (Traits::Build == build && Traits::PointerSize == sizeof(void*))
+        return ApplyHooks<Traits>(settings);
 
-int IdleHook(hadesmem::PatchDetourBase* detour, GameSettings* settings)
-{
-    auto const idle = detour->GetTrampolineT<IdleT>();
-    auto const ret = idle();
-
-    // if we are no longer waiting for the server alert, proceed with
-    // configuration
-    if (!*reinterpret_cast<std::uint32_t*>(
-            GetAddress(Version::Cata64, Offset::CGlueMgr__m_pendingServerAlert)))
-    {
-        auto const cvar = *reinterpret_cast<CVar**>(
-            GetAddress(Version::Cata64, Offset::RealmListCVar));
-        auto const set = hadesmem::detail::AliasCast<SetT>(
-            GetAddress(Version::Cata64, Offset::CVar__Set));
-
-        (cvar->*set)(settings->AuthServer, 1, 0, 1, 0);
-
-        detour->Remove();
-
-        if (settings->CredentialsSet)
-        {
-            auto const login = hadesmem::detail::AliasCast<LoginT>(
-                GetAddress(Version::Cata64, Offset::Login));
-            login(settings->Username, settings->Password);
-        }
-
-        settings->LoadComplete = true;
-    }
-
-    return ret;
+    if constexpr (sizeof...(Rest) > 0)
+        return ApplyForBuild<Rest...>(build, settings);
+    else
+        return false;
 }
+} // namespace
 
-void ApplyClientInitHook(GameSettings* settings)
+bool ApplyClientInitHook(unsigned int build, GameSettings* settings)
 {
-    // just to make sure the value is initialized
-    *reinterpret_cast<std::uint32_t*>(
-        GetAddress(Version::Cata64, Offset::CGlueMgr__m_pendingServerAlert)) = 1;
-
-    auto const proc = hadesmem::Process(::GetCurrentProcessId());
-    auto const idleOrig = hadesmem::detail::AliasCast<IdleT>(
-        GetAddress(Version::Cata64, Offset::Idle));
-    auto idleDetour = new hadesmem::PatchDetour<IdleT>(
-        proc, idleOrig,
-        [settings](hadesmem::PatchDetourBase* detour)
-        { return IdleHook(detour, settings); });
-
-    idleDetour->Apply();
+    return ApplyForBuild<Version::Classic, Version::TBC, Version::WotLK,
+                         Version::Cata32, Version::Cata64>(build, settings);
 }
-} // namespace Cata64
\ No newline at end of file
@@ -25,29 +25,8 @@
 
 #pragma once
 
-#include "wowreeb/Injector.hpp" // for GameSettings structure
-
-namespace Classic
-{
-void ApplyClientInitHook(GameSettings* settings);
-}
-
-namespace TBC
-{
-void ApplyClientInitHook(GameSettings* settings);
-}
-
-namespace WOTLK
-{
-void ApplyClientInitHook(GameSettings* settings);
-}
-
-namespace Cata32
-{
-void ApplyClientInitHook(GameSettings* settings);
-}
-
-namespace Cata64
-{
-void ApplyClientInitHook(GameSettings* settings);
-}
\ No newline at end of file
+#include "wowreeb/GameSettings.hpp"
+
+// install the hooks for the client's build.  returns false if the build is not
+// supported, or the addresses the hooks need cannot be found.
+bool ApplyClientInitHook(unsigned int build, GameSettings* settings);
\ No newline at end of file
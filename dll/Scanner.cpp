@@ -0,0 +1,369 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Scanner.hpp"
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+
+// msvc allows any instruction set's intrinsics anywhere
+#define TARGET(isa)
+#else
+#include <cpuid.h>
+
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace
+{
+// the position of the lowest bit set, which must not be zero
+unsigned long LowestBit(unsigned long bits)
+{
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanForward(&bit, bits);
+    return bit;
+#else
+    return static_cast<unsigned long>(__builtin_ctzl(bits));
+#endif
+}
+
+void Cpuid(int info[4], int leaf, int subleaf = 0)
+{
+#ifdef _MSC_VER
+    __cpuidex(info, leaf, subleaf);
+#else
+    unsigned int regs[4];
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+
+    for (auto i = 0; i < 4; ++i)
+        info[i] = static_cast<int>(regs[i]);
+#endif
+}
+
+// which registers the os saves, from xcr0
+std::uint64_t SavedRegisters()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return static_cast<std::uint64_t>(high) << 32 | low;
+#endif
+}
+
+// records a match, returning true once enough have been found
+bool Found(const std::uint8_t* candidate, const std::uint8_t** match,
+           std::size_t& found, std::size_t limit)
+{
+    if (!found++)
+        *match = candidate;
+
+    return found >= limit;
+}
+
+std::size_t FindScalar(const std::uint8_t* data, std::size_t length,
+                       const Pattern& pattern, const std::uint8_t** match,
+                       std::size_t limit)
+{
+    if (length < pattern.Bytes.size())
+        return 0;
+
+    auto const first = pattern.Bytes[pattern.First];
+    auto const end = data + pattern.First + length - pattern.Bytes.size() + 1;
+
+    std::size_t found = 0;
+
+    // let memchr find each occurrence of the first byte we must match
+    for (auto p = data + pattern.First; p < end; ++p)
+    {
+        p = static_cast<const std::uint8_t*>(::memchr(p, first, end - p));
+
+        if (!p)
+            break;
+
+        auto const candidate = p - pattern.First;
+
+        if (MatchPattern(candidate, pattern) &&
+            Found(candidate, match, found, limit))
+            break;
+    }
+
+    return found;
+}
+
+// search the positions which the vector loop did not reach
+std::size_t FindRemainder(const std::uint8_t* data, std::size_t length,
+                          const Pattern& pattern, const std::uint8_t** match,
+                          std::size_t limit, std::size_t found)
+{
+    if (found >= limit)
+        return found;
+
+    const std::uint8_t* rest;
+    auto const more = FindScalar(data, length, pattern, &rest, limit - found);
+
+    if (more && !found)
+        *match = rest;
+
+    return found + more;
+}
+
+// compare sixteen positions at a time against the first and last bytes which
+// must match, and check the whole pattern only where both do
+TARGET("sse2")
+std::size_t FindSse2(const std::uint8_t* data, std::size_t length,
+                     const Pattern& pattern, const std::uint8_t** match,
+                     std::size_t limit)
+{
+    if (length < pattern.Bytes.size())
+        return 0;
+
+    auto const positions = length - pattern.Bytes.size() + 1;
+    auto const first =
+        _mm_set1_epi8(static_cast<char>(pattern.Bytes[pattern.First]));
+    auto const last =
+        _mm_set1_epi8(static_cast<char>(pattern.Bytes[pattern.Last]));
+
+    std::size_t found = 0;
+    std::size_t i = 0;
+
+    for (; i + 16 <= positions && found < limit; i += 16)
+    {
+        auto const firstEqual = _mm_cmpeq_epi8(
+            first, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                       data + i + pattern.First)));
+        auto const lastEqual = _mm_cmpeq_epi8(
+            last, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                      data + i + pattern.Last)));
+
+        auto candidates = static_cast<unsigned long>(
+            _mm_movemask_epi8(_mm_and_si128(firstEqual, lastEqual)));
+        while (candidates)
+        {
+            auto const candidate = data + i + LowestBit(candidates);
+
+            if (MatchPattern(candidate, pattern) &&
+                Found(candidate, match, found, limit))
+                break;
+
+            candidates &= candidates - 1;
+        }
+    }
+
+    return FindRemainder(data + i, length - i, pattern, match, limit, found);
+}
+
+// as above, thirty two positions at a time
+TARGET("avx2")
+std::size_t FindAvx2(const std::uint8_t* data, std::size_t length,
+                     const Pattern& pattern, const std::uint8_t** match,
+                     std::size_t limit)
+{
+    if (length < pattern.Bytes.size())
+        return 0;
+
+    auto const positions = length - pattern.Bytes.size() + 1;
+    auto const first =
+        _mm256_set1_epi8(static_cast<char>(pattern.Bytes[pattern.First]));
+    auto const last =
+        _mm256_set1_epi8(static_cast<char>(pattern.Bytes[pattern.Last]));
+
+    std::size_t found = 0;
+    std::size_t i = 0;
+
+    for (; i + 32 <= positions && found < limit; i += 32)
+    {
+        auto const firstEqual = _mm256_cmpeq_epi8(
+            first, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                       data + i + pattern.First)));
+        auto const lastEqual = _mm256_cmpeq_epi8(
+            last, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                      data + i + pattern.Last)));
+
+        auto candidates = static_cast<unsigned long>(static_cast<unsigned int>(
+            _mm256_movemask_epi8(_mm256_and_si256(firstEqual, lastEqual))));
+        while (candidates)
+        {
+            auto const candidate = data + i + LowestBit(candidates);
+
+            if (MatchPattern(candidate, pattern) &&
+                Found(candidate, match, found, limit))
+                break;
+
+            candidates &= candidates - 1;
+        }
+    }
+
+    // avoid the penalty for mixing these with legacy sse instructions
+    _mm256_zeroupper();
+
+    return FindRemainder(data + i, length - i, pattern, match, limit, found);
+}
+
+using FindT = std::size_t (*)(const std::uint8_t* data, std::size_t length,
+                              const Pattern& pattern,
+                              const std::uint8_t** match, std::size_t limit);
+
+bool HasSse2()
+{
+    int info[4];
+    Cpuid(info, 1);
+
+    // edx bit 26
+    return !!(info[3] & (1 << 26));
+}
+
+bool HasAvx2()
+{
+    int info[4];
+    Cpuid(info, 0);
+
+    if (info[0] < 7)
+        return false;
+
+    Cpuid(info, 1);
+
+    // the processor must support avx, and the os must save the ymm registers
+    // (ecx bits 27 and 28, then xcr0 bits 1 and 2)
+    if ((info[2] & (3 << 27)) != (3 << 27) || (SavedRegisters() & 6) != 6)
+        return false;
+
+    // ebx bit 5
+    Cpuid(info, 7);
+
+    return !!(info[1] & (1 << 5));
+}
+
+FindT GetFinder(ScanKernel kernel)
+{
+    switch (kernel)
+    {
+        case ScanKernel::Avx2:
+            return FindAvx2;
+        case ScanKernel::Sse2:
+            return FindSse2;
+        default:
+            return FindScalar;
+    }
+}
+
+FindT GetFinder()
+{
+    static const FindT find = GetFinder(
+        HasAvx2() ? ScanKernel::Avx2
+                  : HasSse2() ? ScanKernel::Sse2 : ScanKernel::Scalar);
+
+    return find;
+}
+} // namespace
+
+bool SupportsKernel(ScanKernel kernel)
+{
+    switch (kernel)
+    {
+        case ScanKernel::Avx2:
+            return HasAvx2();
+        case ScanKernel::Sse2:
+            return HasSse2();
+        default:
+            return true;
+    }
+}
+
+bool ParsePattern(const char* text, Pattern& pattern)
+{
+    std::stringstream str(text);
+    std::string token;
+
+    pattern.Bytes.clear();
+    pattern.Mask.clear();
+
+    while (str >> token)
+    {
+        if (token == "??")
+        {
+            pattern.Bytes.push_back(0);
+            pattern.Mask.push_back(0);
+            continue;
+        }
+
+        if (token.length() != 2 || !::isxdigit(token[0]) ||
+            !::isxdigit(token[1]))
+            return false;
+
+        pattern.Bytes.push_back(
+            static_cast<std::uint8_t>(std::stoul(token, nullptr, 16)));
+        pattern.Mask.push_back(0xff);
+    }
+
+    pattern.First = 0;
+
+    while (pattern.First < pattern.Mask.size() && !pattern.Mask[pattern.First])
+        ++pattern.First;
+
+    if (pattern.First == pattern.Mask.size())
+        return false;
+
+    pattern.Last = pattern.Mask.size() - 1;
+
+    while (!pattern.Mask[pattern.Last])
+        --pattern.Last;
+
+    return true;
+}
+
+bool MatchPattern(const std::uint8_t* data, const Pattern& pattern)
+{
+    for (auto i = 0u; i < pattern.Bytes.size(); ++i)
+        if ((data[i] ^ pattern.Bytes[i]) & pattern.Mask[i])
+            return false;
+
+    return true;
+}
+
+std::size_t FindPattern(const std::uint8_t* data, std::size_t length,
+                        const Pattern& pattern, const std::uint8_t** match,
+                        std::size_t limit)
+{
+    return GetFinder()(data, length, pattern, match, limit);
+}
+
+std::size_t FindPatternWith(ScanKernel kernel, const std::uint8_t* data,
+                            std::size_t length, const Pattern& pattern,
+                            const std::uint8_t** match, std::size_t limit)
+{
+    return GetFinder(kernel)(data, length, pattern, match, limit);
+}
@@ -0,0 +1,71 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// a sequence of bytes, some of which may be anything
+struct Pattern
+{
+    std::vector<std::uint8_t> Bytes;
+    std::vector<std::uint8_t> Mask; // 0xff where the byte must match, else 0
+
+    // the first and last bytes which must match, used to find candidates
+    std::size_t First;
+    std::size_t Last;
+};
+
+// parse bytes in hex separated by white space, in which ?? stands for any byte,
+// such as "55 8B EC ?? A1".  fails unless at least one byte is given.
+bool ParsePattern(const char* text, Pattern& pattern);
+
+// true if the pattern matches the bytes at data
+bool MatchPattern(const std::uint8_t* data, const Pattern& pattern);
+
+// count the places in the buffer at which the pattern matches, stopping once
+// limit have been found.  the first is stored in match.
+std::size_t FindPattern(const std::uint8_t* data, std::size_t length,
+                        const Pattern& pattern, const std::uint8_t** match,
+                        std::size_t limit = 2);
+
+// the ways in which a buffer may be searched.  FindPattern uses the last which
+// the processor supports.
+enum class ScanKernel
+{
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+// true if the processor and os support the kernel
+bool SupportsKernel(ScanKernel kernel);
+
+// as FindPattern, but searching with the given kernel, which must be supported
+std::size_t FindPatternWith(ScanKernel kernel, const std::uint8_t* data,
+                            std::size_t length, const Pattern& pattern,
+                            const std::uint8_t** match, std::size_t limit = 2);
@@ -0,0 +1,313 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Signatures.hpp"
+
+#include "Scanner.hpp"
+#include "wowreeb/GameSettings.hpp"
+#include "wowreeb/Hex.hpp"
+
+#include <Windows.h>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+using OffsetCache = std::map<std::string, std::uint32_t>;
+
+// the cache lives beside this dll
+fs::path CachePath()
+{
+    HMODULE module;
+
+    if (!::GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                                  GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                              reinterpret_cast<LPCWSTR>(&CachePath), &module))
+        return {};
+
+    wchar_t path[MAX_PATH];
+
+    if (!::GetModuleFileNameW(module, path, MAX_PATH))
+        return {};
+
+    return fs::path(path).parent_path() / "wowreeb.offsets";
+}
+
+// each line holds a key, as below, followed by the offset found for it
+OffsetCache LoadCache(const fs::path& path)
+{
+    OffsetCache cache;
+    std::ifstream fd(path);
+    std::string line;
+
+    while (std::getline(fd, line))
+    {
+        auto const tab = line.rfind('\t');
+
+        if (tab == std::string::npos)
+            continue;
+
+        std::stringstream str(line.substr(tab + 1));
+        std::uint32_t offset;
+
+        if (str >> std::hex >> offset)
+            cache[line.substr(0, tab)] = offset;
+    }
+
+    return cache;
+}
+
+void SaveCache(const fs::path& path, const OffsetCache& cache)
+{
+    auto temp = path;
+    temp += "." + std::to_string(::GetCurrentProcessId());
+
+    {
+        std::ofstream fd(temp, std::ios::trunc);
+
+        for (auto const& entry : cache)
+            fd << entry.first << '\t' << std::hex << entry.second << '\n';
+
+        if (!fd)
+            return;
+    }
+
+    // replace the cache atomically so that another client starting at the
+    // same time never sees a partially written file.  failure only costs us
+    // a future search.
+    if (!::MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+        ::DeleteFileW(temp.c_str());
+}
+
+// the executable's hash and everything about the signature which affects the
+// address it resolves to, so that a changed signature is searched for again
+std::string CacheKey(const GameSettings* settings,
+                     const SettingsSignature& signature, const Pattern& pattern)
+{
+    std::stringstream str;
+
+    str << DataToHex(settings->ExeHash, sizeof(settings->ExeHash)) << '\t'
+        << signature.Target << '\t' << signature.Kind << '\t'
+        << signature.Displacement << '\t'
+        << GetSettingsString(settings, signature.Section) << '\t';
+
+    for (auto i = 0u; i < pattern.Bytes.size(); ++i)
+        str << (i ? " " : "")
+            << (pattern.Mask[i] ? DataToHex(&pattern.Bytes[i], 1) : "??");
+
+    return str.str();
+}
+
+bool FindSection(const std::uint8_t* base, const char* name,
+                 const std::uint8_t*& data, std::size_t& length)
+{
+    auto const dos = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+    auto const nt = reinterpret_cast<IMAGE_NT_HEADERS*>(
+        const_cast<std::uint8_t*>(base) + dos->e_lfanew);
+    auto section = IMAGE_FIRST_SECTION(nt);
+
+    for (auto i = 0u; i < nt->FileHeader.NumberOfSections; ++i, ++section)
+    {
+        // the name is only null terminated when it is shorter than the field
+        if (::strncmp(reinterpret_cast<const char*>(section->Name), name,
+                      IMAGE_SIZEOF_SHORT_NAME) ||
+            ::strlen(name) > IMAGE_SIZEOF_SHORT_NAME)
+            continue;
+
+        data = base + section->VirtualAddress;
+        length = section->Misc.VirtualSize ? section->Misc.VirtualSize :
+                                             section->SizeOfRawData;
+
+        return true;
+    }
+
+    return false;
+}
+
+// true if the pattern is found where the offset, whether built in to the dll or
+// cached, says it should be.  only code can be confirmed like this.
+bool Confirms(const SettingsSignature& signature, const Pattern& pattern,
+              const std::uint8_t* base, const std::uint8_t* section,
+              std::size_t length, std::uint32_t offset)
+{
+    if (!offset || signature.Kind != SignatureCode)
+        return false;
+
+    auto const start = static_cast<std::intptr_t>(offset) -
+                       signature.Displacement - (section - base);
+
+    if (start < 0 || static_cast<std::size_t>(start) > length ||
+        length - start < pattern.Bytes.size())
+        return false;
+
+    return MatchPattern(section + start, pattern);
+}
+
+// the offset of the address to which the signature refers, given where its
+// pattern matched
+bool AddressOf(const SettingsSignature& signature, const std::uint8_t* match,
+               const std::uint8_t* base, std::size_t imageSize,
+               std::uint32_t& offset)
+{
+    auto const at = match + signature.Displacement;
+
+    if (at < base || at + sizeof(std::uintptr_t) > base + imageSize)
+        return false;
+
+    auto address = reinterpret_cast<std::uintptr_t>(at);
+
+    if (signature.Kind == SignatureAbsolute)
+        ::memcpy(&address, at, sizeof(address));
+    else if (signature.Kind == SignatureRelative)
+    {
+        std::int32_t relative;
+        ::memcpy(&relative, at, sizeof(relative));
+
+        address += sizeof(relative) + static_cast<std::intptr_t>(relative);
+    }
+
+    auto const start = reinterpret_cast<std::uintptr_t>(base);
+
+    if (address < start || address - start >= imageSize)
+        return false;
+
+    offset = static_cast<std::uint32_t>(address - start);
+
+    return true;
+}
+} // namespace
+
+bool ResolveSignatures(const GameSettings* settings,
+                       std::uint32_t (&offsets)[SignatureTargetCount])
+{
+    if (!settings->SignatureCount)
+        return true;
+
+    auto const base =
+        reinterpret_cast<const std::uint8_t*>(::GetModuleHandle(nullptr));
+    auto const nt = reinterpret_cast<const IMAGE_NT_HEADERS*>(
+        base + reinterpret_cast<const IMAGE_DOS_HEADER*>(base)->e_lfanew);
+    auto const imageSize =
+        static_cast<std::size_t>(nt->OptionalHeader.SizeOfImage);
+
+    auto const signatures = GetSettingsSignatures(settings);
+    auto const cachePath = settings->ExeHashSet ? CachePath() : fs::path();
+
+    OffsetCache cache;
+    auto loaded = false;
+    auto modified = false;
+    auto result = true;
+
+    for (auto i = 0u; i < settings->SignatureCount; ++i)
+    {
+        auto const& signature = signatures[i];
+        auto& offset = offsets[signature.Target];
+
+        Pattern pattern;
+        const std::uint8_t* section;
+        std::size_t length;
+
+        if (!ParsePattern(GetSettingsString(settings, signature.Pattern),
+                          pattern) ||
+            !FindSection(base, GetSettingsString(settings, signature.Section),
+                         section, length))
+        {
+            offset = 0;
+            result = false;
+            continue;
+        }
+
+        // the client is the build we know, or differs only elsewhere
+        if (Confirms(signature, pattern, base, section, length, offset))
+            continue;
+
+        std::string key;
+
+        if (!cachePath.empty())
+        {
+            if (!loaded)
+            {
+                cache = LoadCache(cachePath);
+                loaded = true;
+            }
+
+            key = CacheKey(settings, signature, pattern);
+
+            auto const cached = cache.find(key);
+
+            // the file may have been damaged or edited, so an offset is only
+            // trusted if it lies within the image and, for code, the pattern
+            // is still found there.  otherwise it is searched for again.
+            if (cached != cache.end())
+            {
+                if (cached->second && cached->second < imageSize &&
+                    (signature.Kind != SignatureCode ||
+                     Confirms(signature, pattern, base, section, length,
+                              cached->second)))
+                {
+                    offset = cached->second;
+                    continue;
+                }
+
+                cache.erase(cached);
+                modified = true;
+            }
+        }
+
+        const std::uint8_t* match;
+
+        // a pattern which matches more than once cannot tell us which is meant
+        if (FindPattern(section, length, pattern, &match) != 1 ||
+            !AddressOf(signature, match, base, imageSize, offset))
+        {
+            std::stringstream str;
+            str << "wowreeb: signature " << signature.Target
+                << " not found uniquely";
+            ::OutputDebugStringA(str.str().c_str());
+
+            offset = 0;
+            result = false;
+            continue;
+        }
+
+        if (!key.empty())
+        {
+            cache[key] = offset;
+            modified = true;
+        }
+    }
+
+    if (modified)
+        SaveCache(cachePath, cache);
+
+    return result;
+}
@@ -23,6 +23,8 @@
 
 */
 
+#include "wowreeb/GameSettings.hpp"
+
 #include <CorError.h>
 #include <Windows.h>
 #include <cassert>
@@ -33,12 +35,12 @@
 
 #define MB(s) MessageBox(nullptr, s, nullptr, MB_OK)
 
-// this function is executed in the context of the wow process and assumes will
-// block until the specified method returns the intended usage is for the invoked
-// method to create its own thread in order to persist and then return immediately
-extern "C" __declspec(dllexport) unsigned int CLRLoad(wchar_t* dll,
-                                                      wchar_t* typeName,
-                                                      wchar_t* methodName)
+extern GameSettings* GetGameSettings();
+
+namespace
+{
+unsigned int LoadCLR(const wchar_t* dll, const wchar_t* typeName,
+                     const wchar_t* methodName)
 {
     if (!dll || !typeName || !methodName)
         return EXIT_FAILURE;
@@ -135,4 +137,21 @@ extern "C" __declspec(dllexport) unsigned int CLRLoad(wchar_t* dll,
     }
 
     return static_cast<unsigned int>(dwRet);
+}
+} // namespace
+
+// this function is executed in the context of the wow process and assumes will
+// block until the specified method returns the intended usage is for the invoked
+// method to create its own thread in order to persist and then return immediately
+extern "C" __declspec(dllexport) unsigned int CLRLoad()
+{
+    auto const settings = GetGameSettings();
+
+    // the settings section is mapped by Load, which must be called first
+    if (!settings || !settings->CLRPath.Length)
+        return EXIT_FAILURE;
+
+    return LoadCLR(GetSettingsString<wchar_t>(settings, settings->CLRPath),
+                   GetSettingsString<wchar_t>(settings, settings->CLRTypeName),
+                   GetSettingsString<wchar_t>(settings, settings->CLRMethodName));
 }
\ No newline at end of file
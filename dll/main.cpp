@@ -38,6 +38,9 @@
 
 namespace
 {
+HANDLE settingsMapping = nullptr;
+GameSettings* settingsView = nullptr;
+
 #define THROW_IF(expr, message)        \
     if (expr)                          \
     {                                  \
@@ -73,41 +76,159 @@ unsigned int GetBuild()
 
     return static_cast<unsigned int>(verInfo->dwFileVersionLS & 0xFFFF);
 }
+
+GameSettings* MapSettings()
+{
+    auto const name = GameSettingsSectionName(::GetCurrentProcessId());
+
+    settingsMapping = ::OpenFileMappingW(FILE_MAP_WRITE, FALSE, name.c_str());
+
+    if (!settingsMapping)
+        return nullptr;
+
+    auto const view = ::MapViewOfFile(settingsMapping, FILE_MAP_WRITE, 0, 0, 0);
+
+    MEMORY_BASIC_INFORMATION mbi;
+
+    if (!view || !::VirtualQuery(view, &mbi, sizeof(mbi)) ||
+        !ValidateGameSettings(static_cast<GameSettings*>(view), mbi.RegionSize))
+    {
+        if (view)
+            ::UnmapViewOfFile(view);
+
+        ::CloseHandle(settingsMapping);
+        settingsMapping = nullptr;
+
+        return nullptr;
+    }
+
+    return static_cast<GameSettings*>(view);
+}
+
+void UnmapSettings()
+{
+    if (settingsView)
+        ::UnmapViewOfFile(settingsView);
+
+    if (settingsMapping)
+        ::CloseHandle(settingsMapping);
+
+    settingsView = nullptr;
+    settingsMapping = nullptr;
+}
 } // namespace
 
-#define BUILD_CLASSIC 5875
-#define BUILD_TBC     8606
-#define BUILD_WOTLK   12340
-#define BUILD_CATA    15595
+// the settings section remains mapped until we are ejected
+GameSettings* GetGameSettings()
+{
+    return settingsView;
+}
+
+BOOL WINAPI DllMain(HINSTANCE, DWORD reason, LPVOID)
+{
+    if (reason == DLL_PROCESS_DETACH)
+        UnmapSettings();
+
+    return TRUE;
+}
 
 // this function is executed in the context of the wow process
-extern "C" __declspec(dllexport) unsigned int Load(GameSettings* settings)
+extern "C" __declspec(dllexport) unsigned int Load()
+{
+    if (!settingsView)
+        settingsView = MapSettings();
+
+    auto const settings = settingsView;
+
+    if (!settings)
+        return EXIT_FAILURE;
+
+    ::InterlockedOr(&settings->Milestones, MilestoneSettingsMapped);
+
+    if (!settings->AuthServer.Length)
+        return EXIT_FAILURE;
+
+    return ApplyClientInitHook(GetBuild(), settings) ? EXIT_SUCCESS :
+                                                       EXIT_FAILURE;
+}
+
+extern "C" unsigned int CLRLoad();
+
+// this function is executed in the context of the wow process.  it performs
+// every step of our initialization within a single remote call, recording the
+// outcome of each step in the settings section for the launcher to inspect.
+extern "C" __declspec(dllexport) unsigned int Boot()
 {
-    if (!settings->AuthServer[0])
+    auto const load = Load();
+
+    // without the settings section there is nowhere to report anything
+    if (!settingsView)
         return EXIT_FAILURE;
 
-    auto const build = GetBuild();
+    auto const settings = settingsView;
+    auto result = static_cast<unsigned int>(EXIT_SUCCESS);
+
+    settings->LoadResult.Status = load ? StepFailed : StepSucceeded;
+    settings->LoadResult.Value = load;
 
-    switch (build)
+    if (!!load)
+        result = EXIT_FAILURE;
+
+    auto const dlls = GetSettingsNativeDlls(settings);
+
+    for (auto i = 0u; i < settings->NativeDllCount; ++i)
     {
-        case BUILD_CLASSIC:
-            Classic::ApplyClientInitHook(settings);
-            break;
-        case BUILD_TBC:
-            TBC::ApplyClientInitHook(settings);
-            break;
-        case BUILD_WOTLK:
-            WOTLK::ApplyClientInitHook(settings);
-            break;
-        case BUILD_CATA:
-            if (sizeof(void*) == 4)
-                Cata32::ApplyClientInitHook(settings);
-            else
-                Cata64::ApplyClientInitHook(settings);
-            break;
-        default:
-            return EXIT_FAILURE;
+        auto& dll = dlls[i];
+
+        auto const handle =
+            ::LoadLibraryW(GetSettingsString<wchar_t>(settings, dll.Path));
+
+        if (!handle)
+        {
+            dll.Result.Status = StepLoadLibraryFailed;
+            dll.Result.Value = ::GetLastError();
+            result = EXIT_FAILURE;
+            continue;
+        }
+
+        if (!dll.Method.Length)
+        {
+            dll.Result.Status = StepSucceeded;
+            continue;
+        }
+
+        using NativeMethodT = DWORD_PTR (*)();
+
+        auto const method = reinterpret_cast<NativeMethodT>(::GetProcAddress(
+            handle, GetSettingsString(settings, dll.Method)));
+
+        if (!method)
+        {
+            dll.Result.Status = StepProcedureNotFound;
+            dll.Result.Value = ::GetLastError();
+            result = EXIT_FAILURE;
+            continue;
+        }
+
+        auto const ret = method();
+
+        dll.Result.Status = ret ? StepFailed : StepSucceeded;
+        dll.Result.Value = static_cast<std::uint32_t>(ret);
+
+        if (!!ret)
+            result = EXIT_FAILURE;
+    }
+
+    if (settings->CLRPath.Length)
+    {
+        auto const clr = CLRLoad();
+
+        settings->CLRResult.Status = clr ? StepFailed : StepSucceeded;
+        settings->CLRResult.Value = clr;
+
+        if (!!clr)
+            result = EXIT_FAILURE;
     }
 
-    return EXIT_SUCCESS;
+    return result;
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// checks each crypto provider this processor supports against the CBC-AES256
+// example of NIST SP 800-38A, and against each other for random keys, ivs and
+// lengths, so that credentials encrypted by one are decrypted by any other
+
+#include "Check.hpp"
+#include "Crypto.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+static constexpr auto Block = CryptoProvider::BlockLength;
+
+const std::vector<std::uint8_t> Key = {
+    0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae,
+    0xf0, 0x85, 0x7d, 0x77, 0x81, 0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61,
+    0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4};
+
+const std::vector<std::uint8_t> Iv = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+                                      0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+                                      0x0c, 0x0d, 0x0e, 0x0f};
+
+const std::vector<std::uint8_t> Plain = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e,
+    0x11, 0x73, 0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03,
+    0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51, 0x30,
+    0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19,
+    0x1a, 0x0a, 0x52, 0xef, 0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b,
+    0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+
+const std::vector<std::uint8_t> Cipher = {
+    0xf5, 0x8c, 0x4c, 0x04, 0xd6, 0xe5, 0xf1, 0xba, 0x77, 0x9e, 0xab,
+    0xfb, 0x5f, 0x7b, 0xfb, 0xd6, 0x9c, 0xfc, 0x4e, 0x96, 0x7e, 0xdb,
+    0x80, 0x8d, 0x67, 0x9f, 0x77, 0x7b, 0xc6, 0x70, 0x2c, 0x7d, 0x39,
+    0xf2, 0x33, 0x69, 0xa9, 0xd9, 0xba, 0xcf, 0xa5, 0x30, 0xe2, 0x63,
+    0x04, 0x23, 0x14, 0x61, 0xb2, 0xeb, 0x05, 0xe2, 0xc3, 0x9b, 0xe9,
+    0xfc, 0xda, 0x6c, 0x19, 0x07, 0x8c, 0x6a, 0x9d, 0x1b};
+
+std::vector<std::uint8_t> Random(std::size_t length, std::mt19937& random)
+{
+    std::vector<std::uint8_t> result(length);
+
+    for (auto& byte : result)
+        byte = static_cast<std::uint8_t>(random());
+
+    return result;
+}
+
+void CheckKnownAnswers(const CryptoProvider& provider)
+{
+    std::string const name = provider.Name();
+
+    // F.2.5
+    auto buffer = Plain;
+    provider.Encrypt(Key.data(), Iv.data(), buffer.data(), buffer.size());
+    Check(buffer == Cipher, name + " CBC-AES256.Encrypt");
+
+    // F.2.6
+    buffer = Cipher;
+    provider.Decrypt(Key.data(), Iv.data(), buffer.data(), buffer.size());
+    Check(buffer == Plain, name + " CBC-AES256.Decrypt");
+
+    // each block alone, chained from the ciphertext before it
+    for (auto i = 0u; i < Plain.size() / Block; ++i)
+    {
+        auto const iv = i ? &Cipher[(i - 1) * Block] : Iv.data();
+
+        std::vector<std::uint8_t> block(Plain.begin() + i * Block,
+                                        Plain.begin() + (i + 1) * Block);
+        provider.Encrypt(Key.data(), iv, block.data(), block.size());
+        Check(std::equal(block.begin(), block.end(), &Cipher[i * Block]),
+              name + " encrypts block " + std::to_string(i + 1) + " alone");
+
+        provider.Decrypt(Key.data(), iv, block.data(), block.size());
+        Check(std::equal(block.begin(), block.end(), &Plain[i * Block]),
+              name + " decrypts block " + std::to_string(i + 1) + " alone");
+    }
+}
+} // namespace
+
+int main()
+{
+    auto const& software = GetCryptoProvider(CryptoImplementation::Software);
+    std::vector<const CryptoProvider*> providers = {&software};
+
+    if (IsSupported(CryptoImplementation::AesNi))
+        providers.push_back(&GetCryptoProvider(CryptoImplementation::AesNi));
+    else
+        std::cout << "AES-NI is not supported, so is not tested" << std::endl;
+
+    for (auto const provider : providers)
+        CheckKnownAnswers(*provider);
+
+    auto const chosen = &GetCryptoProvider();
+    Check(chosen == providers.back(),
+          "the fastest provider is chosen, not " + std::string(chosen->Name()));
+
+    // lengths either side of each multiple of the blocks decrypted at once
+    std::mt19937 random(12345);
+
+    for (auto blocks = 0u; blocks <= 17; ++blocks)
+    {
+        for (auto trial = 0; trial < 20; ++trial)
+        {
+            auto const key = Random(CryptoProvider::KeyLength, random);
+            auto const iv = Random(Block, random);
+            auto const plain = Random(blocks * Block, random);
+
+            auto expected = plain;
+            software.Encrypt(key.data(), iv.data(), expected.data(),
+                             expected.size());
+
+            for (auto const provider : providers)
+            {
+                auto buffer = plain;
+                provider->Encrypt(key.data(), iv.data(), buffer.data(),
+                                  buffer.size());
+                Check(buffer == expected,
+                      std::string(provider->Name()) + " encrypts " +
+                          std::to_string(blocks) + " blocks as tiny-AES-c");
+
+                provider->Decrypt(key.data(), iv.data(), buffer.data(),
+                                  buffer.size());
+                Check(buffer == plain, std::string(provider->Name()) +
+                                           " decrypts " +
+                                           std::to_string(blocks) + " blocks");
+            }
+        }
+    }
+
+    return Finish();
+}
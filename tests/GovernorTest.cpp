@@ -0,0 +1,191 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// drives the governor's decisions through traces of a client moving between
+// the foreground and background, checking when its restraints change
+
+#include "Check.hpp"
+#include "FakeBackend.hpp"
+#include "Governor.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Governor.cpp polls the real backend, which this test never reaches
+ProcessBackend& GetProcessBackend()
+{
+    static FakeBackend backend;
+    return backend;
+}
+
+namespace
+{
+// as often as the governor polls
+static constexpr unsigned int Step = 250;
+
+// the client is in the foreground from At onward, or else in the background
+struct Focus
+{
+    unsigned int At;
+    bool Foreground;
+};
+
+// a change to the restraints, at the poll which made it
+struct Change
+{
+    unsigned int At;
+    ClientThrottle Throttle;
+
+    bool operator==(const Change& other) const
+    {
+        return At == other.At && Throttle == other.Throttle;
+    }
+};
+
+std::vector<Change> Replay(const BackgroundPolicy& policy,
+                           const std::vector<Focus>& trace,
+                           unsigned int length)
+{
+    auto const start = std::chrono::steady_clock::time_point();
+
+    ThrottleTracker tracker;
+    tracker.Since = start;
+
+    std::vector<Change> changes;
+    auto focus = trace.begin();
+    auto foreground = true;
+
+    for (auto at = Step; at <= length; at += Step)
+    {
+        for (; focus != trace.end() && focus->At <= at; ++focus)
+            foreground = focus->Foreground;
+
+        ClientThrottle throttle;
+
+        if (tracker.Update(policy, foreground,
+                           start + std::chrono::milliseconds(at), throttle))
+            changes.push_back({at, throttle});
+    }
+
+    return changes;
+}
+
+std::string Describe(const std::vector<Change>& changes)
+{
+    std::string result;
+
+    for (auto const& change : changes)
+        result += " " + std::to_string(change.At) + ":" +
+                  std::to_string(change.Throttle.CpuRate) +
+                  (change.Throttle.EcoQoS ? "e" : "") +
+                  (change.Throttle.TrimWorkingSet ? "t" : "");
+
+    return result.empty() ? " none" : result;
+}
+
+void CheckTrace(const std::string& name, const BackgroundPolicy& policy,
+                const std::vector<Focus>& trace, unsigned int length,
+                const std::vector<Change>& expected)
+{
+    auto const changes = Replay(policy, trace, length);
+
+    Check(changes == expected, name + ": expected" + Describe(expected) +
+                                   ", got" + Describe(changes));
+}
+} // namespace
+
+int main()
+{
+    BackgroundPolicy policy {};
+    policy.Enabled = true;
+    policy.CpuRate = 20;
+    policy.EcoQoS = true;
+    policy.TrimWorkingSet = true;
+    policy.Delay = 2000;
+
+    auto const restrained = ClientThrottle {20, true, true};
+    auto const free = ClientThrottle {};
+
+    // a client left in the foreground is never restrained
+    CheckTrace("foreground", policy, {}, 10000, {});
+
+    // restrained once the delay has passed, and only once
+    CheckTrace("background", policy, {{1000, false}}, 10000,
+               {{3000, restrained}});
+
+    // switching away for less than the delay costs nothing
+    CheckTrace("glance away", policy, {{1000, false}, {2500, true}}, 10000,
+               {});
+
+    // focus lifts the restraints at once, and the delay starts again when the
+    // client next moves to the background, trimming it again
+    CheckTrace("alt-tab", policy,
+               {{1000, false}, {4000, true}, {4500, false}}, 10000,
+               {{3000, restrained}, {4000, free}, {6500, restrained}});
+
+    // a change between polls is seen at the next one
+    CheckTrace("between polls", policy, {{1100, false}, {3600, true}}, 10000,
+               {{3250, restrained}, {3750, free}});
+
+    // without a delay, the first poll in the background restrains the client
+    auto immediate = policy;
+    immediate.Delay = 0;
+
+    CheckTrace("no delay", immediate, {{1000, false}, {2000, true}}, 5000,
+               {{1000, restrained}, {2000, free}});
+
+    // only the restraints asked for are applied.  the delay is counted from
+    // the first poll which finds the client in the background.
+    auto capOnly = policy;
+    capOnly.EcoQoS = false;
+    capOnly.TrimWorkingSet = false;
+
+    CheckTrace("cap only", capOnly, {{0, false}}, 5000,
+               {{2250, ClientThrottle {20, false, false}}});
+
+    // a disabled policy never restrains the client
+    auto disabled = policy;
+    disabled.Enabled = false;
+
+    CheckTrace("disabled", disabled, {{0, false}}, 10000, {});
+
+    // a policy asking for nothing leaves the client alone
+    BackgroundPolicy nothing {};
+    nothing.Enabled = true;
+
+    CheckTrace("nothing", nothing, {{0, false}}, 10000, {});
+
+    Check(DecideThrottle(policy, false, std::chrono::milliseconds(1999)) ==
+              free,
+          "restrained before the delay");
+    Check(DecideThrottle(policy, false, std::chrono::milliseconds(2000)) ==
+              restrained,
+          "not restrained after the delay");
+    Check(DecideThrottle(policy, true, std::chrono::milliseconds(5000)) == free,
+          "restrained in the foreground");
+
+    return Finish();
+}
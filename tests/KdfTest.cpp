@@ -0,0 +1,138 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// checks the hand written key derivation against the published test vectors,
+// as a mistake in it would lock users out of every credential
+
+#include "Check.hpp"
+#include "Hex.hpp"
+#include "Kdf.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::string Hex(const std::uint8_t* data, std::size_t length)
+{
+    return DataToHex(data, length);
+}
+
+KdfParams Pbkdf2Params(const std::string& salt, std::uint32_t iterations)
+{
+    KdfParams params;
+    params.Algorithm = KdfAlgorithm::Pbkdf2Sha256;
+    params.Iterations = iterations;
+    params.Memory = 0;
+    params.Lanes = 1;
+    params.Salt.assign(salt.begin(), salt.end());
+
+    return params;
+}
+} // namespace
+
+int main()
+{
+    // RFC 7693, appendix A
+    {
+        std::uint8_t digest[64];
+        Blake2bHash("abc", 3, digest, sizeof(digest));
+
+        Check(Hex(digest, sizeof(digest)) ==
+                  "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbff"
+                  "a2d17d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386ed"
+                  "d4009923",
+              "BLAKE2b-512(\"abc\")");
+    }
+
+    // RFC 9106, section 5.3
+    {
+        std::uint8_t tag[32];
+        Argon2idHash(std::string(32, '\x01'), std::vector<std::uint8_t>(16, 2),
+                     std::vector<std::uint8_t>(8, 3),
+                     std::vector<std::uint8_t>(12, 4), 32, 3, 4, tag,
+                     sizeof(tag));
+
+        Check(Hex(tag, sizeof(tag)) == "0d640df58d78766c08c037a34a8b53c9d01ef0"
+                                       "452d75b65eb52520e96b01e659",
+              "argon2id test vector");
+    }
+
+    // PBKDF2-HMAC-SHA256 of "password" with the salt "salt", as published
+    // alongside RFC 7914
+    {
+        std::uint8_t key[32];
+
+        DeriveKey("password", Pbkdf2Params("salt", 1), key);
+        Check(Hex(key, sizeof(key)) == "120fb6cffcf8b32c43e7225256c4f837a8654"
+                                       "8c92ccc35480805987cb70be17b",
+              "pbkdf2-sha256, 1 iteration");
+
+        DeriveKey("password", Pbkdf2Params("salt", 4096), key);
+        Check(Hex(key, sizeof(key)) == "c5e478d59288c841aa530db6845c4c8d96289"
+                                       "3a001ce4e11a4963873aa98134a",
+              "pbkdf2-sha256, 4096 iterations");
+    }
+
+    // DeriveKey is argon2id without a secret or associated data
+    {
+        KdfParams params;
+        params.Algorithm = KdfAlgorithm::Argon2id;
+        params.Memory = 64;
+        params.Iterations = 3;
+        params.Lanes = 2;
+        params.Salt.assign(KdfParams::SaltLength, 7);
+
+        std::uint8_t derived[32], direct[32];
+        DeriveKey("key", params, derived);
+        Argon2idHash("key", params.Salt, {}, {}, params.Memory,
+                     params.Iterations, params.Lanes, direct, sizeof(direct));
+
+        Check(Hex(derived, sizeof(derived)) == Hex(direct, sizeof(direct)),
+              "DeriveKey matches argon2id");
+
+        // the parameters survive being written out and read back
+        KdfParams parsed;
+        Check(ParseKdfParams(FormatKdfParams(params), parsed) &&
+                  parsed.Algorithm == params.Algorithm &&
+                  parsed.Memory == params.Memory &&
+                  parsed.Iterations == params.Iterations &&
+                  parsed.Lanes == params.Lanes && parsed.Salt == params.Salt,
+              "parameters round trip");
+
+        // memory beyond what the 32 bit launcher can allocate is refused
+        auto const salt = DataToHex(params.Salt);
+        Check(ParseKdfParams("$argon2id$v=19$m=262144,t=3,p=4$" + salt, parsed),
+              "256 MiB accepted");
+        Check(!ParseKdfParams("$argon2id$v=19$m=262145,t=3,p=4$" + salt,
+                              parsed),
+              "more than 256 MiB refused");
+        Check(!ParseKdfParams("$argon2id$v=19$m=16,t=3,p=4$" + salt, parsed),
+              "fewer than eight blocks a lane refused");
+    }
+
+    return Finish();
+}
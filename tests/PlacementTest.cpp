@@ -0,0 +1,150 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// checks the parsing of processor lists from the config, and how the clients
+// of a group are dealt the physical cores
+
+#include "Check.hpp"
+#include "Placement.hpp"
+
+#include <cstddef>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+bool Parses(const std::string& list, const std::vector<unsigned int>& expected)
+{
+    try
+    {
+        return ParseProcessorList(list) == expected;
+    }
+    catch (std::runtime_error const&)
+    {
+        return false;
+    }
+}
+
+bool Rejects(const std::string& list)
+{
+    try
+    {
+        ParseProcessorList(list);
+    }
+    catch (std::runtime_error const&)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+// cores of two logical processors each, as with hyperthreading
+CoreTopology Cores(std::size_t count)
+{
+    CoreTopology result;
+
+    for (auto i = 0u; i < count; ++i)
+        result.push_back({2 * i, 2 * i + 1});
+
+    return result;
+}
+
+// every client is given processors, and every core is used by someone
+void CheckPlan(const CoreTopology& cores, std::size_t clients)
+{
+    auto const name = std::to_string(clients) + " clients on " +
+                      std::to_string(cores.size()) + " cores";
+
+    std::set<unsigned int> used;
+    std::size_t total = 0;
+
+    for (auto i = 0u; i < clients; ++i)
+    {
+        auto const plan = PlanAffinity(cores, clients, i);
+
+        Check(!plan.empty(), name + ": client " + std::to_string(i));
+
+        used.insert(plan.begin(), plan.end());
+        total += plan.size();
+    }
+
+    Check(used.size() == 2 * cores.size(), name + ": every core used");
+
+    // cores are only shared once there are more clients than cores
+    if (clients <= cores.size())
+        Check(total == used.size(), name + ": no core shared");
+}
+} // namespace
+
+int main()
+{
+    Check(Parses("", {}), "empty list");
+    Check(Parses(" , ,", {}), "empty entries");
+    Check(Parses("3", {3}), "single processor");
+    Check(Parses("0,2,4-7", {0, 2, 4, 5, 6, 7}), "processors and a range");
+    Check(Parses(" 6-7 , 1 ", {1, 6, 7}), "spaces around entries");
+    Check(Parses("4-4", {4}), "range of one");
+    Check(Parses("5,1-3,2", {1, 2, 3, 5}), "sorted and unique");
+    Check(Parses("65535", {65535}), "highest processor");
+
+    Check(Rejects("7-4"), "reversed range");
+    Check(Rejects("-3"), "range without a start");
+    Check(Rejects("3-"), "range without an end");
+    Check(Rejects("1-2-3"), "range of three");
+    Check(Rejects("a"), "not a number");
+    Check(Rejects("1a"), "trailing characters");
+    Check(Rejects("1 2"), "missing comma");
+    Check(Rejects("65536"), "processor too high");
+    Check(Rejects("99999999999999999999"), "processor out of range");
+
+    Check(FormatProcessorList(ParseProcessorList("0-2,8")) == "0,1,2,8",
+          "format round trip");
+
+    // nothing is known of the machine, or one client has it to itself
+    Check(PlanAffinity({}, 4, 0).empty(), "empty topology");
+    Check(PlanAffinity({}, 4, 3).empty(), "empty topology, last client");
+    Check(PlanAffinity(Cores(4), 1, 0).empty(), "single client");
+    Check(PlanAffinity(Cores(4), 0, 0).empty(), "no clients");
+
+    Check(PlanAffinity(Cores(4), 2, 0) == std::vector<unsigned int>({0, 1, 4, 5}),
+          "first of two clients on four cores");
+    Check(PlanAffinity(Cores(4), 2, 1) == std::vector<unsigned int>({2, 3, 6, 7}),
+          "second of two clients on four cores");
+
+    // with more clients than cores, the cores are dealt round again
+    Check(PlanAffinity(Cores(2), 5, 4) == std::vector<unsigned int>({0, 1}),
+          "fifth of five clients on two cores");
+    Check(PlanAffinity(Cores(1), 3, 2) == std::vector<unsigned int>({0, 1}),
+          "third of three clients on one core");
+
+    for (auto cores = 1u; cores <= 8; ++cores)
+        for (auto clients = 2u; clients <= 12; ++clients)
+            CheckPlan(Cores(cores), clients);
+
+    return Finish();
+}
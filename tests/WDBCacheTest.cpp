@@ -0,0 +1,279 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+// switches a client folder's cache between realms, checking that each realm
+// gets its own cache back, including after an interrupted switch
+
+#include "Check.hpp"
+#include "WDBCache.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+static constexpr char TrashPrefix[] = "WDB.wowreeb-trash-";
+
+// the client writes one file into each of its cache folders
+void WriteCache(const fs::path& clientDir, const std::string& contents)
+{
+    for (auto const folder : {fs::path("WDB"), fs::path("Cache") / "WDB"})
+    {
+        fs::create_directories(clientDir / folder / "enUS");
+        std::ofstream(clientDir / folder / "enUS" / "creaturecache.wdb")
+            << contents;
+    }
+}
+
+// the contents of both live cache folders if they agree, or else a description
+// of what is wrong
+std::string ReadCache(const fs::path& clientDir)
+{
+    std::string result;
+
+    for (auto const folder : {fs::path("WDB"), fs::path("Cache") / "WDB"})
+    {
+        auto const file = clientDir / folder / "enUS" / "creaturecache.wdb";
+
+        if (!fs::exists(file))
+            return "(missing)";
+
+        std::string contents;
+        std::getline(std::ifstream(file), contents);
+
+        if (!result.empty() && result != contents)
+            return "(mixed)";
+
+        result = contents;
+    }
+
+    return result;
+}
+
+std::string ReadOwner(const fs::path& clientDir)
+{
+    std::string result;
+    std::getline(std::ifstream(clientDir / "WDB.wowreeb" / "current"), result);
+
+    return result;
+}
+
+bool IsTrash(const fs::path& path)
+{
+    return path.filename().string().compare(0, sizeof(TrashPrefix) - 1,
+                                            TrashPrefix) == 0;
+}
+
+std::size_t CountTrash(const fs::path& clientDir)
+{
+    std::size_t result = 0;
+
+    for (auto const& entry : fs::recursive_directory_iterator(clientDir))
+        result += IsTrash(entry.path());
+
+    return result;
+}
+
+// trash is deleted by detached threads, so give them a while to finish
+bool TrashDeleted(const fs::path& clientDir)
+{
+    auto const deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while (CountTrash(clientDir))
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return true;
+}
+
+// a fresh client folder for each case
+fs::path MakeClientDir(const std::string& name)
+{
+    auto const result = fs::temp_directory_path() / ("wowreeb-wdb-test-" + name);
+
+    fs::remove_all(result);
+    fs::create_directories(result);
+
+    return result;
+}
+
+void TestSwitch()
+{
+    auto const dir = MakeClientDir("switch");
+
+    // a realm with no snapshot starts with an empty cache
+    SwitchWDB(dir, "Alpha");
+    Check(ReadCache(dir) == "(missing)", "switch: first realm starts empty");
+    WriteCache(dir, "alpha");
+
+    SwitchWDB(dir, "Beta");
+    Check(ReadCache(dir) == "(missing)", "switch: second realm starts empty");
+    WriteCache(dir, "beta");
+
+    SwitchWDB(dir, "Alpha");
+    Check(ReadCache(dir) == "alpha", "switch: first realm restored");
+
+    SwitchWDB(dir, "Alpha");
+    Check(ReadCache(dir) == "alpha", "switch: same realm left alone");
+
+    SwitchWDB(dir, "Beta");
+    Check(ReadCache(dir) == "beta", "switch: second realm restored");
+
+    // names reduced to the same characters are still kept apart
+    SwitchWDB(dir, "Alpha!");
+    Check(ReadCache(dir) == "(missing)", "switch: similar name kept apart");
+
+    Check(TrashDeleted(dir), "switch: trash deleted");
+    fs::remove_all(dir);
+}
+
+void TestAdopt()
+{
+    auto const dir = MakeClientDir("adopt");
+
+    // the client was run some other way before the launcher ever switched
+    WriteCache(dir, "unowned");
+    SwitchWDB(dir, "Alpha");
+    Check(ReadCache(dir) == "unowned", "adopt: live cache kept");
+
+    SwitchWDB(dir, "Beta");
+    SwitchWDB(dir, "Alpha");
+    Check(ReadCache(dir) == "unowned", "adopt: adopted cache is the realm's");
+
+    // the owner is lost while a realm has a snapshot.  the live cache, being
+    // the newer, supersedes the snapshot.
+    SwitchWDB(dir, "Beta");
+    WriteCache(dir, "newer");
+    fs::remove(dir / "WDB.wowreeb" / "current");
+
+    SwitchWDB(dir, "Alpha");
+    Check(ReadCache(dir) == "newer", "adopt: live cache supersedes snapshot");
+    Check(TrashDeleted(dir), "adopt: superseded snapshot deleted");
+
+    SwitchWDB(dir, "Beta");
+    SwitchWDB(dir, "Alpha");
+    Check(ReadCache(dir) == "newer", "adopt: superseded snapshot stays gone");
+
+    fs::remove_all(dir);
+}
+
+void TestResume()
+{
+    auto const dir = MakeClientDir("resume");
+
+    SwitchWDB(dir, "Alpha");
+    WriteCache(dir, "alpha");
+    auto const alpha = ReadOwner(dir);
+
+    SwitchWDB(dir, "Beta");
+    WriteCache(dir, "beta");
+    auto const beta = ReadOwner(dir);
+
+    Check(!alpha.empty() && !beta.empty() && alpha != beta,
+          "resume: realms recorded apart");
+
+    // a switch back to alpha is interrupted once the live cache has been
+    // stashed for beta and alpha recorded as the owner, before alpha's
+    // snapshot was restored
+    auto const snapshots = dir / "WDB.wowreeb";
+
+    for (auto const folder : {fs::path("WDB"), fs::path("Cache") / "WDB"})
+    {
+        fs::create_directories((snapshots / beta / folder).parent_path());
+        fs::rename(dir / folder, snapshots / beta / folder);
+    }
+
+    std::ofstream(snapshots / "current", std::ios::trunc) << alpha;
+
+    SwitchWDB(dir, "Alpha");
+    Check(ReadCache(dir) == "alpha", "resume: interrupted switch completed");
+
+    SwitchWDB(dir, "Beta");
+    Check(ReadCache(dir) == "beta", "resume: stashed cache intact");
+
+    Check(TrashDeleted(dir), "resume: trash deleted");
+    fs::remove_all(dir);
+}
+
+void TestSweep()
+{
+    auto const dir = MakeClientDir("sweep");
+
+    SwitchWDB(dir, "Beta");
+    WriteCache(dir, "beta");
+    auto const beta = dir / "WDB.wowreeb" / ReadOwner(dir);
+
+    SwitchWDB(dir, "Alpha");
+    WriteCache(dir, "alpha");
+
+    // a previous run ended while deleting trash beside the live folders and
+    // beside those of a snapshot
+    for (auto const parent : {dir, dir / "Cache", beta, beta / "Cache"})
+    {
+        auto const trash = parent / (std::string(TrashPrefix) + "1-2-3");
+        fs::create_directories(trash / "enUS");
+        std::ofstream(trash / "enUS" / "itemcache.wdb") << "stale";
+    }
+
+    fs::create_directories(dir / "WDB.other");
+
+    SweepWDBTrash(dir);
+
+    Check(TrashDeleted(dir), "sweep: trash deleted");
+    Check(fs::exists(dir / "WDB.other"), "sweep: other folders kept");
+    Check(ReadCache(dir) == "alpha", "sweep: live cache kept");
+
+    SwitchWDB(dir, "Beta");
+    Check(ReadCache(dir) == "beta", "sweep: snapshot kept");
+
+    // clearing moves the live folders out of the way at once
+    ClearWDB(dir);
+    Check(ReadCache(dir) == "(missing)", "clear: live cache gone");
+    Check(TrashDeleted(dir), "clear: trash deleted");
+
+    fs::remove_all(dir);
+}
+} // namespace
+
+int main()
+{
+    TestSwitch();
+    TestAdopt();
+    TestResume();
+    TestSweep();
+
+    return Finish();
+}
@@ -25,14 +25,18 @@
 
 #include "Config.hpp"
 
+#include "Credentials.hpp"
+#include "Hex.hpp"
+#include "KeyAgent.hpp"
+#include "Vault.hpp"
 #include "rapidxml/rapidxml.hpp"
-#include "tiny-AES-c/aes.hpp"
 
 #include <Windows.h>
 #include <algorithm>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -54,24 +58,49 @@ std::vector<char> ReadFile(const fs::path& file)
     return buff;
 }
 
-std::uint8_t HexCharToByte(char b)
+void ParseSHA256(const std::string& module, const std::string& realm,
+                 const rapidxml::xml_attribute<>* attribute, std::uint8_t* digest)
 {
-    if (b >= '0' && b <= '9')
-        return b - '0';
-    if (b >= 'A' && b <= 'Z')
-        return b - 'A' + 10;
-    if (b >= 'a' && b <= 'z')
-        return b - 'a' + 10;
-
-    throw std::invalid_argument("Unable to convert hex character to byte");
+    if (attribute->value_size() != 2 * picosha2::k_digest_size)
+    {
+        std::stringstream str;
+        str << module << " SHA256 for \"" << realm
+            << "\" is wrong size.  Should be " << picosha2::k_digest_size
+            << " bytes";
+        throw std::runtime_error(str.str().c_str());
+    }
+
+    if (!HexToData(attribute->value(), digest, picosha2::k_digest_size))
+    {
+        std::stringstream str;
+        str << "Failed to parse " << module << " SHA256 for \"" << realm
+            << "\"";
+        throw std::runtime_error(str.str().c_str());
+    }
 }
 
-std::uint8_t HexCharsToByte(char a, char b)
+// a pattern is a sequence of bytes in hex separated by white space, in which ??
+// stands for any byte.  at least one byte must be given.
+bool ValidPattern(const std::string& pattern)
 {
-    auto const aVal = HexCharToByte(a);
-    auto const bVal = HexCharToByte(b);
+    std::stringstream str(pattern);
+    std::string token;
+    auto fixed = false;
 
-    return (aVal << 4) | bVal;
+    while (str >> token)
+    {
+        if (token == "??")
+            continue;
+
+        std::uint8_t byte;
+
+        if (token.length() != 2 || !HexToData(token.c_str(), &byte, 1))
+            return false;
+
+        fixed = true;
+    }
+
+    return fixed;
 }
 } // namespace
 
@@ -103,11 +132,26 @@ Config::Config(const TCHAR* filename)
     const bool us32 = sizeof(void*) == 4;
 
     _ourDll = parent / (us32 ? "wowreeb32.dll" : "wowreeb64.dll");
+
+    useAgent = false;
 }
 
 void Config::Reload()
 {
     entries.clear();
+    groups.clear();
+    clearWDB = false;
+    pipelinedLaunch = false;
+    debugLog = false;
+    predictLaunches = false;
+    warmPoolMemory = 0;
+    warmPoolExpiry = 0;
+    sampleInterval = 2000;
+    keyAgentTimeout = 0;
+    keyCheck.clear();
+    vault.reset();
+
+    fs::path vaultPath;
 
     auto text = ReadFile(_path);
 
@@ -132,10 +176,24 @@ void Config::Reload()
             ConfigEntry ins;
 
             ins.OurDll = _ourDll;
-            ins.OurMethod = "Load";
+            ins.OurMethod = "Boot";
             ZeroMemory(&ins.SHA256, sizeof(ins.SHA256));
+            ZeroMemory(&ins.CLRSHA256, sizeof(ins.CLRSHA256));
             ins.Console = false;
+            ins.WDB = WDBMode::Default;
+            ins.Prefetch = false;
+            ins.Prewarm = false;
             ins.Fov = 0.f;
+            ins.Process.AutoAffinity = false;
+            ins.Process.Priority = ProcessPriority::Default;
+            ins.Background.Enabled = false;
+            ins.Background.CpuRate = 0;
+            ins.Background.EcoQoS = false;
+            ins.Background.TrimWorkingSet = false;
+            ins.Background.Delay = 2000;
+            ins.Restart.Enabled = false;
+            ins.Restart.Window = 60;
+            ins.Restart.Limit = 2;
 
             for (auto r = n->first_attribute(); !!r; r = r->next_attribute())
             {
@@ -143,6 +201,15 @@ void Config::Reload()
 
                 if (rname == "Name")
                     ins.Name = r->value();
+                else if (rname == "Prewarm")
+                {
+                    std::string prewarmValue(r->value());
+
+                    std::transform(prewarmValue.begin(), prewarmValue.end(),
+                                   prewarmValue.begin(), ::toupper);
+
+                    ins.Prewarm = prewarmValue == "1" || prewarmValue == "TRUE";
+                }
                 else
                 {
                     std::stringstream str;
@@ -169,22 +236,7 @@ void Config::Reload()
                         if (rname == "Path")
                             ins.Path = r->value();
                         else if (rname == "SHA256")
-                        {
-                            if (r->value_size() != 2 * picosha2::k_digest_size)
-                            {
-                                std::stringstream str;
-                                str << "Exe SHA256 for \"" << ins.Name
-                                    << "\" is wrong size.  Should be "
-                                    << picosha2::k_digest_size << " bytes";
-                                throw std::runtime_error(str.str().c_str());
-                            }
-
-                            const std::string hash(r->value());
-
-                            for (auto i = 0u; i < sizeof(ins.SHA256); ++i)
-                                ins.SHA256[i] =
-                                    HexCharsToByte(hash[i * 2], hash[i * 2 + 1]);
-                        }
+                            ParseSHA256(cname, ins.Name, r, ins.SHA256);
                         else
                         {
                             std::stringstream str;
@@ -240,6 +292,72 @@ void Config::Reload()
 
                     ins.Console = consoleValue == "1" || consoleValue == "TRUE";
                 }
+                else if (cname == "Prefetch")
+                {
+                    std::string prefetchValue;
+
+                    for (auto r = c->first_attribute(); !!r;
+                         r = r->next_attribute())
+                    {
+                        const std::string rname(r->name());
+
+                        if (rname == "Value")
+                        {
+                            prefetchValue = std::string(r->value());
+
+                            std::transform(prefetchValue.begin(),
+                                           prefetchValue.end(),
+                                           prefetchValue.begin(), ::toupper);
+                        }
+                        else
+                        {
+                            std::stringstream str;
+                            str << "Unexpected " << cname << " attribute \""
+                                << rname << "\"";
+                            throw std::runtime_error(str.str().c_str());
+                        }
+                    }
+
+                    ins.Prefetch =
+                        prefetchValue == "1" || prefetchValue == "TRUE";
+                }
+                else if (cname == "WDB")
+                {
+                    for (auto r = c->first_attribute(); !!r;
+                         r = r->next_attribute())
+                    {
+                        const std::string rname(r->name());
+
+                        if (rname == "Mode")
+                        {
+                            std::string mode(r->value());
+
+                            std::transform(mode.begin(), mode.end(),
+                                           mode.begin(), ::toupper);
+
+                            if (mode == "KEEP")
+                                ins.WDB = WDBMode::Keep;
+                            else if (mode == "CLEAR")
+                                ins.WDB = WDBMode::Clear;
+                            else if (mode == "SNAPSHOT")
+                                ins.WDB = WDBMode::Snapshot;
+                            else
+                            {
+                                std::stringstream str;
+                                str << "Unrecognized WDB mode \"" << r->value()
+                                    << "\" for \"" << ins.Name << "\"";
+                                throw std::runtime_error(str.str().c_str());
+                            }
+                        }
+                        else
+                        {
+                            std::stringstream str;
+                            str << "Unexpected " << cname << " attribute \""
+                                << rname << "\"";
+                            throw std::runtime_error(str.str().c_str());
+                        }
+                    }
+                }
                 else if (cname == "Fov")
                 {
                     for (auto r = c->first_attribute(); !!r;
@@ -271,6 +389,150 @@ void Config::Reload()
                         }
                     }
                 }
+                else if (cname == "Process")
+                {
+                    for (auto r = c->first_attribute(); !!r;
+                         r = r->next_attribute())
+                    {
+                        const std::string rname(r->name());
+                        std::string value(r->value());
+
+                        std::transform(value.begin(), value.end(),
+                                       value.begin(), ::toupper);
+
+                        try
+                        {
+                            if (rname == "Affinity" && value == "AUTO")
+                                ins.Process.AutoAffinity = true;
+                            else if (rname == "Affinity")
+                                ins.Process.Affinity =
+                                    ParseProcessorList(r->value());
+                            else if (rname == "CpuSets")
+                                ins.Process.CpuSets =
+                                    ParseProcessorList(r->value());
+                            else if (rname == "Priority")
+                            {
+                                if (value == "IDLE")
+                                    ins.Process.Priority = ProcessPriority::Idle;
+                                else if (value == "BELOWNORMAL")
+                                    ins.Process.Priority =
+                                        ProcessPriority::BelowNormal;
+                                else if (value == "NORMAL")
+                                    ins.Process.Priority =
+                                        ProcessPriority::Normal;
+                                else if (value == "ABOVENORMAL")
+                                    ins.Process.Priority =
+                                        ProcessPriority::AboveNormal;
+                                else if (value == "HIGH")
+                                    ins.Process.Priority = ProcessPriority::High;
+                                else
+                                {
+                                    std::stringstream str;
+                                    str << "Unrecognized priority \""
+                                        << r->value() << "\"";
+                                    throw std::runtime_error(str.str().c_str());
+                                }
+                            }
+                            else
+                            {
+                                std::stringstream str;
+                                str << "Unexpected " << cname << " attribute \""
+                                    << rname << "\"";
+                                throw std::runtime_error(str.str().c_str());
+                            }
+                        }
+                        catch (std::runtime_error const& e)
+                        {
+                            std::stringstream str;
+                            str << e.what() << " for \"" << ins.Name << "\"";
+                            throw std::runtime_error(str.str().c_str());
+                        }
+                    }
+                }
+                else if (cname == "Background")
+                {
+                    ins.Background.Enabled = true;
+
+                    for (auto r = c->first_attribute(); !!r;
+                         r = r->next_attribute())
+                    {
+                        const std::string rname(r->name());
+                        std::string value(r->value());
+
+                        std::transform(value.begin(), value.end(),
+                                       value.begin(), ::toupper);
+
+                        try
+                        {
+                            if (rname == "CpuRate")
+                                ins.Background.CpuRate = std::stoul(value);
+                            else if (rname == "EcoQoS")
+                                ins.Background.EcoQoS =
+                                    value == "1" || value == "TRUE";
+                            else if (rname == "TrimWorkingSet")
+                                ins.Background.TrimWorkingSet =
+                                    value == "1" || value == "TRUE";
+                            else if (rname == "Delay")
+                                ins.Background.Delay = std::stoul(value);
+                            else
+                            {
+                                std::stringstream str;
+                                str << "Unexpected " << cname << " attribute \""
+                                    << rname << "\"";
+                                throw std::runtime_error(str.str().c_str());
+                            }
+                        }
+                        catch (std::logic_error const&)
+                        {
+                            std::stringstream str;
+                            str << "Failed to parse " << cname << " " << rname
+                                << " string \"" << r->value() << "\" for \""
+                                << ins.Name << "\"";
+                            throw std::runtime_error(str.str().c_str());
+                        }
+                    }
+
+                    if (ins.Background.CpuRate > 100)
+                    {
+                        std::stringstream str;
+                        str << "Background CpuRate for \"" << ins.Name
+                            << "\" must be a percentage";
+                        throw std::runtime_error(str.str().c_str());
+                    }
+                }
+                else if (cname == "Restart")
+                {
+                    ins.Restart.Enabled = true;
+
+                    for (auto r = c->first_attribute(); !!r;
+                         r = r->next_attribute())
+                    {
+                        const std::string rname(r->name());
+
+                        try
+                        {
+                            if (rname == "Window")
+                                ins.Restart.Window = std::stoul(r->value());
+                            else if (rname == "Limit")
+                                ins.Restart.Limit = std::stoul(r->value());
+                            else
+                            {
+                                std::stringstream str;
+                                str << "Unexpected " << cname << " attribute \""
+                                    << rname << "\"";
+                                throw std::runtime_error(str.str().c_str());
+                            }
+                        }
+                        catch (std::logic_error const&)
+                        {
+                            std::stringstream str;
+                            str << "Failed to parse " << cname << " " << rname
+                                << " string \"" << r->value() << "\" for \""
+                                << ins.Name << "\"";
+                            throw std::runtime_error(str.str().c_str());
+                        }
+                    }
+                }
                 else if (cname == "CLR")
                 {
                     for (auto r = c->first_attribute(); !!r;
@@ -284,6 +546,8 @@ void Config::Reload()
                             ins.CLRTypeName = r->value();
                         else if (rname == "Method")
                             ins.CLRMethodName = r->value();
+                        else if (rname == "SHA256")
+                            ParseSHA256(cname, ins.Name, r, ins.CLRSHA256);
                         else
                         {
                             std::stringstream str;
@@ -295,8 +559,7 @@ void Config::Reload()
                 }
                 else if (cname == "DLL")
                 {
-                    fs::path dll_path {};
-                    std::string dll_method {};
+                    NativeDll dll {};
 
                     for (auto r = c->first_attribute(); !!r;
                          r = r->next_attribute())
@@ -304,9 +567,11 @@ void Config::Reload()
                         const std::string rname(r->name());
 
                         if (rname == "Path")
-                            dll_path = r->value();
+                            dll.Path = r->value();
                         else if (rname == "Method")
-                            dll_method = r->value();
+                            dll.Method = r->value();
+                        else if (rname == "SHA256")
+                            ParseSHA256(cname, ins.Name, r, dll.SHA256);
                         else
                         {
                             std::stringstream str;
@@ -316,11 +581,131 @@ void Config::Reload()
                         }
                     }
 
-                    if (!dll_path.empty())
-                        ins.NativeDlls.emplace_back(dll_path, dll_method);
+                    if (!dll.Path.empty())
+                        ins.NativeDlls.push_back(dll);
+                }
+                else if (cname == "Signature")
+                {
+                    static const char* const targets[SignatureTargetCount] = {
+                        "CVar__Set",
+                        "RealmListCVar",
+                        "Idle",
+                        "CGlueMgr__m_pendingServerAlert",
+                        "Login",
+                        "FoV",
+                    };
+
+                    Signature signature {SignatureTargetCount, SignatureCode, 0,
+                                         ".text", ""};
+
+                    for (auto r = c->first_attribute(); !!r;
+                         r = r->next_attribute())
+                    {
+                        const std::string rname(r->name());
+                        std::string value(r->value());
+
+                        try
+                        {
+                            if (rname == "Name")
+                            {
+                                auto const target = std::find(
+                                    std::begin(targets), std::end(targets),
+                                    value);
+
+                                if (target == std::end(targets))
+                                {
+                                    std::stringstream str;
+                                    str << "Unrecognized signature name \""
+                                        << value << "\"";
+                                    throw std::runtime_error(str.str().c_str());
+                                }
+
+                                signature.Target = static_cast<SignatureTarget>(
+                                    target - std::begin(targets));
+                            }
+                            else if (rname == "Type")
+                            {
+                                std::transform(value.begin(), value.end(),
+                                               value.begin(), ::toupper);
+
+                                if (value == "CODE")
+                                    signature.Kind = SignatureCode;
+                                else if (value == "ABSOLUTE")
+                                    signature.Kind = SignatureAbsolute;
+                                else if (value == "RELATIVE")
+                                    signature.Kind = SignatureRelative;
+                                else
+                                {
+                                    std::stringstream str;
+                                    str << "Unrecognized signature type \""
+                                        << r->value() << "\"";
+                                    throw std::runtime_error(str.str().c_str());
+                                }
+                            }
+                            else if (rname == "Offset")
+                                signature.Displacement = std::stoi(value);
+                            else if (rname == "Section")
+                                signature.Section = value;
+                            else if (rname == "Pattern")
+                            {
+                                if (!ValidPattern(value))
+                                {
+                                    std::stringstream str;
+                                    str << "Malformed signature pattern \""
+                                        << value << "\"";
+                                    throw std::runtime_error(str.str().c_str());
+                                }
+
+                                signature.Pattern = value;
+                            }
+                            else
+                            {
+                                std::stringstream str;
+                                str << "Unexpected " << cname << " attribute \""
+                                    << rname << "\"";
+                                throw std::runtime_error(str.str().c_str());
+                            }
+                        }
+                        catch (std::logic_error const&)
+                        {
+                            std::stringstream str;
+                            str << "Failed to parse " << cname << " " << rname
+                                << " string \"" << r->value() << "\" for \""
+                                << ins.Name << "\"";
+                            throw std::runtime_error(str.str().c_str());
+                        }
+                        catch (std::runtime_error const& e)
+                        {
+                            std::stringstream str;
+                            str << e.what() << " for \"" << ins.Name << "\"";
+                            throw std::runtime_error(str.str().c_str());
+                        }
+                    }
+
+                    if (signature.Target == SignatureTargetCount ||
+                        signature.Pattern.empty())
+                    {
+                        std::stringstream str;
+                        str << "Signatures for \"" << ins.Name
+                            << "\" must have a Name and a Pattern";
+                        throw std::runtime_error(str.str().c_str());
+                    }
+
+                    for (auto const& existing : ins.Signatures)
+                        if (existing.Target == signature.Target)
+                        {
+                            std::stringstream str;
+                            str << "Multiple " << targets[signature.Target]
+                                << " signatures for \"" << ins.Name << "\"";
+                            throw std::runtime_error(str.str().c_str());
+                        }
+
+                    ins.Signatures.push_back(signature);
                 }
                 else if (cname == "Credentials")
                 {
+                    std::string account;
+
                     for (auto r = c->first_attribute(); !!r;
                          r = r->next_attribute())
                     {
@@ -330,6 +715,10 @@ void Config::Reload()
                             ins.Username = r->value();
                         else if (rname == "Password")
                             ins.Password = r->value();
+                        else if (rname == "Account")
+                            account = r->value();
+                        else if (rname == "Vault")
+                            ins.VaultRealm = r->value();
                         else
                         {
                             std::stringstream str;
@@ -338,6 +727,32 @@ void Config::Reload()
                             throw std::runtime_error(str.str().c_str());
                         }
                     }
+
+                    // an account names a username whose password is in the
+                    // vault, stored under this realm unless another is given
+                    if (!account.empty())
+                    {
+                        if (!ins.Username.empty() || !ins.Password.empty())
+                        {
+                            std::stringstream str;
+                            str << "Credentials for \"" << ins.Name
+                                << "\" have both an Account and a Username or "
+                                   "Password";
+                            throw std::runtime_error(str.str().c_str());
+                        }
+
+                        ins.Username = account;
+
+                        if (ins.VaultRealm.empty())
+                            ins.VaultRealm = ins.Name;
+                    }
+                    else if (!ins.VaultRealm.empty())
+                    {
+                        std::stringstream str;
+                        str << "Credentials for \"" << ins.Name
+                            << "\" have a Vault but no Account";
+                        throw std::runtime_error(str.str().c_str());
+                    }
                 }
                 else
                 {
@@ -349,10 +764,88 @@ void Config::Reload()
 
             entries.push_back(ins);
         }
+        else if (name == "Group")
+        {
+            ConfigGroup ins;
+
+            ins.Policy.Parallelism = GroupPolicy::DefaultParallelism;
+            ins.Policy.Stagger = 0;
+            ins.Policy.MinFreeMemory = 0;
+            ins.Policy.MaxDiskQueue = 0.f;
+
+            for (auto r = n->first_attribute(); !!r; r = r->next_attribute())
+            {
+                const std::string rname(r->name());
+
+                try
+                {
+                    if (rname == "Name")
+                        ins.Name = r->value();
+                    else if (rname == "Parallelism")
+                        ins.Policy.Parallelism = std::stoul(r->value());
+                    else if (rname == "Stagger")
+                        ins.Policy.Stagger = std::stoul(r->value());
+                    else if (rname == "MinFreeMemory")
+                        ins.Policy.MinFreeMemory = std::stoul(r->value());
+                    else if (rname == "MaxDiskQueue")
+                        ins.Policy.MaxDiskQueue = std::stof(r->value());
+                    else
+                    {
+                        std::stringstream str;
+                        str << "Unexpected " << name << " attribute \"" << rname
+                            << "\"";
+                        throw std::runtime_error(str.str().c_str());
+                    }
+                }
+                catch (std::logic_error const&)
+                {
+                    std::stringstream str;
+                    str << "Failed to parse " << name << " " << rname
+                        << " string \"" << r->value() << "\"";
+                    throw std::runtime_error(str.str().c_str());
+                }
+            }
+
+            if (ins.Name.empty())
+                throw std::runtime_error("Group entries must have a name");
+
+            if (!ins.Policy.Parallelism)
+                ins.Policy.Parallelism = 1;
+
+            for (auto c = n->first_node(); !!c; c = c->next_sibling())
+            {
+                const std::string cname(c->name());
+
+                if (cname != "Member")
+                {
+                    std::stringstream str;
+                    str << "Unexpected " << name << " node \"" << cname << "\"";
+                    throw std::runtime_error(str.str().c_str());
+                }
+
+                for (auto r = c->first_attribute(); !!r; r = r->next_attribute())
+                {
+                    const std::string rname(r->name());
+
+                    if (rname == "Realm")
+                        ins.Members.emplace_back(r->value());
+                    else
+                    {
+                        std::stringstream str;
+                        str << "Unexpected " << cname << " attribute \"" << rname
+                            << "\"";
+                        throw std::runtime_error(str.str().c_str());
+                    }
+                }
+            }
+
+            groups.push_back(ins);
+        }
         else if (name == "Config")
         {
             std::string configName;
             std::string configValue;
+            std::string configRaw;
 
             for (auto a = n->first_attribute(); !!a; a = a->next_attribute())
             {
@@ -362,7 +855,8 @@ void Config::Reload()
                     configName = std::string(a->value());
                 else if (aname == "Value")
                 {
-                    configValue = std::string(a->value());
+                    configRaw = std::string(a->value());
+                    configValue = configRaw;
 
                     std::transform(configValue.begin(), configValue.end(),
                                    configValue.begin(), ::toupper);
@@ -378,6 +872,45 @@ void Config::Reload()
 
             if (configName == "ClearWDB")
                 clearWDB = configValue == "1" || configValue == "TRUE";
+            else if (configName == "DebugLog")
+                debugLog = configValue == "1" || configValue == "TRUE";
+            else if (configName == "PipelinedLaunch")
+                pipelinedLaunch = configValue == "1" || configValue == "TRUE";
+            else if (configName == "PredictLaunches")
+                predictLaunches = configValue == "1" || configValue == "TRUE";
+            // credentials are case sensitive
+            else if (configName == "KeyCheck")
+                keyCheck = configRaw;
+            else if (configName == "Vault")
+                vaultPath = configRaw;
+            else if (configName == "WarmPoolMemory" ||
+                     configName == "WarmPoolExpiry" ||
+                     configName == "SampleInterval" ||
+                     configName == "KeyAgent")
+            {
+                unsigned int value;
+
+                try
+                {
+                    value = std::stoul(configValue);
+                }
+                catch (std::logic_error const&)
+                {
+                    std::stringstream str;
+                    str << "Failed to parse " << configName << " string \""
+                        << configValue << "\"";
+                    throw std::runtime_error(str.str().c_str());
+                }
+
+                if (configName == "WarmPoolMemory")
+                    warmPoolMemory = value;
+                else if (configName == "WarmPoolExpiry")
+                    warmPoolExpiry = value;
+                else if (configName == "KeyAgent")
+                    keyAgentTimeout = value;
+                else
+                    sampleInterval = value;
+            }
             else
             {
                 std::stringstream str;
@@ -392,67 +925,133 @@ void Config::Reload()
             throw std::runtime_error(str.str().c_str());
         }
     }
+
+    // groups may appear before the realms they refer to, so they are only
+    // checked once the whole file has been read
+    for (auto const& group : groups)
+    {
+        if (FindEntry(group.Name))
+        {
+            std::stringstream str;
+            str << "Group \"" << group.Name << "\" has the same name as a realm";
+            throw std::runtime_error(str.str().c_str());
+        }
+
+        for (auto const& member : group.Members)
+        {
+            if (!FindEntry(member))
+            {
+                std::stringstream str;
+                str << "Group \"" << group.Name << "\" refers to unknown realm \""
+                    << member << "\"";
+                throw std::runtime_error(str.str().c_str());
+            }
+        }
+    }
+
+    for (auto const& entry : entries)
+    {
+        if (!entry.VaultRealm.empty() && vaultPath.empty())
+        {
+            std::stringstream str;
+            str << "Realm \"" << entry.Name
+                << "\" uses an Account but no Vault is configured";
+            throw std::runtime_error(str.str().c_str());
+        }
+    }
+
+    // the vault is only mapped here.  accounts are looked up as they are
+    // launched.
+    if (!vaultPath.empty())
+    {
+        if (vaultPath.is_relative())
+            vaultPath = _path.parent_path() / vaultPath;
+
+        vault = std::make_shared<const Vault>(vaultPath);
+    }
+}
+
+std::string Config::CheckCredential() const
+{
+    if (!keyCheck.empty())
+        return keyCheck;
+
+    // the first credential found stands in for a missing key check
+    for (auto const& entry : entries)
+        if (!entry.Password.empty())
+            return entry.Password;
+
+    if (vault && vault->Count())
+        return std::string(vault->Record(0));
+
+    return {};
+}
+
+bool Config::CheckKey(const std::string& key) const
+{
+    auto const credential = CheckCredential();
+
+    SecureBuffer password(0);
+
+    return credential.empty() || DecryptCredential(key, credential, password);
 }
 
 bool Config::VerifyKey(const std::string& key)
 {
-    std::uint8_t keyRaw[AES_KEYLEN];
-    ::memset(keyRaw, 0, sizeof(keyRaw));
-    ::memcpy(keyRaw, key.c_str(), key.length());
+    if (!CheckKey(key))
+        return false;
 
-    for (auto& entry : entries)
-    {
-        if (entry.Password.empty())
-            continue;
+    this->key = key;
 
-        std::vector<std::uint8_t> buffer(entry.Password.length() / 2);
+    return true;
+}
 
-        // encrypted buffers must be mutile of AES_BLOCKLEN
-        if (buffer.size() % AES_BLOCKLEN)
-            return false;
+bool Config::VerifyAgent()
+{
+    auto const credential = CheckCredential();
 
-        // convert hex string into raw data inside the vector
-        for (auto i = 0u; i < buffer.size(); ++i)
-            buffer[i] =
-                HexCharsToByte(entry.Password[i * 2], entry.Password[i * 2 + 1]);
+    SecureBuffer password(0);
 
-        AES_ctx ctx;
-        ZeroMemory(&ctx, sizeof(ctx));
-        AES_init_ctx_iv(&ctx, keyRaw, Iv);
+    if (credential.empty() || !AgentDecrypt(credential, password))
+        return false;
 
-        AES_CBC_decrypt_buffer(&ctx, &buffer[0], buffer.size());
+    useAgent = true;
 
-        // remove PKCS7 padding
-        auto const pad = buffer[buffer.size() - 1];
+    return true;
+}
 
-        // values greater than this cannot be padding
-        if (pad < AES_BLOCKLEN)
-        {
-            // this should not be possible
-            if (pad >= buffer.size())
-                return false;
+std::vector<std::string> Config::GetCredentials() const
+{
+    std::vector<std::string> result;
 
-            for (auto i = 1; i <= pad; ++i)
-            {
-                if (buffer[buffer.size() - i] != pad)
-                    return false;
+    if (!keyCheck.empty())
+        result.push_back(keyCheck);
 
-                buffer[buffer.size() - i] = 0;
-            }
-        }
+    for (auto const& entry : entries)
+        if (!entry.Password.empty())
+            result.push_back(entry.Password);
 
-        // check for magic string to verify correctness
-        auto constexpr magicLen = sizeof(Magic) - 1;
+    if (vault)
+        for (auto i = 0u; i < vault->Count(); ++i)
+            result.emplace_back(vault->Record(i));
 
-        const std::string pass(reinterpret_cast<const char*>(&buffer[0]));
+    return result;
+}
 
-        if (pass.substr(0, magicLen) != Magic)
-            return false;
+const ConfigEntry* Config::FindEntry(const std::string& name) const
+{
+    for (auto const& entry : entries)
+        if (entry.Name == name)
+            return &entry;
 
-        entry.Password = pass.substr(magicLen);
-    }
+    return nullptr;
+}
 
-    this->key = key;
+const ConfigGroup* Config::FindGroup(const std::string& name) const
+{
+    for (auto const& group : groups)
+        if (group.Name == name)
+            return &group;
 
-    return true;
+    return nullptr;
 }
\ No newline at end of file
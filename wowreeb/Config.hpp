@@ -25,17 +25,55 @@
 
 #pragma once
 
+#include "GameSettings.hpp"
+#include "Governor.hpp"
 #include "PicoSHA2/picosha2.h"
+#include "Placement.hpp"
+#include "Scheduler.hpp"
+#include "Supervisor.hpp"
 #include "tiny-AES-c/aes.hpp"
 
 #include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <tchar.h>
 #include <vector>
 
 namespace fs = std::filesystem;
 
+class Vault;
+
+enum class WDBMode
+{
+    Default, // as specified by the global ClearWDB setting
+    Keep,
+    Clear,
+    Snapshot, // keep a separate cache for each realm
+};
+
+struct NativeDll
+{
+    fs::path Path;
+    std::string Method;
+
+    // optional.  all zero if the dll is not to be verified.
+    std::uint8_t SHA256[picosha2::k_digest_size];
+};
+
+// locates a client address by searching a section of the executable
+struct Signature
+{
+    SignatureTarget Target;
+    SignatureKind Kind;
+    int Displacement;
+
+    std::string Section;
+
+    // bytes in hex separated by spaces, with ?? for a byte which may be anything
+    std::string Pattern;
+};
+
 struct ConfigEntry
 {
     std::string Name;
@@ -47,27 +85,64 @@ struct ConfigEntry
 
     bool Console;
 
+    WDBMode WDB;
+
+    // read the client's data archives ahead into the page cache
+    bool Prefetch;
+
+    // keep a suspended client ready to be launched
+    bool Prewarm;
+
     float Fov;
 
+    // used when the client differs from the build the dll knows
+    std::vector<Signature> Signatures;
+
+    ProcessPlacement Process;
+
+    BackgroundPolicy Background;
+
+    RestartPolicy Restart;
+
     fs::path OurDll;
     std::string OurMethod;
 
-    std::vector<std::pair<fs::path, std::string>> NativeDlls;
+    std::vector<NativeDll> NativeDlls;
 
     fs::path CLRDll;
+    std::uint8_t CLRSHA256[picosha2::k_digest_size];
     std::string CLRTypeName;
     std::string CLRMethodName;
 
     std::string Username;
     std::string Password;
+
+    // when not empty, the password is not in the config file but in the vault,
+    // stored under this realm name and the username
+    std::string VaultRealm;
 };
 
-class Config
+// a set of realms which are launched together
+struct ConfigGroup
+{
+    std::string Name;
+
+    std::vector<std::string> Members;
+
+    GroupPolicy Policy;
+};
+
+// always owned by a shared_ptr, so that threads which outlive a launch, such as
+// those restarting clients, can keep it alive
+class Config : public std::enable_shared_from_this<Config>
 {
 private:
     fs::path _path;
     fs::path _ourDll;
 
+    // the credential against which a key is verified
+    std::string CheckCredential() const;
+
 public:
     static constexpr char Magic[] = "WOWREEB:";
     static constexpr std::uint8_t Iv[AES_BLOCKLEN] = {
@@ -76,15 +151,72 @@ public:
 
     // this isn't thread safe, but what could go wrong?
     std::vector<ConfigEntry> entries;
+    std::vector<ConfigGroup> groups;
 
     std::string key;
 
+    // any credential encrypted with the key, against which it is verified.  if
+    // absent, the first realm's credentials are used.
+    std::string keyCheck;
+
+    // credentials kept apart from the config file, or nullptr if there are none
+    std::shared_ptr<const Vault> vault;
+
     // when true, remove entire WDB folder before launching the client
     bool clearWDB;
 
+    // when true, write diagnostics such as launch timings to the debugger
+    bool debugLog;
+
+    // when true, create the suspended client while verifying its checksum and
+    // preparing its cache, only booting it once those have succeeded
+    bool pipelinedLaunch;
+
+    // when true, keep a history of launches and use it to verify and prefetch
+    // the realms likely to be launched next while the machine is idle
+    bool predictLaunches;
+
+    // megabytes of memory which suspended clients kept ready to be launched
+    // may use between them, or zero for no limit
+    unsigned int warmPoolMemory;
+
+    // seconds a suspended client may be kept without being launched, or zero
+    // for no limit
+    unsigned int warmPoolExpiry;
+
+    // milliseconds between samples of the resources used by running clients
+    unsigned int sampleInterval;
+
+    // minutes the key agent keeps the derived keys after it was last used, or
+    // zero to not use an agent
+    unsigned int keyAgentTimeout;
+
+    // true once the agent holds the keys, so that the other launcher can get
+    // them from it rather than being given the key
+    bool useAgent;
+
     Config(const TCHAR* filename);
 
     void Reload();
 
+    const fs::path& GetPath() const { return _path; }
+
+    // check a single credential rather than decrypting them all, which is
+    // instead done as each realm is launched.  true if there is none.
+    bool CheckKey(const std::string& key) const;
+
+    // as above, keeping the key if it is correct
     bool VerifyKey(const std::string& key);
+
+    // as above, but with the keys held by the agent
+    bool VerifyAgent();
+
+    // every credential in the config file and the vault
+    std::vector<std::string> GetCredentials() const;
+
+    // find the realm entry with the given name, or nullptr if there is none
+    const ConfigEntry* FindEntry(const std::string& name) const;
+
+    // find the group with the given name, or nullptr if there is none
+    const ConfigGroup* FindGroup(const std::string& name) const;
 };
\ No newline at end of file
@@ -0,0 +1,420 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Credentials.hpp"
+
+#include "Config.hpp"
+#include "Crypto.hpp"
+#include "Hex.hpp"
+#include "Kdf.hpp"
+#include "Log.hpp"
+#include "PicoSHA2/picosha2.h"
+#include "SecureBuffer.hpp"
+
+#include <Windows.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// how long unlocking may take on this machine when parameters are calibrated
+static constexpr auto UnlockTarget = std::chrono::milliseconds(500);
+
+static constexpr auto BlockLength = CryptoProvider::BlockLength;
+
+struct DerivedKey
+{
+    std::string Params;
+
+    // derivation happens outside keysMutex, once for each entry
+    std::once_flag Derived;
+
+    // the fingerprint of the key it was derived from, followed by the derived
+    // key
+    SecureBuffer Secret;
+
+    explicit DerivedKey(const std::string& params)
+        : Params(params),
+          Secret(picosha2::k_digest_size + CryptoProvider::KeyLength)
+    {
+    }
+};
+
+// entries are shared so that one replaced by a different key stays alive for
+// whoever is still deriving or reading it
+std::mutex keysMutex;
+std::vector<std::shared_ptr<DerivedKey>> keys;
+
+// calibration takes as long as unlocking, so it is not done under keysMutex
+std::mutex sessionMutex;
+std::unique_ptr<KdfParams> sessionParams;
+
+// an hmac-sha256 of the key under a key chosen afresh by each process, so that
+// what is kept to tell keys apart cannot be looked up as a plain hash could be
+void Fingerprint(const std::string& key, std::uint8_t* mac)
+{
+    static constexpr std::size_t PadLength = 64;
+
+    // the inner then outer padded key
+    static auto const pads = []
+    {
+        std::array<std::uint8_t, 2 * PadLength> result;
+        RandomBytes(result.data(), PadLength);
+
+        for (auto i = 0u; i < PadLength; ++i)
+        {
+            result[PadLength + i] = result[i] ^ 0x5c;
+            result[i] ^= 0x36;
+        }
+
+        return result;
+    }();
+
+    picosha2::hash256_one_by_one inner;
+    inner.process(pads.begin(), pads.begin() + PadLength);
+    inner.process(key.begin(), key.end());
+    inner.finish();
+    inner.get_hash_bytes(mac, mac + picosha2::k_digest_size);
+
+    picosha2::hash256_one_by_one outer;
+    outer.process(pads.begin() + PadLength, pads.end());
+    outer.process(mac, mac + picosha2::k_digest_size);
+    outer.finish();
+    outer.get_hash_bytes(mac, mac + picosha2::k_digest_size);
+}
+
+// derive the key once per session for each set of parameters.  only the lookup
+// happens under the lock, as many credentials may be decrypted at once and each
+// set of parameters takes as long as unlocking to derive.
+void GetDerivedKey(const std::string& key, const KdfParams& params,
+                   std::uint8_t* out)
+{
+    auto const name = FormatKdfParams(params);
+
+    std::uint8_t fingerprint[picosha2::k_digest_size];
+    Fingerprint(key, fingerprint);
+
+    std::shared_ptr<DerivedKey> entry;
+
+    {
+        std::lock_guard<std::mutex> guard(keysMutex);
+
+        auto existing = std::find_if(
+            keys.begin(), keys.end(),
+            [&name](const std::shared_ptr<DerivedKey>& derived)
+            { return derived->Params == name; });
+
+        // only the most recent key entered is kept for any parameters
+        if (existing != keys.end() &&
+            ::memcmp((*existing)->Secret.Data(), fingerprint,
+                     sizeof(fingerprint)))
+        {
+            keys.erase(existing);
+            existing = keys.end();
+        }
+
+        if (existing == keys.end())
+        {
+            auto derived = std::make_shared<DerivedKey>(name);
+            ::memcpy(derived->Secret.Data(), fingerprint, sizeof(fingerprint));
+
+            keys.push_back(derived);
+            existing = keys.end() - 1;
+        }
+
+        entry = *existing;
+    }
+
+    ::SecureZeroMemory(fingerprint, sizeof(fingerprint));
+
+    // concurrent callers with the same key wait here for the one deriving it,
+    // while other parameters proceed.  should it throw, the next caller retries.
+    std::call_once(entry->Derived,
+                   [&key, &params, &entry]
+                   {
+                       DeriveKey(key, params,
+                                 entry->Secret.Data() +
+                                     picosha2::k_digest_size);
+                   });
+
+    ::memcpy(out, entry->Secret.Data() + picosha2::k_digest_size,
+             CryptoProvider::KeyLength);
+}
+
+// check for the magic string which shows the key to be correct, and take the
+// password which follows it.  the decrypted buffer is wiped either way.
+bool Unwrap(std::uint8_t* data, std::size_t length, SecureBuffer& plaintext)
+{
+    auto constexpr magicLen = sizeof(Config::Magic) - 1;
+
+    // a password ends at the first nul, or its buffer
+    auto const end = std::find(data, data + length, 0);
+
+    auto const result =
+        static_cast<std::size_t>(end - data) >= magicLen &&
+        !::memcmp(data, Config::Magic, magicLen);
+
+    if (result)
+    {
+        plaintext = SecureBuffer(end - data - magicLen);
+
+        if (plaintext.Size())
+            ::memcpy(plaintext.Data(), data + magicLen, plaintext.Size());
+    }
+
+    ::SecureZeroMemory(data, length);
+
+    return result;
+}
+
+bool DecryptLegacy(const std::string& key, const std::string& credential,
+                   SecureBuffer& plaintext)
+{
+    // the key itself was the aes key, so cannot have been longer than one
+    if (key.length() > CryptoProvider::KeyLength)
+        return false;
+
+    std::vector<std::uint8_t> buffer;
+
+    // encrypted buffers must be multiple of BlockLength
+    if (!HexToData(credential, buffer) || buffer.empty() ||
+        buffer.size() % BlockLength)
+        return false;
+
+    std::uint8_t keyRaw[CryptoProvider::KeyLength] = {};
+    ::memcpy(keyRaw, key.c_str(), key.length());
+
+    GetCryptoProvider().Decrypt(keyRaw, Config::Iv, &buffer[0], buffer.size());
+    ::SecureZeroMemory(keyRaw, sizeof(keyRaw));
+
+    // remove PKCS7 padding.  a password which filled its last block was given
+    // none, so values which cannot be padding are left alone.
+    auto const pad = buffer[buffer.size() - 1];
+
+    if (pad < BlockLength)
+    {
+        if (pad >= buffer.size())
+            return false;
+
+        for (auto i = 1; i <= pad; ++i)
+        {
+            if (buffer[buffer.size() - i] != pad)
+                return false;
+
+            buffer[buffer.size() - i] = 0;
+        }
+    }
+
+    return Unwrap(&buffer[0], buffer.size(), plaintext);
+}
+
+// separate a current credential into its parameters and its iv and ciphertext
+bool SplitCredential(const std::string& credential, KdfParams& params,
+                     std::vector<std::uint8_t>& buffer)
+{
+    auto const split = credential.rfind('$');
+
+    // the iv is followed by at least one block
+    return !credential.empty() && credential[0] == '$' &&
+           ParseKdfParams(credential.substr(0, split), params) &&
+           HexToData(credential.substr(split + 1), buffer) &&
+           buffer.size() >= 2 * BlockLength && !(buffer.size() % BlockLength);
+}
+
+bool DecryptBuffer(const std::uint8_t* derived,
+                   std::vector<std::uint8_t>& buffer, SecureBuffer& plaintext)
+{
+    GetCryptoProvider().Decrypt(derived, &buffer[0], &buffer[BlockLength],
+                                buffer.size() - BlockLength);
+
+    // PKCS7 padding, which is always present
+    auto const pad = buffer[buffer.size() - 1];
+
+    if (!pad || pad > BlockLength)
+    {
+        ::SecureZeroMemory(&buffer[0], buffer.size());
+        return false;
+    }
+
+    for (auto i = 1; i <= pad; ++i)
+    {
+        if (buffer[buffer.size() - i] != pad)
+        {
+            ::SecureZeroMemory(&buffer[0], buffer.size());
+            return false;
+        }
+    }
+
+    return Unwrap(&buffer[BlockLength], buffer.size() - BlockLength - pad,
+                  plaintext);
+}
+} // namespace
+
+bool DecryptCredential(const std::string& key, const std::string& credential,
+                       SecureBuffer& plaintext)
+{
+    if (credential.empty() || credential[0] != '$')
+        return DecryptLegacy(key, credential, plaintext);
+
+    KdfParams params;
+    std::vector<std::uint8_t> buffer;
+
+    if (!SplitCredential(credential, params, buffer))
+        return false;
+
+    std::uint8_t derived[CryptoProvider::KeyLength];
+    GetDerivedKey(key, params, derived);
+
+    auto const result = DecryptBuffer(derived, buffer, plaintext);
+    ::SecureZeroMemory(derived, sizeof(derived));
+
+    if (!result)
+        return false;
+
+    // further credentials share this derivation
+    std::lock_guard<std::mutex> guard(sessionMutex);
+
+    if (!sessionParams)
+        sessionParams = std::make_unique<KdfParams>(params);
+
+    return true;
+}
+
+std::string CredentialParams(const std::string& credential)
+{
+    if (credential.empty() || credential[0] != '$')
+        return {};
+
+    return credential.substr(0, credential.rfind('$'));
+}
+
+bool DeriveCredentialKey(const std::string& key, const std::string& credential,
+                         SecureBuffer& derived)
+{
+    KdfParams params;
+
+    if (!ParseKdfParams(CredentialParams(credential), params))
+        return false;
+
+    derived = SecureBuffer(CryptoProvider::KeyLength);
+    GetDerivedKey(key, params, derived.Data());
+
+    return true;
+}
+
+bool DecryptDerived(const SecureBuffer& derived, const std::string& credential,
+                    SecureBuffer& plaintext)
+{
+    KdfParams params;
+    std::vector<std::uint8_t> buffer;
+
+    if (derived.Size() != CryptoProvider::KeyLength ||
+        !SplitCredential(credential, params, buffer))
+        return false;
+
+    return DecryptBuffer(derived.Data(), buffer, plaintext);
+}
+
+std::string EncryptCredential(const std::string& key,
+                              const std::string& plaintext)
+{
+    SecureBuffer buffer(plaintext.length());
+
+    if (!plaintext.empty())
+        ::memcpy(buffer.Data(), plaintext.data(), plaintext.length());
+
+    return EncryptCredential(key, buffer, GetSessionKdfParams());
+}
+
+std::string EncryptCredential(const std::string& key,
+                              const SecureBuffer& plaintext,
+                              const KdfParams& params)
+{
+    // the only purpose of the magic string is to give us a way to determine if
+    // the password is decrypted successfully later
+    auto constexpr magicLen = sizeof(Config::Magic) - 1;
+    auto const length = magicLen + plaintext.Size();
+
+    // the iv, then the padded plaintext
+    std::vector<std::uint8_t> buffer(BlockLength +
+                                     (length / BlockLength + 1) * BlockLength);
+
+    RandomBytes(&buffer[0], BlockLength);
+
+    auto const text = &buffer[BlockLength];
+    auto const pad =
+        static_cast<std::uint8_t>(buffer.size() - BlockLength - length);
+
+    ::memcpy(text, Config::Magic, magicLen);
+
+    if (plaintext.Size())
+        ::memcpy(text + magicLen, plaintext.Data(), plaintext.Size());
+
+    ::memset(text + length, pad, pad);
+
+    std::uint8_t derived[CryptoProvider::KeyLength];
+    GetDerivedKey(key, params, derived);
+
+    GetCryptoProvider().Encrypt(derived, &buffer[0], text,
+                                buffer.size() - BlockLength);
+    ::SecureZeroMemory(derived, sizeof(derived));
+
+    return FormatKdfParams(params) + "$" + DataToHex(buffer);
+}
+
+KdfParams CalibrateCredentialKdf()
+{
+    auto const start = std::chrono::steady_clock::now();
+    auto const params = CalibrateKdf(UnlockTarget);
+    auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    std::stringstream str;
+    str << "calibrated key derivation to " << FormatKdfParams(params)
+        << " in " << elapsed.count() << "ms";
+    DebugLog(str.str());
+
+    return params;
+}
+
+KdfParams GetSessionKdfParams()
+{
+    std::lock_guard<std::mutex> guard(sessionMutex);
+
+    if (!sessionParams)
+        sessionParams = std::make_unique<KdfParams>(CalibrateCredentialKdf());
+
+    return *sessionParams;
+}
@@ -0,0 +1,72 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Kdf.hpp"
+#include "SecureBuffer.hpp"
+
+#include <string>
+
+// credentials are hex encoded AES-256-CBC ciphertext of Config::Magic followed
+// by the password.  those written by earlier versions are encrypted under the
+// key itself, zero padded, with a fixed iv.  current ones name the parameters
+// of the kdf which derives their key, followed by a random iv and the
+// ciphertext: "<kdf params>$<iv><ciphertext>".
+
+// returns false if the key does not decrypt the credential.  the plaintext is
+// not terminated.
+bool DecryptCredential(const std::string& key, const std::string& credential,
+                       SecureBuffer& plaintext);
+
+// the parameters named at the start of a credential, or an empty string for one
+// in the legacy format
+std::string CredentialParams(const std::string& credential);
+
+// the aes key derived from the key for the parameters of a credential.  it
+// decrypts every credential sharing those parameters without the key itself.
+// returns false for credentials in the legacy format, which have none.
+bool DeriveCredentialKey(const std::string& key, const std::string& credential,
+                         SecureBuffer& derived);
+
+// returns false if the derived key is not the one for the credential
+bool DecryptDerived(const SecureBuffer& derived, const std::string& credential,
+                    SecureBuffer& plaintext);
+
+// encrypt with the key derivation of credentials already decrypted, so that a
+// single derivation serves every credential, or else with calibrated parameters
+std::string EncryptCredential(const std::string& key,
+                              const std::string& plaintext);
+
+// encrypt with the given key derivation
+std::string EncryptCredential(const std::string& key,
+                              const SecureBuffer& plaintext,
+                              const KdfParams& params);
+
+// fresh parameters which take the unlock target on this machine
+KdfParams CalibrateCredentialKdf();
+
+// the parameters with which EncryptCredential derives its key
+KdfParams GetSessionKdfParams();
@@ -0,0 +1,324 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Crypto.hpp"
+
+#include "Platform.hpp"
+#include "tiny-AES-c/aes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <wmmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+
+// msvc allows any instruction set's intrinsics anywhere
+#define TARGET(isa)
+#else
+#include <cpuid.h>
+
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+static_assert(CryptoProvider::KeyLength == AES_KEYLEN &&
+                  CryptoProvider::BlockLength == AES_BLOCKLEN,
+              "tiny-AES-c must be built with AES256");
+
+namespace
+{
+// the table driven implementation, which runs anywhere
+class SoftwareProvider : public CryptoProvider
+{
+public:
+    const char* Name() const override { return "tiny-AES-c"; }
+
+    void Encrypt(const std::uint8_t* key, const std::uint8_t* iv,
+                 std::uint8_t* data, std::size_t length) const override
+    {
+        AES_ctx ctx;
+        AES_init_ctx_iv(&ctx, key, iv);
+        AES_CBC_encrypt_buffer(&ctx, data, length);
+        ::SecureZeroMemory(&ctx, sizeof(ctx));
+    }
+
+    void Decrypt(const std::uint8_t* key, const std::uint8_t* iv,
+                 std::uint8_t* data, std::size_t length) const override
+    {
+        AES_ctx ctx;
+        AES_init_ctx_iv(&ctx, key, iv);
+        AES_CBC_decrypt_buffer(&ctx, data, length);
+        ::SecureZeroMemory(&ctx, sizeof(ctx));
+    }
+};
+
+// the AES-NI instructions.  each step of the key schedule needs its round
+// constant as an immediate, hence the template.
+class HardwareProvider : public CryptoProvider
+{
+private:
+    static constexpr int Rounds = 14;
+
+    using Schedule = __m128i[Rounds + 1];
+
+    TARGET("aes,sse2") static __m128i Shift(__m128i word)
+    {
+        word = _mm_xor_si128(word, _mm_slli_si128(word, 4));
+        word = _mm_xor_si128(word, _mm_slli_si128(word, 4));
+        return _mm_xor_si128(word, _mm_slli_si128(word, 4));
+    }
+
+    template <int Rcon>
+    TARGET("aes,sse2")
+    static void ExpandPair(__m128i& even, __m128i& odd, __m128i* out)
+    {
+        even = _mm_xor_si128(
+            Shift(even),
+            _mm_shuffle_epi32(_mm_aeskeygenassist_si128(odd, Rcon), 0xFF));
+        out[0] = even;
+
+        odd = _mm_xor_si128(
+            Shift(odd),
+            _mm_shuffle_epi32(_mm_aeskeygenassist_si128(even, 0), 0xAA));
+        out[1] = odd;
+    }
+
+    TARGET("aes,sse2")
+    static void ExpandKey(const std::uint8_t* key, Schedule& schedule)
+    {
+        auto even = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+        auto odd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 16));
+
+        schedule[0] = even;
+        schedule[1] = odd;
+
+        ExpandPair<0x01>(even, odd, &schedule[2]);
+        ExpandPair<0x02>(even, odd, &schedule[4]);
+        ExpandPair<0x04>(even, odd, &schedule[6]);
+        ExpandPair<0x08>(even, odd, &schedule[8]);
+        ExpandPair<0x10>(even, odd, &schedule[10]);
+        ExpandPair<0x20>(even, odd, &schedule[12]);
+
+        // the final round key has no partner
+        schedule[14] = _mm_xor_si128(
+            Shift(even),
+            _mm_shuffle_epi32(_mm_aeskeygenassist_si128(odd, 0x40), 0xFF));
+    }
+
+    // the equivalent inverse cipher runs the schedule backwards, with the
+    // inner round keys passed through InvMixColumns
+    TARGET("aes,sse2")
+    static void InvertKey(const Schedule& encrypt, Schedule& decrypt)
+    {
+        decrypt[0] = encrypt[Rounds];
+
+        for (auto i = 1; i < Rounds; ++i)
+            decrypt[i] = _mm_aesimc_si128(encrypt[Rounds - i]);
+
+        decrypt[Rounds] = encrypt[0];
+    }
+
+public:
+    const char* Name() const override { return "AES-NI"; }
+
+    TARGET("aes,sse2")
+    void Encrypt(const std::uint8_t* key, const std::uint8_t* iv,
+                 std::uint8_t* data, std::size_t length) const override
+    {
+        Schedule schedule;
+        ExpandKey(key, schedule);
+
+        auto chain = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+
+        // each block depends on the last, so encryption cannot be interleaved
+        for (auto offset = 0u; offset < length; offset += BlockLength)
+        {
+            auto const block = reinterpret_cast<__m128i*>(data + offset);
+
+            auto state = _mm_xor_si128(_mm_loadu_si128(block), chain);
+            state = _mm_xor_si128(state, schedule[0]);
+
+            for (auto r = 1; r < Rounds; ++r)
+                state = _mm_aesenc_si128(state, schedule[r]);
+
+            chain = _mm_aesenclast_si128(state, schedule[Rounds]);
+            _mm_storeu_si128(block, chain);
+        }
+
+        ::SecureZeroMemory(&schedule, sizeof(schedule));
+    }
+
+    TARGET("aes,sse2")
+    void Decrypt(const std::uint8_t* key, const std::uint8_t* iv,
+                 std::uint8_t* data, std::size_t length) const override
+    {
+        static constexpr std::size_t Lanes = 4;
+
+        Schedule encrypt, schedule;
+        ExpandKey(key, encrypt);
+        InvertKey(encrypt, schedule);
+        ::SecureZeroMemory(&encrypt, sizeof(encrypt));
+
+        auto chain = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+        auto const blocks = reinterpret_cast<__m128i*>(data);
+        auto const count = length / BlockLength;
+
+        std::size_t i = 0;
+
+        // every ciphertext block is known up front, so several are decrypted
+        // at once to hide the latency of each round
+        for (; i + Lanes <= count; i += Lanes)
+        {
+            __m128i cipher[Lanes], state[Lanes];
+
+            for (auto l = 0u; l < Lanes; ++l)
+            {
+                cipher[l] = _mm_loadu_si128(&blocks[i + l]);
+                state[l] = _mm_xor_si128(cipher[l], schedule[0]);
+            }
+
+            for (auto r = 1; r < Rounds; ++r)
+                for (auto l = 0u; l < Lanes; ++l)
+                    state[l] = _mm_aesdec_si128(state[l], schedule[r]);
+
+            for (auto l = 0u; l < Lanes; ++l)
+            {
+                state[l] = _mm_aesdeclast_si128(state[l], schedule[Rounds]);
+                _mm_storeu_si128(&blocks[i + l], _mm_xor_si128(state[l], chain));
+                chain = cipher[l];
+            }
+        }
+
+        for (; i < count; ++i)
+        {
+            auto const cipher = _mm_loadu_si128(&blocks[i]);
+            auto state = _mm_xor_si128(cipher, schedule[0]);
+
+            for (auto r = 1; r < Rounds; ++r)
+                state = _mm_aesdec_si128(state, schedule[r]);
+
+            state = _mm_aesdeclast_si128(state, schedule[Rounds]);
+            _mm_storeu_si128(&blocks[i], _mm_xor_si128(state, chain));
+            chain = cipher;
+        }
+
+        ::SecureZeroMemory(&schedule, sizeof(schedule));
+    }
+};
+
+bool HasAesInstructions()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+
+    // ecx bit 25
+    return !!(info[2] & (1 << 25));
+#else
+    unsigned int eax, ebx, ecx, edx;
+
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && !!(ecx & (1 << 25));
+#endif
+}
+
+// the CBC-AES256 example from NIST SP 800-38A, F.2.5 and F.2.6
+bool PassesSelfTest(const CryptoProvider& provider)
+{
+    static constexpr std::uint8_t key[] = {
+        0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae,
+        0xf0, 0x85, 0x7d, 0x77, 0x81, 0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61,
+        0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4};
+    static constexpr std::uint8_t iv[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05,
+                                          0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+                                          0x0c, 0x0d, 0x0e, 0x0f};
+    static constexpr std::uint8_t plain[] = {
+        0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e,
+        0x11, 0x73, 0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03,
+        0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51, 0x30,
+        0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19,
+        0x1a, 0x0a, 0x52, 0xef, 0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b,
+        0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+    static constexpr std::uint8_t cipher[] = {
+        0xf5, 0x8c, 0x4c, 0x04, 0xd6, 0xe5, 0xf1, 0xba, 0x77, 0x9e, 0xab,
+        0xfb, 0x5f, 0x7b, 0xfb, 0xd6, 0x9c, 0xfc, 0x4e, 0x96, 0x7e, 0xdb,
+        0x80, 0x8d, 0x67, 0x9f, 0x77, 0x7b, 0xc6, 0x70, 0x2c, 0x7d, 0x39,
+        0xf2, 0x33, 0x69, 0xa9, 0xd9, 0xba, 0xcf, 0xa5, 0x30, 0xe2, 0x63,
+        0x04, 0x23, 0x14, 0x61, 0xb2, 0xeb, 0x05, 0xe2, 0xc3, 0x9b, 0xe9,
+        0xfc, 0xda, 0x6c, 0x19, 0x07, 0x8c, 0x6a, 0x9d, 0x1b};
+
+    static constexpr auto block = CryptoProvider::BlockLength;
+
+    std::uint8_t buffer[sizeof(plain)];
+    ::memcpy(buffer, plain, sizeof(plain));
+
+    provider.Encrypt(key, iv, buffer, sizeof(buffer));
+
+    if (::memcmp(buffer, cipher, sizeof(cipher)))
+        return false;
+
+    provider.Decrypt(key, iv, buffer, sizeof(buffer));
+
+    if (::memcmp(buffer, plain, sizeof(plain)))
+        return false;
+
+    // a lone block is not interleaved, and is chained from the one before it
+    ::memcpy(buffer, cipher + 3 * block, block);
+
+    provider.Decrypt(key, cipher + 2 * block, buffer, block);
+
+    return !::memcmp(buffer, plain + 3 * block, block);
+}
+} // namespace
+
+bool IsSupported(CryptoImplementation implementation)
+{
+    return implementation == CryptoImplementation::Software ||
+           HasAesInstructions();
+}
+
+const CryptoProvider& GetCryptoProvider(CryptoImplementation implementation)
+{
+    static const SoftwareProvider software;
+    static const HardwareProvider hardware;
+
+    if (implementation == CryptoImplementation::AesNi)
+        return hardware;
+
+    return software;
+}
+
+const CryptoProvider& GetCryptoProvider()
+{
+    static const CryptoProvider* const provider =
+        &GetCryptoProvider(
+            IsSupported(CryptoImplementation::AesNi) &&
+                    PassesSelfTest(
+                        GetCryptoProvider(CryptoImplementation::AesNi)) ?
+                CryptoImplementation::AesNi :
+                CryptoImplementation::Software);
+
+    return *provider;
+}
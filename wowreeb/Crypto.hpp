@@ -0,0 +1,65 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// AES-256 in CBC mode over whole blocks.  every provider produces the same
+// output, so credentials encrypted by one can be decrypted by any other.
+class CryptoProvider
+{
+public:
+    static constexpr std::size_t KeyLength = 32;
+    static constexpr std::size_t BlockLength = 16;
+
+    virtual ~CryptoProvider() = default;
+
+    virtual const char* Name() const = 0;
+
+    // length must be a multiple of BlockLength.  data is processed in place.
+    virtual void Encrypt(const std::uint8_t* key, const std::uint8_t* iv,
+                         std::uint8_t* data, std::size_t length) const = 0;
+    virtual void Decrypt(const std::uint8_t* key, const std::uint8_t* iv,
+                         std::uint8_t* data, std::size_t length) const = 0;
+};
+
+// the providers which may be chosen
+enum class CryptoImplementation
+{
+    Software, // tiny-AES-c
+    AesNi,
+};
+
+// true if this processor supports the implementation
+bool IsSupported(CryptoImplementation implementation);
+
+// the given provider, which must be supported
+const CryptoProvider& GetCryptoProvider(CryptoImplementation implementation);
+
+// the fastest provider supported by this processor.  a hardware provider is
+// only chosen once it has reproduced a known answer.
+const CryptoProvider& GetCryptoProvider();
@@ -0,0 +1,240 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "ExportCache.hpp"
+
+#include <Windows.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+struct ModuleExports
+{
+    std::uintmax_t Size;
+    fs::file_time_type Modified;
+
+    std::unordered_map<std::string, std::uint32_t> Exports;
+};
+
+std::mutex cacheMutex;
+std::map<fs::path, ModuleExports> cache;
+
+class PeImage
+{
+private:
+    std::vector<std::uint8_t> _data;
+    std::vector<IMAGE_SECTION_HEADER> _sections;
+
+public:
+    PeImage(const fs::path& file)
+    {
+        std::ifstream fd(file, std::ios::binary | std::ios::ate);
+
+        if (!fd)
+            throw std::runtime_error("Unable to open module");
+
+        const size_t size = static_cast<size_t>(fd.tellg());
+        fd.seekg(0, std::ios::beg);
+
+        _data.resize(size);
+
+        if (size > 0)
+            fd.read(reinterpret_cast<char*>(&_data[0]), _data.size());
+
+        if (!fd)
+            throw std::runtime_error("Unable to read module");
+    }
+
+    template <typename T>
+    T Read(size_t offset) const
+    {
+        if (offset > _data.size() || _data.size() - offset < sizeof(T))
+            throw std::runtime_error("Malformed module");
+
+        T result;
+        ::memcpy(&result, &_data[offset], sizeof(T));
+        return result;
+    }
+
+    std::string ReadString(size_t offset) const
+    {
+        if (offset >= _data.size())
+            throw std::runtime_error("Malformed module");
+
+        auto const start = reinterpret_cast<const char*>(&_data[offset]);
+        auto const end = static_cast<const char*>(
+            ::memchr(start, 0, _data.size() - offset));
+
+        if (!end)
+            throw std::runtime_error("Malformed module");
+
+        return std::string(start, end);
+    }
+
+    void ReadSections(size_t offset, unsigned int count)
+    {
+        _sections.clear();
+
+        for (auto i = 0u; i < count; ++i)
+            _sections.push_back(Read<IMAGE_SECTION_HEADER>(
+                offset + i * sizeof(IMAGE_SECTION_HEADER)));
+    }
+
+    size_t RvaToOffset(std::uint32_t rva) const
+    {
+        for (auto const& section : _sections)
+        {
+            auto const size =
+                (std::max)(section.Misc.VirtualSize, section.SizeOfRawData);
+
+            if (rva >= section.VirtualAddress &&
+                rva - section.VirtualAddress < size)
+                return rva - section.VirtualAddress + section.PointerToRawData;
+        }
+
+        throw std::runtime_error("Malformed module");
+    }
+};
+
+std::unordered_map<std::string, std::uint32_t> ParseExports(const fs::path& file)
+{
+    std::unordered_map<std::string, std::uint32_t> result;
+
+    PeImage image(file);
+
+    auto const dos = image.Read<IMAGE_DOS_HEADER>(0);
+
+    if (dos.e_magic != IMAGE_DOS_SIGNATURE ||
+        image.Read<DWORD>(dos.e_lfanew) != IMAGE_NT_SIGNATURE)
+        throw std::runtime_error("Module is not a PE image");
+
+    auto const fileHeader =
+        image.Read<IMAGE_FILE_HEADER>(dos.e_lfanew + sizeof(DWORD));
+    auto const optionalOffset =
+        dos.e_lfanew + sizeof(DWORD) + sizeof(IMAGE_FILE_HEADER);
+
+    IMAGE_DATA_DIRECTORY exportDir;
+
+    switch (image.Read<WORD>(optionalOffset))
+    {
+        case IMAGE_NT_OPTIONAL_HDR32_MAGIC:
+        {
+            auto const optional =
+                image.Read<IMAGE_OPTIONAL_HEADER32>(optionalOffset);
+
+            if (optional.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_EXPORT)
+                return result;
+
+            exportDir = optional.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+            break;
+        }
+        case IMAGE_NT_OPTIONAL_HDR64_MAGIC:
+        {
+            auto const optional =
+                image.Read<IMAGE_OPTIONAL_HEADER64>(optionalOffset);
+
+            if (optional.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_EXPORT)
+                return result;
+
+            exportDir = optional.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+            break;
+        }
+        default:
+            throw std::runtime_error("Unrecognized PE optional header");
+    }
+
+    if (!exportDir.VirtualAddress || !exportDir.Size)
+        return result;
+
+    image.ReadSections(optionalOffset + fileHeader.SizeOfOptionalHeader,
+                       fileHeader.NumberOfSections);
+
+    auto const exports = image.Read<IMAGE_EXPORT_DIRECTORY>(
+        image.RvaToOffset(exportDir.VirtualAddress));
+
+    if (!exports.NumberOfNames)
+        return result;
+
+    auto const names = image.RvaToOffset(exports.AddressOfNames);
+    auto const ordinals = image.RvaToOffset(exports.AddressOfNameOrdinals);
+    auto const functions = image.RvaToOffset(exports.AddressOfFunctions);
+
+    for (auto i = 0u; i < exports.NumberOfNames; ++i)
+    {
+        auto const nameRva = image.Read<DWORD>(names + i * sizeof(DWORD));
+        auto const ordinal = image.Read<WORD>(ordinals + i * sizeof(WORD));
+
+        if (ordinal >= exports.NumberOfFunctions)
+            throw std::runtime_error("Malformed module");
+
+        auto const rva = image.Read<DWORD>(functions + ordinal * sizeof(DWORD));
+
+        // forwarded exports point to a string within the export directory and
+        // cannot be resolved without loading the other module
+        if (rva >= exportDir.VirtualAddress &&
+            rva - exportDir.VirtualAddress < exportDir.Size)
+            continue;
+
+        result.emplace(image.ReadString(image.RvaToOffset(nameRva)), rva);
+    }
+
+    return result;
+}
+} // namespace
+
+std::uint32_t FindExportRva(const fs::path& module, const std::string& name)
+{
+    auto const path = fs::absolute(module);
+    auto const size = fs::file_size(path);
+    auto const modified = fs::last_write_time(path);
+
+    std::lock_guard<std::mutex> guard(cacheMutex);
+
+    auto entry = cache.find(path);
+
+    if (entry == cache.end() || entry->second.Size != size ||
+        entry->second.Modified != modified)
+    {
+        ModuleExports ins;
+
+        ins.Size = size;
+        ins.Modified = modified;
+        ins.Exports = ParseExports(path);
+
+        entry = cache.insert_or_assign(path, std::move(ins)).first;
+    }
+
+    auto const result = entry->second.Exports.find(name);
+
+    return result == entry->second.Exports.end() ? 0 : result->second;
+}
@@ -0,0 +1,563 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "FakeBackend.hpp"
+
+#include "ProcessBackend.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// the stand-in lives until it is terminated or nothing refers to it any longer
+class FakeBackend::StandIn
+{
+private:
+    // the stand-in's address space, from which every allocation is made
+    static constexpr std::size_t AddressSpace = 1024 * 1024;
+
+    // the space our dll occupies once it has been loaded
+    static constexpr std::size_t ImageSize = 64 * 1024;
+
+    // the code written for each remote call
+    static constexpr std::size_t StubSize = 64;
+
+    struct Request
+    {
+        std::function<std::uintptr_t()> Task;
+        std::promise<std::uintptr_t> Result;
+    };
+
+    const unsigned int _id;
+    const std::chrono::microseconds _latency;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _exitSignal;
+    std::deque<Request> _requests;
+
+    std::unique_ptr<std::uint8_t[]> _memory;
+    std::size_t _used;
+    std::uint8_t* _module;
+
+    bool _running;
+    bool _exited;
+    unsigned int _exitCode;
+
+    ProcessPlacement _placement;
+    ClientThrottle _throttle;
+
+    // started last, once everything it uses has been
+    std::thread _thread;
+
+    void Serve()
+    {
+        for (;;)
+        {
+            Request request;
+
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock,
+                           [this]() { return _exited || !_requests.empty(); });
+
+                if (_requests.empty())
+                    return;
+
+                request = std::move(_requests.front());
+                _requests.pop_front();
+
+                // anything asked of a process as it exits fails
+                if (_exited)
+                {
+                    request.Result.set_exception(std::make_exception_ptr(
+                        std::runtime_error("The client has exited")));
+                    continue;
+                }
+            }
+
+            if (_latency.count())
+                std::this_thread::sleep_for(_latency);
+
+            try
+            {
+                request.Result.set_value(request.Task());
+            }
+            catch (...)
+            {
+                request.Result.set_exception(std::current_exception());
+            }
+        }
+    }
+
+    // only to be used by a task, on the stand-in's own thread
+    std::uint8_t* Allocate(std::size_t size)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        if (AddressSpace - _used < size)
+            throw std::runtime_error("The client is out of memory");
+
+        auto const result = &_memory[_used];
+        _used += size;
+
+        return result;
+    }
+
+    void Exit(unsigned int exitCode)
+    {
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+
+            if (_exited)
+                return;
+
+            _exited = true;
+            _exitCode = exitCode;
+        }
+
+        _wake.notify_all();
+        _exitSignal.notify_all();
+    }
+
+    // perform the task on the stand-in's thread and wait for its result.  this
+    // is what makes a round-trip.
+    std::uintptr_t Run(std::function<std::uintptr_t()> task)
+    {
+        std::future<std::uintptr_t> result;
+
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+
+            if (_exited)
+                throw std::runtime_error("The client has exited");
+
+            _requests.emplace_back();
+            _requests.back().Task = std::move(task);
+            result = _requests.back().Result.get_future();
+        }
+
+        _wake.notify_one();
+
+        return result.get();
+    }
+
+public:
+    StandIn(unsigned int id, std::chrono::microseconds latency)
+        : _id(id), _latency(latency), _memory(new std::uint8_t[AddressSpace]),
+          _used(0), _module(nullptr), _running(false), _exited(false),
+          _exitCode(0), _placement(), _throttle(),
+          _thread(&StandIn::Serve, this)
+    {
+    }
+
+    ~StandIn()
+    {
+        Exit(EXIT_SUCCESS);
+        _thread.join();
+    }
+
+    StandIn(const StandIn&) = delete;
+    StandIn& operator=(const StandIn&) = delete;
+
+    unsigned int GetId() const { return _id; }
+
+    std::uint8_t* GetModule()
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _module;
+    }
+
+    // write the path of the dll into the stand-in and have it load the dll
+    void Inject(const fs::path& dll)
+    {
+        Run(
+            [this, path = dll.wstring()]()
+            {
+                auto const size = (path.length() + 1) * sizeof(wchar_t);
+                ::memcpy(Allocate(size), path.c_str(), size);
+
+                auto const image = Allocate(ImageSize);
+
+                std::lock_guard<std::mutex> guard(_mutex);
+                _module = image;
+
+                return std::uintptr_t(0);
+            });
+    }
+
+    // calls within our dll succeed, and anything else crashes the client
+    std::uintptr_t Call(const std::uint8_t* func)
+    {
+        return Run(
+            [this, func]()
+            {
+                Allocate(StubSize);
+
+                auto const module = GetModule();
+
+                if (!module || func < module || func >= module + ImageSize)
+                {
+                    // as an access violation would
+                    Exit(0xC0000005);
+                    throw std::runtime_error("The client crashed");
+                }
+
+                return std::uintptr_t(0);
+            });
+    }
+
+    void Resume()
+    {
+        Run(
+            [this]()
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                _running = true;
+                return std::uintptr_t(0);
+            });
+    }
+
+    void Eject()
+    {
+        Run(
+            [this]()
+            {
+                Allocate(StubSize);
+
+                std::lock_guard<std::mutex> guard(_mutex);
+
+                if (!_module)
+                    throw std::runtime_error("The dll is not loaded");
+
+                _module = nullptr;
+
+                return std::uintptr_t(0);
+            });
+    }
+
+    // like terminating a process, this does not wait for anything the client
+    // was asked to do
+    void Terminate() { Exit(EXIT_FAILURE); }
+
+    bool WaitForExit(unsigned int milliseconds)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _exitSignal.wait_for(lock, std::chrono::milliseconds(milliseconds),
+                              [this]() { return _exited; });
+    }
+
+    bool HasExited()
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _exited;
+    }
+
+    unsigned int GetExitCode()
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _exitCode;
+    }
+
+    std::size_t GetPrivateBytes()
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _used;
+    }
+
+    void Place(const ProcessPlacement& placement)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        if (_running)
+            throw std::runtime_error("The client is already running");
+
+        _placement = placement;
+    }
+
+    void Apply(const ClientThrottle& throttle)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _throttle = throttle;
+    }
+};
+
+namespace
+{
+class FakeClient : public ClientProcess
+{
+private:
+    BackendCounters& _counters;
+    std::shared_ptr<FakeBackend::StandIn> _standIn;
+
+public:
+    FakeClient(BackendCounters& counters,
+               std::shared_ptr<FakeBackend::StandIn> standIn)
+        : _counters(counters), _standIn(std::move(standIn))
+    {
+    }
+
+    unsigned int GetId() const override { return _standIn->GetId(); }
+
+    std::uint8_t* GetModule() const override { return _standIn->GetModule(); }
+
+    std::uintptr_t Call(const std::uint8_t* func) override
+    {
+        ++_counters.RemoteCalls;
+        ++_counters.Allocations;
+        ++_counters.Writes;
+        ++_counters.Reads;
+
+        return _standIn->Call(func);
+    }
+
+    std::size_t GetPrivateBytes() const override
+    {
+        return _standIn->GetPrivateBytes();
+    }
+
+    void Place(const ProcessPlacement& placement) override
+    {
+        _standIn->Place(placement);
+    }
+
+    // a stand-in never outlives us
+    void TieToLauncher(bool) override {}
+
+    void Resume() override
+    {
+        ++_counters.Resumes;
+        _standIn->Resume();
+    }
+
+    void Terminate() override
+    {
+        ++_counters.Terminations;
+        _standIn->Terminate();
+    }
+
+    void Eject() override
+    {
+        ++_counters.Ejections;
+        ++_counters.Allocations;
+        ++_counters.Writes;
+        ++_counters.Reads;
+
+        _standIn->Eject();
+    }
+
+    bool WaitForExit(unsigned int milliseconds) override
+    {
+        return _standIn->WaitForExit(milliseconds);
+    }
+};
+
+class FakeProcess : public RunningProcess
+{
+private:
+    std::shared_ptr<FakeBackend::StandIn> _standIn;
+
+public:
+    FakeProcess(std::shared_ptr<FakeBackend::StandIn> standIn)
+        : _standIn(std::move(standIn))
+    {
+    }
+
+    bool HasExited() override { return _standIn->HasExited(); }
+
+    unsigned int GetExitCode() override { return _standIn->GetExitCode(); }
+
+    bool Sample(ProcessSample& sample) override
+    {
+        sample.CpuTime = std::chrono::microseconds(0);
+        sample.WorkingSet = sample.PrivateBytes = _standIn->GetPrivateBytes();
+        sample.Handles = 0;
+        sample.ReadBytes = sample.WriteBytes = 0;
+
+        return true;
+    }
+
+    void Apply(const ClientThrottle& throttle) override
+    {
+        _standIn->Apply(throttle);
+    }
+};
+} // namespace
+
+FakeBackend::FakeBackend(std::chrono::microseconds latency)
+    : _latency(latency), _nextId(0), _foreground(0),
+      _availableMemory((std::numeric_limits<std::uint64_t>::max)()),
+      _diskQueueLength(0.0)
+{
+}
+
+std::shared_ptr<FakeBackend::StandIn> FakeBackend::Find(unsigned int pid)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+
+    auto const i = _clients.find(pid);
+
+    return i == _clients.end() ? nullptr : i->second.lock();
+}
+
+void FakeBackend::SetForeground(unsigned int pid)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _foreground = pid;
+}
+
+void FakeBackend::SetAvailableMemory(std::uint64_t bytes)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _availableMemory = bytes;
+}
+
+void FakeBackend::SetDiskQueueLength(double length)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    _diskQueueLength = length;
+}
+
+std::size_t FakeBackend::LiveClients()
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+
+    return std::count_if(_clients.begin(), _clients.end(),
+                         [](const auto& client)
+                         {
+                             auto const standIn = client.second.lock();
+                             return standIn && !standIn->HasExited();
+                         });
+}
+
+bool FakeBackend::Is32Bit(const fs::path&)
+{
+    // the stand-ins are always of our own architecture
+    return sizeof(void*) == 4;
+}
+
+CoreTopology FakeBackend::GetPhysicalCores()
+{
+    CoreTopology result;
+
+    for (auto i = 0u; i < (std::max)(std::thread::hardware_concurrency(), 1u);
+         ++i)
+        result.push_back({i});
+
+    return result;
+}
+
+bool FakeBackend::GetAvailableMemory(std::uint64_t& bytes)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    bytes = _availableMemory;
+    return true;
+}
+
+bool FakeBackend::GetDiskQueueLength(double& length)
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    length = _diskQueueLength;
+    return true;
+}
+
+unsigned int FakeBackend::GetForegroundProcess()
+{
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _foreground;
+}
+
+std::unique_ptr<RunningProcess> FakeBackend::Open(unsigned int pid)
+{
+    auto standIn = Find(pid);
+
+    if (!standIn)
+        throw std::runtime_error("No such process");
+
+    return std::make_unique<FakeProcess>(std::move(standIn));
+}
+
+std::unique_ptr<ClientProcess>
+FakeBackend::CreateSuspended(const fs::path&, const std::vector<std::wstring>&,
+                             const fs::path& dll)
+{
+    ++Counters.Launches;
+    ++Counters.Injections;
+    ++Counters.Allocations;
+    ++Counters.Writes;
+
+    std::shared_ptr<StandIn> standIn;
+
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+
+        // as on windows, process ids are multiples of four
+        _nextId += 4;
+        standIn = std::make_shared<StandIn>(_nextId, _latency);
+
+        // forget the clients which no longer exist
+        for (auto i = _clients.begin(); i != _clients.end();)
+            i = i->second.expired() ? _clients.erase(i) : std::next(i);
+
+        _clients[_nextId] = standIn;
+    }
+
+    standIn->Inject(dll);
+
+    return std::make_unique<FakeClient>(Counters, std::move(standIn));
+}
+
+std::shared_future<unsigned int> FakeBackend::StartLauncher(
+    const fs::path&, const std::vector<std::pair<std::string, std::string>>&)
+{
+    throw std::logic_error("The fake backend cannot start a launcher");
+}
+
+bool FakeBackend::ReportToLauncher(unsigned int)
+{
+    return false;
+}
+
+void FakeBackend::StartDetached(
+    const fs::path&, const std::vector<std::pair<std::string, std::string>>&)
+{
+    throw std::logic_error("The fake backend cannot start a launcher");
+}
@@ -0,0 +1,102 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "ProcessBackend.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// a backend which starts no processes, so that the launch pipeline can be
+// measured on any platform.  each client is a stand-in with an address space of
+// its own which is served by a thread of its own, so that every operation on it
+// is a genuine round-trip.  the reads, writes and allocations it performs are
+// counted as the hadesmem backend counts them.
+class FakeBackend : public ProcessBackend
+{
+public:
+    // a client, as far as the launcher can tell
+    class StandIn;
+
+private:
+    const std::chrono::microseconds _latency;
+
+    std::mutex _mutex;
+    unsigned int _nextId;
+    unsigned int _foreground;
+    std::uint64_t _availableMemory;
+    double _diskQueueLength;
+    std::map<unsigned int, std::weak_ptr<StandIn>> _clients;
+
+    std::shared_ptr<StandIn> Find(unsigned int pid);
+
+public:
+    // each round-trip takes at least the given time, to model the cost of
+    // crossing into another process
+    explicit FakeBackend(
+        std::chrono::microseconds latency = std::chrono::microseconds(0));
+
+    // make the given client the one which owns the foreground window
+    void SetForeground(unsigned int pid);
+
+    // the machine has plenty of memory and idle disks until told otherwise
+    void SetAvailableMemory(std::uint64_t bytes);
+    void SetDiskQueueLength(double length);
+
+    // clients which have been created and have not yet exited
+    std::size_t LiveClients();
+
+    bool Is32Bit(const fs::path& exe) override;
+
+    CoreTopology GetPhysicalCores() override;
+
+    bool GetAvailableMemory(std::uint64_t& bytes) override;
+
+    bool GetDiskQueueLength(double& length) override;
+
+    unsigned int GetForegroundProcess() override;
+
+    std::unique_ptr<RunningProcess> Open(unsigned int pid) override;
+
+    std::unique_ptr<ClientProcess>
+    CreateSuspended(const fs::path& exe, const std::vector<std::wstring>& args,
+                    const fs::path& dll) override;
+
+    // there is no other launcher, so these throw or fail
+    std::shared_future<unsigned int> StartLauncher(
+        const fs::path& exe,
+        const std::vector<std::pair<std::string, std::string>>& env) override;
+
+    bool ReportToLauncher(unsigned int pid) override;
+
+    void StartDetached(
+        const fs::path& exe,
+        const std::vector<std::pair<std::string, std::string>>& env) override;
+};
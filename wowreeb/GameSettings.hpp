@@ -0,0 +1,269 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cwchar>
+#include <string>
+
+// the launcher passes its settings to the game through a named shared memory
+// section.  the section begins with the GameSettings header, which is followed
+// by the variable length data it references.  all offsets are relative to the
+// start of the header so that each process can map the section anywhere.
+
+#define GAME_SETTINGS_MAGIC   0x42525747 // 'GWRB'
+#define GAME_SETTINGS_VERSION 3
+
+// progress reported by the game, polled by the launcher
+enum Milestone : long
+{
+    MilestoneSettingsMapped = 1 << 0,
+    MilestoneHookApplied = 1 << 1,
+    MilestoneAuthServerSet = 1 << 2,
+    MilestoneLoginSent = 1 << 3,
+    MilestoneLoadComplete = 1 << 4,
+};
+
+// outcome of each step performed by the boot entry point
+enum StepStatus : std::uint32_t
+{
+    StepNotRun = 0,
+    StepSucceeded,
+    StepFailed,             // Value holds the failing return value
+    StepLoadLibraryFailed,  // Value holds the last error
+    StepProcedureNotFound,  // Value holds the last error
+};
+
+// client addresses which may be located by signature rather than by the
+// offsets built in to the dll
+enum SignatureTarget : std::uint32_t
+{
+    SignatureCVarSet = 0,
+    SignatureRealmListCVar,
+    SignatureIdle,
+    SignaturePendingServerAlert,
+    SignatureLogin,
+    SignatureFoV,
+    SignatureTargetCount,
+};
+
+// how the address is derived from the place at which the pattern matched,
+// plus the signature's displacement
+enum SignatureKind : std::uint32_t
+{
+    SignatureCode = 0,  // that place is the address
+    SignatureAbsolute,  // a pointer to the address is stored there
+    SignatureRelative,  // a 32 bit offset from the end of it is stored there
+};
+
+#pragma pack(push, 1)
+struct SettingsStepResult
+{
+    std::uint32_t Status;
+    std::uint32_t Value;
+};
+
+struct SettingsString
+{
+    std::uint32_t Offset;
+    std::uint32_t Length; // in characters, excluding the null terminator
+};
+
+struct SettingsNativeDll
+{
+    SettingsString Path;   // wide
+    SettingsString Method; // narrow, may be empty
+
+    SettingsStepResult Result;
+};
+
+struct SettingsSignature
+{
+    std::uint32_t Target; // SignatureTarget
+    std::uint32_t Kind;   // SignatureKind
+    std::int32_t Displacement;
+
+    SettingsString Section; // narrow, such as ".text"
+    SettingsString Pattern; // narrow, such as "55 8B EC ?? A1"
+};
+
+// this structure is used within the game so it knows what we have told it to do
+struct GameSettings
+{
+    std::uint32_t Magic;
+    std::uint32_t Version;
+    std::uint32_t Size; // total size of the header and all data following it
+
+    // bitmask of Milestone values.  kept four byte aligned for interlocked access
+    volatile long Milestones;
+
+    SettingsString AuthServer;
+
+    bool FoVSet;
+    float FoV;
+
+    bool CredentialsSet;
+    SettingsString Username;
+    SettingsString Password;
+
+    SettingsString CLRPath;       // wide
+    SettingsString CLRTypeName;   // wide
+    SettingsString CLRMethodName; // wide
+
+    std::uint32_t NativeDllCount;
+    std::uint32_t NativeDlls; // offset of a SettingsNativeDll array
+
+    // the SHA256 of the client executable, under which the addresses found by
+    // signature are remembered.  only set when there are signatures.
+    bool ExeHashSet;
+    std::uint8_t ExeHash[32];
+
+    std::uint32_t SignatureCount;
+    std::uint32_t Signatures; // offset of a SettingsSignature array
+
+    // written by the game as each boot step completes
+    SettingsStepResult LoadResult;
+    SettingsStepResult CLRResult;
+};
+#pragma pack(pop)
+
+static_assert(offsetof(GameSettings, Milestones) % 4 == 0,
+              "Milestones must be aligned");
+
+inline std::wstring GameSettingsSectionName(unsigned int processId)
+{
+    return L"Local\\wowreeb-settings-" + std::to_wstring(processId);
+}
+
+template <typename T = char>
+T* GetSettingsString(GameSettings* settings, const SettingsString& str)
+{
+    return reinterpret_cast<T*>(reinterpret_cast<std::uint8_t*>(settings) +
+                                str.Offset);
+}
+
+template <typename T = char>
+const T* GetSettingsString(const GameSettings* settings,
+                           const SettingsString& str)
+{
+    return reinterpret_cast<const T*>(
+        reinterpret_cast<const std::uint8_t*>(settings) + str.Offset);
+}
+
+inline SettingsNativeDll* GetSettingsNativeDlls(GameSettings* settings)
+{
+    return reinterpret_cast<SettingsNativeDll*>(
+        reinterpret_cast<std::uint8_t*>(settings) + settings->NativeDlls);
+}
+
+inline const SettingsNativeDll*
+GetSettingsNativeDlls(const GameSettings* settings)
+{
+    return reinterpret_cast<const SettingsNativeDll*>(
+        reinterpret_cast<const std::uint8_t*>(settings) + settings->NativeDlls);
+}
+
+inline const SettingsSignature*
+GetSettingsSignatures(const GameSettings* settings)
+{
+    return reinterpret_cast<const SettingsSignature*>(
+        reinterpret_cast<const std::uint8_t*>(settings) + settings->Signatures);
+}
+
+// ensure that everything referenced by the header lies within the section, so
+// that a malformed section cannot cause us to read outside of the mapping
+inline bool ValidateGameSettings(const GameSettings* settings, size_t viewSize)
+{
+    if (viewSize < sizeof(GameSettings) ||
+        settings->Magic != GAME_SETTINGS_MAGIC ||
+        settings->Version != GAME_SETTINGS_VERSION || settings->Size > viewSize)
+        return false;
+
+    auto const valid = [settings](const SettingsString& str, size_t charSize)
+    {
+        auto const end = static_cast<std::uint64_t>(str.Offset) +
+                         (static_cast<std::uint64_t>(str.Length) + 1) * charSize;
+
+        if (str.Offset < sizeof(GameSettings) || end > settings->Size)
+            return false;
+
+        // strings must be null terminated
+        auto const data = reinterpret_cast<const std::uint8_t*>(settings) +
+                          str.Offset + str.Length * charSize;
+
+        for (auto i = 0u; i < charSize; ++i)
+            if (data[i])
+                return false;
+
+        return true;
+    };
+
+    if (!valid(settings->AuthServer, sizeof(char)) ||
+        !valid(settings->Username, sizeof(char)) ||
+        !valid(settings->Password, sizeof(char)) ||
+        !valid(settings->CLRPath, sizeof(wchar_t)) ||
+        !valid(settings->CLRTypeName, sizeof(wchar_t)) ||
+        !valid(settings->CLRMethodName, sizeof(wchar_t)))
+        return false;
+
+    auto const dllsEnd =
+        static_cast<std::uint64_t>(settings->NativeDlls) +
+        static_cast<std::uint64_t>(settings->NativeDllCount) *
+            sizeof(SettingsNativeDll);
+
+    if (settings->NativeDllCount > 0 &&
+        (settings->NativeDlls < sizeof(GameSettings) || dllsEnd > settings->Size))
+        return false;
+
+    auto const dlls = GetSettingsNativeDlls(settings);
+
+    for (auto i = 0u; i < settings->NativeDllCount; ++i)
+        if (!valid(dlls[i].Path, sizeof(wchar_t)) ||
+            !valid(dlls[i].Method, sizeof(char)))
+            return false;
+
+    auto const signaturesEnd =
+        static_cast<std::uint64_t>(settings->Signatures) +
+        static_cast<std::uint64_t>(settings->SignatureCount) *
+            sizeof(SettingsSignature);
+
+    if (settings->SignatureCount > 0 &&
+        (settings->Signatures < sizeof(GameSettings) ||
+         signaturesEnd > settings->Size))
+        return false;
+
+    auto const signatures = GetSettingsSignatures(settings);
+
+    for (auto i = 0u; i < settings->SignatureCount; ++i)
+        if (signatures[i].Target >= SignatureTargetCount ||
+            signatures[i].Kind > SignatureRelative ||
+            !valid(signatures[i].Section, sizeof(char)) ||
+            !valid(signatures[i].Pattern, sizeof(char)))
+            return false;
+
+    return true;
+}
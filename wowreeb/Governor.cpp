@@ -0,0 +1,152 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Governor.hpp"
+
+#include "ProcessBackend.hpp"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+static constexpr auto PollInterval = std::chrono::milliseconds(250);
+
+struct GovernedClient
+{
+    std::unique_ptr<RunningProcess> Process;
+    unsigned int Id;
+    BackgroundPolicy Policy;
+    ThrottleTracker Tracker;
+};
+
+std::mutex clientsMutex;
+std::vector<GovernedClient> clients;
+bool polling = false;
+
+// a single thread watches every client, and exits once none remain
+void Poll()
+{
+    auto& backend = GetProcessBackend();
+
+    for (;;)
+    {
+        std::this_thread::sleep_for(PollInterval);
+
+        auto const foreground = backend.GetForegroundProcess();
+        auto const now = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> guard(clientsMutex);
+
+        for (auto i = clients.begin(); i != clients.end();)
+        {
+            if (i->Process->HasExited())
+            {
+                i = clients.erase(i);
+                continue;
+            }
+
+            ClientThrottle throttle;
+
+            if (i->Tracker.Update(i->Policy, i->Id == foreground, now,
+                                  throttle))
+                i->Process->Apply(throttle);
+
+            ++i;
+        }
+
+        if (clients.empty())
+        {
+            polling = false;
+            return;
+        }
+    }
+}
+} // namespace
+
+ClientThrottle DecideThrottle(const BackgroundPolicy& policy, bool foreground,
+                              std::chrono::milliseconds background)
+{
+    ClientThrottle result {};
+
+    if (!policy.Enabled || foreground ||
+        background < std::chrono::milliseconds(policy.Delay))
+        return result;
+
+    result.CpuRate = policy.CpuRate;
+    result.EcoQoS = policy.EcoQoS;
+    result.TrimWorkingSet = policy.TrimWorkingSet;
+
+    return result;
+}
+
+bool ThrottleTracker::Update(const BackgroundPolicy& policy, bool foreground,
+                             std::chrono::steady_clock::time_point now,
+                             ClientThrottle& throttle)
+{
+    if (foreground != Foreground)
+    {
+        Foreground = foreground;
+        Since = now;
+    }
+
+    throttle = DecideThrottle(
+        policy, Foreground,
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - Since));
+
+    if (throttle == Applied)
+        return false;
+
+    Applied = throttle;
+
+    return true;
+}
+
+void Govern(unsigned int pid, const BackgroundPolicy& policy)
+{
+    if (!policy.Enabled)
+        return;
+
+    GovernedClient client;
+
+    client.Process = GetProcessBackend().Open(pid);
+    client.Id = pid;
+    client.Policy = policy;
+    client.Tracker.Since = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> guard(clientsMutex);
+
+    clients.push_back(std::move(client));
+
+    if (!polling)
+    {
+        polling = true;
+        std::thread(Poll).detach();
+    }
+}
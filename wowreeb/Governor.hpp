@@ -0,0 +1,92 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+
+// how a client is restrained while it is not in the foreground
+struct BackgroundPolicy
+{
+    bool Enabled;
+
+    // percentage of the machine's processor time the client may use.  zero
+    // leaves it uncapped.
+    unsigned int CpuRate;
+
+    // ask the system to run the client on efficient processors at reduced
+    // clock speeds
+    bool EcoQoS;
+
+    // return the client's memory to the system when it is first restrained
+    bool TrimWorkingSet;
+
+    // milliseconds the client must spend in the background before it is
+    // restrained, so that briefly switching windows costs nothing
+    unsigned int Delay;
+};
+
+// the restraints applied to a client at a moment in time
+struct ClientThrottle
+{
+    unsigned int CpuRate;
+    bool EcoQoS;
+    bool TrimWorkingSet;
+
+    bool operator==(const ClientThrottle& other) const
+    {
+        return CpuRate == other.CpuRate && EcoQoS == other.EcoQoS &&
+               TrimWorkingSet == other.TrimWorkingSet;
+    }
+
+    bool operator!=(const ClientThrottle& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// decide the restraints for a client which has been in the background for the
+// given time, or in the foreground if that is zero
+ClientThrottle DecideThrottle(const BackgroundPolicy& policy, bool foreground,
+                              std::chrono::milliseconds background);
+
+// follows a client from one poll to the next, so that only changes to its
+// restraints are applied.  its working set is therefore trimmed once each time
+// it moves to the background.
+struct ThrottleTracker
+{
+    bool Foreground = true;
+    std::chrono::steady_clock::time_point Since;
+    ClientThrottle Applied {};
+
+    // note whether the client is in the foreground at the given time.  returns
+    // true if its restraints must change to throttle.
+    bool Update(const BackgroundPolicy& policy, bool foreground,
+                std::chrono::steady_clock::time_point now,
+                ClientThrottle& throttle);
+};
+
+// restrain the given client whenever it is in the background, until it exits
+void Govern(unsigned int pid, const BackgroundPolicy& policy);
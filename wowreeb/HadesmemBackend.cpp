@@ -0,0 +1,826 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "ProcessBackend.hpp"
+
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <hadesmem/acl.hpp>
+#include <hadesmem/call.hpp>
+#include <hadesmem/injector.hpp>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// these depend on the types declared by windows.h
+#include <Pdh.h>
+#include <Psapi.h>
+
+#pragma comment(lib, "asmjit.lib")
+#pragma comment(lib, "pdh.lib")
+#pragma comment(lib, "psapi.lib")
+#pragma comment(lib, "udis86.lib")
+
+namespace
+{
+DWORD PriorityClass(ProcessPriority priority)
+{
+    switch (priority)
+    {
+        case ProcessPriority::Idle:
+            return IDLE_PRIORITY_CLASS;
+        case ProcessPriority::BelowNormal:
+            return BELOW_NORMAL_PRIORITY_CLASS;
+        case ProcessPriority::AboveNormal:
+            return ABOVE_NORMAL_PRIORITY_CLASS;
+        case ProcessPriority::High:
+            return HIGH_PRIORITY_CLASS;
+        default:
+            return NORMAL_PRIORITY_CLASS;
+    }
+}
+
+// cpu sets were introduced in windows 10, so they are resolved at runtime to
+// keep the launcher working on older versions
+void SetCpuSets(HANDLE process, const std::vector<unsigned int>& processors)
+{
+    using GetSystemCpuSetInformationT =
+        BOOL(WINAPI*)(PSYSTEM_CPU_SET_INFORMATION, ULONG, PULONG, HANDLE, ULONG);
+    using SetProcessDefaultCpuSetsT = BOOL(WINAPI*)(HANDLE, const ULONG*, ULONG);
+
+    auto const kernel32 = ::GetModuleHandleA("kernel32.dll");
+    auto const getInformation = reinterpret_cast<GetSystemCpuSetInformationT>(
+        ::GetProcAddress(kernel32, "GetSystemCpuSetInformation"));
+    auto const setDefault = reinterpret_cast<SetProcessDefaultCpuSetsT>(
+        ::GetProcAddress(kernel32, "SetProcessDefaultCpuSets"));
+
+    if (!getInformation || !setDefault)
+        throw std::runtime_error("CPU sets require Windows 10 or later");
+
+    ULONG length = 0;
+    getInformation(nullptr, 0, &length, nullptr, 0);
+
+    std::vector<std::uint8_t> buffer(length);
+
+    if (!length || !getInformation(reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(
+                                       &buffer[0]),
+                                   length, &length, nullptr, 0))
+        throw std::runtime_error("GetSystemCpuSetInformation failed");
+
+    // cpu sets are identified by opaque ids, so find those belonging to the
+    // requested logical processors
+    std::vector<ULONG> ids;
+
+    for (ULONG offset = 0; offset < length;)
+    {
+        auto const info =
+            reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(&buffer[offset]);
+
+        if (info->Type == CpuSetInformation)
+        {
+            auto const processor = info->CpuSet.Group * 64u +
+                                   info->CpuSet.LogicalProcessorIndex;
+
+            if (std::find(processors.begin(), processors.end(), processor) !=
+                processors.end())
+                ids.push_back(info->CpuSet.Id);
+        }
+
+        offset += info->Size;
+    }
+
+    if (ids.empty())
+        throw std::runtime_error("No CPU sets match the requested processors");
+
+    if (!setDefault(process, &ids[0], static_cast<ULONG>(ids.size())))
+        throw std::runtime_error("SetProcessDefaultCpuSets failed");
+}
+
+// execution speed throttling was introduced in windows 10, so it is resolved at
+// runtime to keep the launcher working on older versions
+void SetEcoQoS(HANDLE process, bool enable)
+{
+    using SetProcessInformationT =
+        BOOL(WINAPI*)(HANDLE, PROCESS_INFORMATION_CLASS, LPVOID, DWORD);
+
+    static auto const setInformation = reinterpret_cast<SetProcessInformationT>(
+        ::GetProcAddress(::GetModuleHandleA("kernel32.dll"),
+                         "SetProcessInformation"));
+
+    if (!setInformation)
+        return;
+
+    PROCESS_POWER_THROTTLING_STATE state;
+    ZeroMemory(&state, sizeof(state));
+
+    state.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+    state.ControlMask = PROCESS_POWER_THROTTLING_EXECUTION_SPEED;
+    state.StateMask = enable ? PROCESS_POWER_THROTTLING_EXECUTION_SPEED : 0;
+
+    setInformation(process, ProcessPowerThrottling, &state, sizeof(state));
+}
+
+// our environment block with the given variables replaced.  variables with an
+// empty value are removed.
+std::vector<char>
+MakeEnvironment(const std::vector<std::pair<std::string, std::string>>& env)
+{
+    auto const current = ::GetEnvironmentStringsA();
+
+    if (!current)
+        throw std::runtime_error("GetEnvironmentStrings failed");
+
+    std::vector<char> result;
+
+    for (auto var = current; *var; var += ::strlen(var) + 1)
+    {
+        // the search begins after the first character because the variables
+        // which hold the current directory of each drive begin with '='
+        const std::string entry(var);
+        auto const name = entry.substr(0, entry.find('=', 1));
+
+        auto const replaced = std::any_of(
+            env.begin(), env.end(),
+            [&name](const std::pair<std::string, std::string>& v)
+            { return !::_stricmp(v.first.c_str(), name.c_str()); });
+
+        if (!replaced)
+            result.insert(result.end(), var, var + entry.length() + 1);
+    }
+
+    ::FreeEnvironmentStringsA(current);
+
+    for (auto const& v : env)
+    {
+        if (v.second.empty())
+            continue;
+
+        auto const entry = v.first + "=" + v.second;
+        result.insert(result.end(), entry.c_str(),
+                      entry.c_str() + entry.length() + 1);
+    }
+
+    // the block ends with an empty string, and must hold at least one
+    if (result.empty())
+        result.push_back('\0');
+
+    result.push_back('\0');
+
+    return result;
+}
+
+class DiskQueue
+{
+private:
+    PDH_HQUERY _query;
+    PDH_HCOUNTER _counter;
+
+public:
+    DiskQueue() : _query(nullptr), _counter(nullptr)
+    {
+        if (::PdhOpenQueryW(nullptr, 0, &_query) != ERROR_SUCCESS)
+        {
+            _query = nullptr;
+            return;
+        }
+
+        if (::PdhAddEnglishCounterW(
+                _query, L"\\PhysicalDisk(_Total)\\Current Disk Queue Length", 0,
+                &_counter) != ERROR_SUCCESS)
+        {
+            ::PdhCloseQuery(_query);
+            _query = nullptr;
+        }
+    }
+
+    ~DiskQueue()
+    {
+        if (_query)
+            ::PdhCloseQuery(_query);
+    }
+
+    DiskQueue(const DiskQueue&) = delete;
+    DiskQueue& operator=(const DiskQueue&) = delete;
+
+    // returns false if the counter is unavailable
+    bool Length(double& length)
+    {
+        if (!_query || ::PdhCollectQueryData(_query) != ERROR_SUCCESS)
+            return false;
+
+        PDH_FMT_COUNTERVALUE value;
+
+        if (::PdhGetFormattedCounterValue(_counter, PDH_FMT_DOUBLE, nullptr,
+                                          &value) != ERROR_SUCCESS)
+            return false;
+
+        length = value.doubleValue;
+        return true;
+    }
+};
+
+// the handle of the pipe through which a launcher started by StartLauncher
+// reports the id of its client
+static constexpr char EnvReport[] = "WOWREEB_REPORT";
+
+static constexpr DWORD RunningRights =
+    PROCESS_SET_QUOTA | PROCESS_TERMINATE | PROCESS_SET_INFORMATION |
+    PROCESS_QUERY_INFORMATION | PROCESS_VM_READ | SYNCHRONIZE;
+
+std::uint64_t FileTimeValue(const FILETIME& time)
+{
+    return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) |
+           time.dwLowDateTime;
+}
+
+class WindowsProcess : public RunningProcess
+{
+private:
+    HANDLE _process;
+    HANDLE _job;
+
+public:
+    WindowsProcess(unsigned int pid) : _job(nullptr)
+    {
+        _process = ::OpenProcess(RunningRights, FALSE, pid);
+
+        if (!_process)
+            throw std::runtime_error("OpenProcess failed");
+    }
+
+    ~WindowsProcess()
+    {
+        if (_job)
+            ::CloseHandle(_job);
+
+        ::CloseHandle(_process);
+    }
+
+    WindowsProcess(const WindowsProcess&) = delete;
+    WindowsProcess& operator=(const WindowsProcess&) = delete;
+
+    bool HasExited() override
+    {
+        return ::WaitForSingleObject(_process, 0) != WAIT_TIMEOUT;
+    }
+
+    unsigned int GetExitCode() override
+    {
+        DWORD exitCode = 0;
+        ::GetExitCodeProcess(_process, &exitCode);
+        return static_cast<unsigned int>(exitCode);
+    }
+
+    bool Sample(ProcessSample& sample) override
+    {
+        FILETIME creation, exit, kernel, user;
+        PROCESS_MEMORY_COUNTERS_EX memory;
+        IO_COUNTERS io;
+        DWORD handles;
+
+        if (!::GetProcessTimes(_process, &creation, &exit, &kernel, &user) ||
+            !::GetProcessMemoryInfo(
+                _process, reinterpret_cast<PPROCESS_MEMORY_COUNTERS>(&memory),
+                sizeof(memory)) ||
+            !::GetProcessIoCounters(_process, &io) ||
+            !::GetProcessHandleCount(_process, &handles))
+            return false;
+
+        // process times are given in units of 100ns
+        sample.CpuTime = std::chrono::microseconds(
+            (FileTimeValue(kernel) + FileTimeValue(user)) / 10);
+        sample.WorkingSet = memory.WorkingSetSize;
+        sample.PrivateBytes = memory.PrivateUsage;
+        sample.Handles = handles;
+        sample.ReadBytes = io.ReadTransferCount;
+        sample.WriteBytes = io.WriteTransferCount;
+
+        return true;
+    }
+
+    void Apply(const ClientThrottle& throttle) override
+    {
+        // processor time is capped with a job object, which the client is
+        // placed in alone.  closing the job does not end the client.  versions
+        // of windows before 8 do not allow a process to belong to more than one
+        // job, so the cap is skipped if this fails.
+        if (throttle.CpuRate && !_job)
+        {
+            _job = ::CreateJobObjectW(nullptr, nullptr);
+
+            if (_job && !::AssignProcessToJobObject(_job, _process))
+            {
+                ::CloseHandle(_job);
+                _job = nullptr;
+            }
+        }
+
+        if (_job)
+        {
+            JOBOBJECT_CPU_RATE_CONTROL_INFORMATION rate;
+            ZeroMemory(&rate, sizeof(rate));
+
+            // the rate is given in hundredths of a percent
+            if (throttle.CpuRate)
+            {
+                rate.ControlFlags = JOB_OBJECT_CPU_RATE_CONTROL_ENABLE |
+                                    JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP;
+                rate.CpuRate = (std::min)(throttle.CpuRate, 100u) * 100;
+            }
+
+            ::SetInformationJobObject(_job, JobObjectCpuRateControlInformation,
+                                      &rate, sizeof(rate));
+        }
+
+        SetEcoQoS(_process, throttle.EcoQoS);
+
+        if (throttle.TrimWorkingSet)
+            ::SetProcessWorkingSetSize(_process, static_cast<SIZE_T>(-1),
+                                       static_cast<SIZE_T>(-1));
+    }
+};
+
+class HadesmemClient : public ClientProcess
+{
+private:
+    BackendCounters& _counters;
+    hadesmem::CreateAndInjectData _data;
+
+    // the job which ties the client to us.  it is closed when we exit.
+    HANDLE _job;
+
+    void SetKillOnClose(bool kill)
+    {
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits;
+        ZeroMemory(&limits, sizeof(limits));
+
+        if (kill)
+            limits.BasicLimitInformation.LimitFlags =
+                JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+
+        if (!::SetInformationJobObject(_job,
+                                       JobObjectExtendedLimitInformation,
+                                       &limits, sizeof(limits)))
+            throw std::runtime_error("SetInformationJobObject failed");
+    }
+
+public:
+    HadesmemClient(BackendCounters& counters, hadesmem::CreateAndInjectData data)
+        : _counters(counters), _data(std::move(data)), _job(nullptr)
+    {
+    }
+
+    ~HadesmemClient()
+    {
+        if (_job)
+            ::CloseHandle(_job);
+    }
+
+    HadesmemClient(const HadesmemClient&) = delete;
+    HadesmemClient& operator=(const HadesmemClient&) = delete;
+
+    unsigned int GetId() const override
+    {
+        return static_cast<unsigned int>(_data.GetProcess().GetId());
+    }
+
+    std::uint8_t* GetModule() const override
+    {
+        return reinterpret_cast<std::uint8_t*>(_data.GetModule());
+    }
+
+    std::uintptr_t Call(const std::uint8_t* func) override
+    {
+        // the call stub is written to memory allocated within the client, and
+        // the return value read back from it
+        ++_counters.RemoteCalls;
+        ++_counters.Allocations;
+        ++_counters.Writes;
+        ++_counters.Reads;
+
+        auto const result = hadesmem::Call(
+            _data.GetProcess(), reinterpret_cast<std::uintptr_t (*)()>(func),
+            hadesmem::CallConv::kDefault);
+
+        return result.GetReturnValue();
+    }
+
+    std::size_t GetPrivateBytes() const override
+    {
+        PROCESS_MEMORY_COUNTERS_EX counters;
+
+        if (!::GetProcessMemoryInfo(
+                _data.GetProcess().GetHandle(),
+                reinterpret_cast<PPROCESS_MEMORY_COUNTERS>(&counters),
+                sizeof(counters)))
+            throw std::runtime_error("GetProcessMemoryInfo failed");
+
+        return counters.PrivateUsage;
+    }
+
+    void Place(const ProcessPlacement& placement) override
+    {
+        auto const handle = _data.GetProcess().GetHandle();
+
+        if (placement.Priority != ProcessPriority::Default &&
+            !::SetPriorityClass(handle, PriorityClass(placement.Priority)))
+            throw std::runtime_error("SetPriorityClass failed");
+
+        if (!placement.Affinity.empty())
+        {
+            DWORD_PTR processMask, systemMask;
+
+            if (!::GetProcessAffinityMask(handle, &processMask, &systemMask))
+                throw std::runtime_error("GetProcessAffinityMask failed");
+
+            // processors which do not exist are ignored rather than rejected,
+            // so that one config can be shared between machines
+            DWORD_PTR mask = 0;
+
+            for (auto const processor : placement.Affinity)
+                if (processor < sizeof(mask) * 8)
+                    mask |= static_cast<DWORD_PTR>(1) << processor;
+
+            mask &= systemMask;
+
+            if (!mask || !::SetProcessAffinityMask(handle, mask))
+                throw std::runtime_error("SetProcessAffinityMask failed");
+        }
+
+        if (!placement.CpuSets.empty())
+            SetCpuSets(handle, placement.CpuSets);
+    }
+
+    void TieToLauncher(bool tied) override
+    {
+        // a process cannot leave a job, so untying it lifts the limit instead.
+        // the client is placed in a job of its own, which closing does not end
+        // once the limit is lifted.
+        if (!_job)
+        {
+            if (!tied)
+                return;
+
+            _job = ::CreateJobObjectW(nullptr, nullptr);
+
+            if (!_job)
+                throw std::runtime_error("CreateJobObject failed");
+
+            SetKillOnClose(true);
+
+            if (!::AssignProcessToJobObject(_job,
+                                            _data.GetProcess().GetHandle()))
+                throw std::runtime_error("AssignProcessToJobObject failed");
+
+            return;
+        }
+
+        SetKillOnClose(tied);
+    }
+
+    void Resume() override
+    {
+        ++_counters.Resumes;
+        _data.ResumeThread();
+    }
+
+    void Terminate() override
+    {
+        ++_counters.Terminations;
+        ::TerminateProcess(_data.GetProcess().GetHandle(), EXIT_FAILURE);
+    }
+
+    void Eject() override
+    {
+        // the dll is freed with a remote call like those above
+        ++_counters.Ejections;
+        ++_counters.Allocations;
+        ++_counters.Writes;
+        ++_counters.Reads;
+
+        auto const& process = _data.GetProcess();
+
+        hadesmem::CloneDaclsToRemoteProcess(process.GetId());
+        hadesmem::FreeDll(process, _data.GetModule());
+    }
+
+    bool WaitForExit(unsigned int milliseconds) override
+    {
+        return ::WaitForSingleObject(_data.GetProcess().GetHandle(),
+                                     milliseconds) != WAIT_TIMEOUT;
+    }
+};
+
+class HadesmemBackend : public ProcessBackend
+{
+private:
+    // opened when it is first needed, as few launches need it
+    std::mutex _diskMutex;
+    std::unique_ptr<DiskQueue> _disk;
+
+public:
+    bool Is32Bit(const fs::path& exe) override
+    {
+        DWORD type;
+
+        if (!::GetBinaryTypeA(exe.string().c_str(), &type))
+            throw std::runtime_error("GetBinaryType failed");
+
+        return type == SCS_32BIT_BINARY;
+    }
+
+    CoreTopology GetPhysicalCores() override
+    {
+        DWORD length = 0;
+        ::GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr,
+                                           &length);
+
+        if (::GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+            throw std::runtime_error("GetLogicalProcessorInformationEx failed");
+
+        std::vector<std::uint8_t> buffer(length);
+
+        if (!::GetLogicalProcessorInformationEx(
+                RelationProcessorCore,
+                reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(
+                    &buffer[0]),
+                &length))
+            throw std::runtime_error("GetLogicalProcessorInformationEx failed");
+
+        CoreTopology result;
+
+        for (DWORD offset = 0; offset < length;)
+        {
+            auto const info =
+                reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(
+                    &buffer[offset]);
+
+            // an affinity mask can only refer to the first processor group
+            if (info->Processor.GroupMask[0].Group == 0)
+            {
+                std::vector<unsigned int> core;
+
+                for (auto i = 0u; i < sizeof(KAFFINITY) * 8; ++i)
+                    if (info->Processor.GroupMask[0].Mask &
+                        (static_cast<KAFFINITY>(1) << i))
+                        core.push_back(i);
+
+                if (!core.empty())
+                    result.push_back(std::move(core));
+            }
+
+            offset += info->Size;
+        }
+
+        return result;
+    }
+
+    bool GetAvailableMemory(std::uint64_t& bytes) override
+    {
+        MEMORYSTATUSEX status;
+        status.dwLength = sizeof(status);
+
+        if (!::GlobalMemoryStatusEx(&status))
+            return false;
+
+        bytes = status.ullAvailPhys;
+        return true;
+    }
+
+    bool GetDiskQueueLength(double& length) override
+    {
+        std::lock_guard<std::mutex> guard(_diskMutex);
+
+        if (!_disk)
+            _disk = std::make_unique<DiskQueue>();
+
+        return _disk->Length(length);
+    }
+
+    std::unique_ptr<ClientProcess>
+    CreateSuspended(const fs::path& exe, const std::vector<std::wstring>& args,
+                    const fs::path& dll) override
+    {
+        // the path of the dll is written to memory allocated within the client
+        ++Counters.Launches;
+        ++Counters.Injections;
+        ++Counters.Allocations;
+        ++Counters.Writes;
+
+        auto data = hadesmem::CreateAndInject(
+            exe, L"", args.cbegin(), args.cend(), dll, "",
+            hadesmem::InjectFlags::kPathResolution |
+                hadesmem::InjectFlags::kKeepSuspended);
+
+        return std::make_unique<HadesmemClient>(Counters, std::move(data));
+    }
+
+    unsigned int GetForegroundProcess() override
+    {
+        DWORD pid = 0;
+
+        if (auto const window = ::GetForegroundWindow())
+            ::GetWindowThreadProcessId(window, &pid);
+
+        return static_cast<unsigned int>(pid);
+    }
+
+    std::unique_ptr<RunningProcess> Open(unsigned int pid) override
+    {
+        return std::make_unique<WindowsProcess>(pid);
+    }
+
+    std::shared_future<unsigned int> StartLauncher(
+        const fs::path& exe,
+        const std::vector<std::pair<std::string, std::string>>& env) override
+    {
+        // the launcher writes the id of its client to a pipe which it alone
+        // inherits, so that nothing it does otherwise can be taken for one
+        SECURITY_ATTRIBUTES inherit;
+        inherit.nLength = sizeof(inherit);
+        inherit.lpSecurityDescriptor = nullptr;
+        inherit.bInheritHandle = TRUE;
+
+        HANDLE reader, writer;
+
+        if (!::CreatePipe(&reader, &writer, &inherit, 0))
+            throw std::runtime_error("CreatePipe failed");
+
+        ::SetHandleInformation(reader, HANDLE_FLAG_INHERIT, 0);
+
+        SIZE_T size = 0;
+        ::InitializeProcThreadAttributeList(nullptr, 1, 0, &size);
+
+        std::vector<std::uint8_t> buffer(size);
+        auto const attributes =
+            reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(&buffer[0]);
+
+        if (!::InitializeProcThreadAttributeList(attributes, 1, 0, &size))
+        {
+            ::CloseHandle(reader);
+            ::CloseHandle(writer);
+            throw std::runtime_error("InitializeProcThreadAttributeList failed");
+        }
+
+        STARTUPINFOEXA si;
+        PROCESS_INFORMATION pi;
+
+        ZeroMemory(&si, sizeof(si));
+        ZeroMemory(&pi, sizeof(pi));
+
+        si.StartupInfo.cb = sizeof(si);
+        si.lpAttributeList = attributes;
+
+        auto vars = env;
+        vars.emplace_back(
+            EnvReport,
+            std::to_string(reinterpret_cast<std::uintptr_t>(writer)));
+
+        // the environment is passed explicitly rather than set in our own, so
+        // that several launchers can be started at once
+        auto environment = MakeEnvironment(vars);
+
+        auto const created =
+            ::UpdateProcThreadAttribute(attributes, 0,
+                                        PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+                                        &writer, sizeof(writer), nullptr,
+                                        nullptr) &&
+            ::CreateProcessA(exe.string().c_str(), nullptr, nullptr, nullptr,
+                             TRUE, EXTENDED_STARTUPINFO_PRESENT,
+                             &environment[0], nullptr, &si.StartupInfo, &pi);
+
+        ::DeleteProcThreadAttributeList(attributes);
+
+        // once the launcher has exited, reading finds the end of the pipe
+        ::CloseHandle(writer);
+
+        if (!created)
+        {
+            ::CloseHandle(reader);
+            throw std::runtime_error("CreateProcess failed");
+        }
+
+        ::CloseHandle(pi.hThread);
+        ::CloseHandle(pi.hProcess);
+
+        // the launcher may take a while, or wait on the user, so its report is
+        // read in the background.  reading returns once the id is written, or
+        // once the launcher has exited without writing it.
+        auto const promise = std::make_shared<std::promise<unsigned int>>();
+        auto reported = promise->get_future().share();
+
+        std::thread(
+            [reader, promise]()
+            {
+                DWORD pid = 0;
+                DWORD read = 0;
+
+                if (!::ReadFile(reader, &pid, sizeof(pid), &read, nullptr) ||
+                    read != sizeof(pid))
+                    pid = 0;
+
+                ::CloseHandle(reader);
+
+                promise->set_value(static_cast<unsigned int>(pid));
+            })
+            .detach();
+
+        return reported;
+    }
+
+    bool ReportToLauncher(unsigned int pid) override
+    {
+        auto const value = getenv(EnvReport);
+
+        if (!value)
+            return false;
+
+        HANDLE writer;
+
+        try
+        {
+            writer = reinterpret_cast<HANDLE>(
+                static_cast<std::uintptr_t>(std::stoull(value)));
+        }
+        catch (std::logic_error const&)
+        {
+            return false;
+        }
+
+        auto const report = static_cast<DWORD>(pid);
+        DWORD written = 0;
+
+        auto const result =
+            !!::WriteFile(writer, &report, sizeof(report), &written, nullptr) &&
+            written == sizeof(report);
+
+        ::CloseHandle(writer);
+
+        return result;
+    }
+
+    void StartDetached(
+        const fs::path& exe,
+        const std::vector<std::pair<std::string, std::string>>& env) override
+    {
+        STARTUPINFOA si;
+        PROCESS_INFORMATION pi;
+
+        ZeroMemory(&si, sizeof(si));
+        ZeroMemory(&pi, sizeof(pi));
+
+        // a launcher we were started by reports to it through a handle which
+        // means nothing to this one
+        auto vars = env;
+        vars.emplace_back(EnvReport, std::string());
+
+        auto environment = MakeEnvironment(vars);
+
+        if (!::CreateProcessA(exe.string().c_str(), nullptr, nullptr, nullptr,
+                              FALSE, DETACHED_PROCESS, &environment[0],
+                              nullptr, &si, &pi))
+            throw std::runtime_error("CreateProcess failed");
+
+        ::CloseHandle(pi.hThread);
+        ::CloseHandle(pi.hProcess);
+    }
+};
+} // namespace
+
+ProcessBackend& GetProcessBackend()
+{
+    static HadesmemBackend backend;
+    return backend;
+}
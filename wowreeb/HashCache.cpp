@@ -0,0 +1,218 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "HashCache.hpp"
+
+#include "Hex.hpp"
+#include "PicoSHA2/picosha2.h"
+
+#include <Windows.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct HashRecord
+{
+    std::uintmax_t Size;
+    fs::file_time_type::rep Modified;
+    Digest Hash;
+};
+
+std::mutex cacheMutex;
+bool cacheLoaded = false;
+std::map<fs::path, HashRecord> cache;
+std::map<fs::path, std::shared_future<Digest>> inFlight;
+
+// the cache lives beside the launcher executables, and is shared by both
+fs::path CachePath()
+{
+    wchar_t path[MAX_PATH];
+
+    if (!::GetModuleFileNameW(nullptr, path, MAX_PATH))
+        throw std::runtime_error("GetModuleFileName failed");
+
+    return fs::path(path).parent_path() / "wowreeb.cache";
+}
+
+// each line holds the hash, size, modification time and path of a file
+void LoadCache()
+{
+    std::ifstream fd(CachePath());
+    std::string line;
+
+    while (std::getline(fd, line))
+    {
+        std::stringstream str(line);
+        std::string hash, path;
+        HashRecord record;
+
+        if (!std::getline(str, hash, '\t') ||
+            hash.length() != 2 * record.Hash.size())
+            continue;
+
+        if (!(str >> record.Size >> record.Modified) || str.get() != '\t' ||
+            !std::getline(str, path))
+            continue;
+
+        if (!HexToData(hash.c_str(), &record.Hash[0], record.Hash.size()))
+            continue;
+
+        cache[fs::u8path(path)] = record;
+    }
+}
+
+void SaveCache()
+{
+    auto const path = CachePath();
+    auto temp = path;
+    temp += "." + std::to_string(::GetCurrentProcessId());
+
+    {
+        std::ofstream fd(temp, std::ios::trunc);
+
+        for (auto const& record : cache)
+            fd << DataToHex(record.second.Hash) << '\t' << record.second.Size
+               << ' ' << record.second.Modified << '\t'
+               << record.first.u8string() << '\n';
+
+        if (!fd)
+            return;
+    }
+
+    // replace the cache atomically so that a concurrent reader never sees a
+    // partially written file.  failure only costs us a future hash.
+    if (!::MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+        ::DeleteFileW(temp.c_str());
+}
+
+Digest ComputeHash(const fs::path& file)
+{
+    std::ifstream fd(file, std::ios::binary);
+
+    if (!fd)
+        throw std::runtime_error("Unable to open file for hashing");
+
+    picosha2::hash256_one_by_one hasher;
+    std::vector<char> buffer(1024 * 1024);
+
+    while (fd)
+    {
+        fd.read(&buffer[0], buffer.size());
+        hasher.process(buffer.begin(), buffer.begin() + fd.gcount());
+    }
+
+    if (!fd.eof())
+        throw std::runtime_error("Unable to read file for hashing");
+
+    hasher.finish();
+
+    Digest result;
+    hasher.get_hash_bytes(result.begin(), result.end());
+
+    return result;
+}
+} // namespace
+
+Digest HashFile(const fs::path& file)
+{
+    auto const path = fs::absolute(file);
+    auto const size = fs::file_size(path);
+    auto const modified = fs::last_write_time(path).time_since_epoch().count();
+
+    std::promise<Digest> promise;
+
+    {
+        std::unique_lock<std::mutex> guard(cacheMutex);
+
+        if (!cacheLoaded)
+        {
+            LoadCache();
+            cacheLoaded = true;
+        }
+
+        auto const record = cache.find(path);
+
+        if (record != cache.end() && record->second.Size == size &&
+            record->second.Modified == modified)
+            return record->second.Hash;
+
+        auto const pending = inFlight.find(path);
+
+        // another thread is already hashing this file.  wait for its result
+        // without holding the lock.
+        if (pending != inFlight.end())
+        {
+            auto const result = pending->second;
+            guard.unlock();
+            return result.get();
+        }
+
+        inFlight[path] = promise.get_future().share();
+    }
+
+    try
+    {
+        auto const hash = ComputeHash(path);
+
+        {
+            std::lock_guard<std::mutex> guard(cacheMutex);
+
+            cache[path] = {size, modified, hash};
+            inFlight.erase(path);
+
+            SaveCache();
+        }
+
+        promise.set_value(hash);
+
+        return hash;
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> guard(cacheMutex);
+            inFlight.erase(path);
+        }
+
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+bool VerifyFile(const fs::path& file, const std::uint8_t* expected)
+{
+    auto const hash = HashFile(file);
+
+    return !::memcmp(&hash[0], expected, hash.size());
+}
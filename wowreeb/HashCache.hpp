@@ -0,0 +1,45 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "PicoSHA2/picosha2.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+using Digest = std::array<std::uint8_t, picosha2::k_digest_size>;
+
+// compute the SHA256 of a file.  results are remembered across runs, keyed by
+// the size and modification time of the file, so a file is only hashed again
+// once it has changed.  concurrent requests for the same file share a single
+// computation.
+Digest HashFile(const fs::path& file);
+
+// returns true if the SHA256 of the file matches the expected digest
+bool VerifyFile(const fs::path& file, const std::uint8_t* expected);
@@ -0,0 +1,394 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Hex.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+
+// msvc allows any instruction set's intrinsics anywhere
+#define TARGET(isa)
+#else
+#include <cpuid.h>
+
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace
+{
+static constexpr char Digits[] = "0123456789abcdef";
+
+// the value of a hex digit, or 0xff for any other character
+std::uint8_t DigitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return static_cast<std::uint8_t>(c - '0');
+    if (c >= 'a' && c <= 'f')
+        return static_cast<std::uint8_t>(c - 'a' + 10);
+    if (c >= 'A' && c <= 'F')
+        return static_cast<std::uint8_t>(c - 'A' + 10);
+
+    return 0xff;
+}
+
+void EncodeScalar(const std::uint8_t* data, std::size_t length, char* hex)
+{
+    for (auto i = 0u; i < length; ++i)
+    {
+        hex[i * 2] = Digits[data[i] >> 4];
+        hex[i * 2 + 1] = Digits[data[i] & 0xf];
+    }
+}
+
+bool DecodeScalar(const char* hex, std::uint8_t* data, std::size_t length)
+{
+    std::uint8_t invalid = 0;
+
+    for (auto i = 0u; i < length; ++i)
+    {
+        auto const high = DigitValue(hex[i * 2]);
+        auto const low = DigitValue(hex[i * 2 + 1]);
+
+        invalid |= (high | low) & 0xf0;
+        data[i] = static_cast<std::uint8_t>((high << 4) | (low & 0xf));
+    }
+
+    return !invalid;
+}
+
+// the values of sixteen characters, and a mask of those which are hex digits
+TARGET("sse2")
+__m128i DecodeDigits(__m128i chars, __m128i& valid)
+{
+    // '0' to '9' become 0 to 9, and either case of 'a' to 'f' becomes 0 to 5.
+    // everything else wraps around to a larger value.
+    auto const digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    auto const letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)),
+                                     _mm_set1_epi8('a'));
+
+    auto const isDigit =
+        _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    auto const isLetter =
+        _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+    valid = _mm_or_si128(isDigit, isLetter);
+
+    return _mm_or_si128(
+        _mm_and_si128(isDigit, digit),
+        _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+// sixteen bytes at a time, using pshufb to look up the digits
+TARGET("ssse3")
+void EncodeSsse3(const std::uint8_t* data, std::size_t length, char* hex)
+{
+    auto const digits =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(Digits));
+    auto const nibble = _mm_set1_epi8(0xf);
+
+    auto i = 0u;
+
+    for (; i + 16 <= length; i += 16)
+    {
+        auto const in =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+
+        auto const high = _mm_shuffle_epi8(
+            digits, _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+        auto const low = _mm_shuffle_epi8(digits, _mm_and_si128(in, nibble));
+
+        auto const out = reinterpret_cast<__m128i*>(hex + i * 2);
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(high, low));
+    }
+
+    EncodeScalar(data + i, length - i, hex + i * 2);
+}
+
+TARGET("ssse3")
+bool DecodeSsse3(const char* hex, std::uint8_t* data, std::size_t length)
+{
+    // each pair of values becomes high * 16 + low
+    auto const weights = _mm_set1_epi16(0x0110);
+    auto valid = _mm_set1_epi8(-1);
+
+    auto i = 0u;
+
+    for (; i + 16 <= length; i += 16)
+    {
+        auto const in = reinterpret_cast<const __m128i*>(hex + i * 2);
+
+        __m128i validFirst, validSecond;
+        auto const first = DecodeDigits(_mm_loadu_si128(in), validFirst);
+        auto const second = DecodeDigits(_mm_loadu_si128(in + 1), validSecond);
+
+        valid = _mm_and_si128(valid, _mm_and_si128(validFirst, validSecond));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i),
+                         _mm_packus_epi16(_mm_maddubs_epi16(first, weights),
+                                          _mm_maddubs_epi16(second, weights)));
+    }
+
+    return _mm_movemask_epi8(valid) == 0xffff &&
+           DecodeScalar(hex + i * 2, data + i, length - i);
+}
+
+// as above, thirty two bytes at a time.  the instructions work within each
+// half of the register, so the halves are put back in order afterwards.
+TARGET("avx2")
+void EncodeAvx2(const std::uint8_t* data, std::size_t length, char* hex)
+{
+    auto const digits = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(Digits)));
+    auto const nibble = _mm256_set1_epi8(0xf);
+
+    auto i = 0u;
+
+    for (; i + 32 <= length; i += 32)
+    {
+        auto const in =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+
+        auto const high = _mm256_shuffle_epi8(
+            digits, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+        auto const low =
+            _mm256_shuffle_epi8(digits, _mm256_and_si256(in, nibble));
+
+        auto const first = _mm256_unpacklo_epi8(high, low);
+        auto const second = _mm256_unpackhi_epi8(high, low);
+
+        auto const out = reinterpret_cast<__m256i*>(hex + i * 2);
+        _mm256_storeu_si256(out, _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(out + 1,
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    }
+
+    // avoid the penalty for mixing these with legacy sse instructions
+    _mm256_zeroupper();
+
+    EncodeSsse3(data + i, length - i, hex + i * 2);
+}
+
+// the byte values of thirty two characters, as pairs of sixteen bit values
+// high * 16 + low.  any which are not hex digits are cleared from valid.  this
+// is a function rather than a lambda so that it too is compiled for avx2.
+TARGET("avx2")
+__m256i DecodePairs(__m256i chars, __m256i& valid)
+{
+    auto const digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    auto const letter =
+        _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)),
+                        _mm256_set1_epi8('a'));
+
+    auto const isDigit = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    auto const isLetter = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+
+    valid = _mm256_and_si256(valid, _mm256_or_si256(isDigit, isLetter));
+
+    return _mm256_maddubs_epi16(
+        _mm256_or_si256(
+            _mm256_and_si256(isDigit, digit),
+            _mm256_and_si256(isLetter,
+                             _mm256_add_epi8(letter, _mm256_set1_epi8(10)))),
+        _mm256_set1_epi16(0x0110));
+}
+
+TARGET("avx2")
+bool DecodeAvx2(const char* hex, std::uint8_t* data, std::size_t length)
+{
+    auto valid = _mm256_set1_epi8(-1);
+
+    auto i = 0u;
+
+    for (; i + 32 <= length; i += 32)
+    {
+        auto const in = reinterpret_cast<const __m256i*>(hex + i * 2);
+
+        auto const first = DecodePairs(_mm256_loadu_si256(in), valid);
+        auto const second = DecodePairs(_mm256_loadu_si256(in + 1), valid);
+
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(data + i),
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second),
+                                     0xd8));
+    }
+
+    auto const result = _mm256_movemask_epi8(valid) == -1;
+
+    _mm256_zeroupper();
+
+    return result && DecodeSsse3(hex + i * 2, data + i, length - i);
+}
+
+struct HexCodec
+{
+    void (*Encode)(const std::uint8_t* data, std::size_t length, char* hex);
+    bool (*Decode)(const char* hex, std::uint8_t* data, std::size_t length);
+};
+
+void Cpuid(int info[4], int leaf, int subleaf = 0)
+{
+#ifdef _MSC_VER
+    __cpuidex(info, leaf, subleaf);
+#else
+    unsigned int regs[4];
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+
+    for (auto i = 0; i < 4; ++i)
+        info[i] = static_cast<int>(regs[i]);
+#endif
+}
+
+// which registers the os saves, from xcr0
+std::uint64_t SavedRegisters()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return static_cast<std::uint64_t>(high) << 32 | low;
+#endif
+}
+
+bool HasSsse3()
+{
+    int info[4];
+    Cpuid(info, 1);
+
+    // ecx bit 9
+    return !!(info[2] & (1 << 9));
+}
+
+bool HasAvx2()
+{
+    int info[4];
+    Cpuid(info, 0);
+
+    if (info[0] < 7)
+        return false;
+
+    Cpuid(info, 1);
+
+    // the processor must support avx, and the os must save the ymm registers
+    // (ecx bits 27 and 28, then xcr0 bits 1 and 2)
+    if ((info[2] & (3 << 27)) != (3 << 27) || (SavedRegisters() & 6) != 6)
+        return false;
+
+    // ebx bit 5
+    Cpuid(info, 7);
+
+    return !!(info[1] & (1 << 5));
+}
+
+const HexCodec& GetCodec(HexKernel kernel)
+{
+    static const HexCodec scalar {EncodeScalar, DecodeScalar};
+    static const HexCodec ssse3 {EncodeSsse3, DecodeSsse3};
+    static const HexCodec avx2 {EncodeAvx2, DecodeAvx2};
+
+    switch (kernel)
+    {
+        case HexKernel::Avx2:
+            return avx2;
+        case HexKernel::Ssse3:
+            return ssse3;
+        default:
+            return scalar;
+    }
+}
+
+const HexCodec& GetCodec()
+{
+    static const HexCodec& codec = GetCodec(
+        HasAvx2() ? HexKernel::Avx2
+                  : HasSsse3() ? HexKernel::Ssse3 : HexKernel::Scalar);
+
+    return codec;
+}
+} // namespace
+
+bool SupportsKernel(HexKernel kernel)
+{
+    switch (kernel)
+    {
+        case HexKernel::Avx2:
+            return HasAvx2();
+        case HexKernel::Ssse3:
+            return HasSsse3();
+        default:
+            return true;
+    }
+}
+
+std::string DataToHexWith(HexKernel kernel, const std::uint8_t* data,
+                          std::size_t length)
+{
+    std::string result(length * 2, '\0');
+
+    if (length)
+        GetCodec(kernel).Encode(data, length, &result[0]);
+
+    return result;
+}
+
+bool HexToDataWith(HexKernel kernel, const char* hex, std::uint8_t* data,
+                   std::size_t length)
+{
+    return GetCodec(kernel).Decode(hex, data, length);
+}
+
+std::string DataToHex(const std::uint8_t* data, std::size_t length)
+{
+    std::string result(length * 2, '\0');
+
+    if (length)
+        GetCodec().Encode(data, length, &result[0]);
+
+    return result;
+}
+
+bool HexToData(const char* hex, std::uint8_t* data, std::size_t length)
+{
+    return GetCodec().Decode(hex, data, length);
+}
+
+bool HexToData(const std::string& hex, std::vector<std::uint8_t>& data)
+{
+    if (hex.length() % 2)
+        return false;
+
+    data.resize(hex.length() / 2);
+
+    return data.empty() || HexToData(hex.c_str(), &data[0], data.size());
+}
@@ -0,0 +1,68 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// lowercase hex of the data
+std::string DataToHex(const std::uint8_t* data, std::size_t length);
+
+template <typename Container>
+std::string DataToHex(const Container& data)
+{
+    return DataToHex(
+        data.empty() ? nullptr : reinterpret_cast<const std::uint8_t*>(&data[0]),
+        data.size() * sizeof(data[0]));
+}
+
+// decode exactly twice as many hex digits, of either case, as there are bytes.
+// returns false if any is not a hex digit, leaving the data partly written.
+bool HexToData(const char* hex, std::uint8_t* data, std::size_t length);
+
+// as above, sizing the data to fit the hex, which must be of even length
+bool HexToData(const std::string& hex, std::vector<std::uint8_t>& data);
+
+// the ways in which hex may be encoded and decoded.  the functions above use
+// the last which the processor supports.
+enum class HexKernel
+{
+    Scalar,
+    Ssse3,
+    Avx2,
+};
+
+// true if the processor and os support the kernel
+bool SupportsKernel(HexKernel kernel);
+
+// as DataToHex and HexToData, but with the given kernel, which must be
+// supported
+std::string DataToHexWith(HexKernel kernel, const std::uint8_t* data,
+                          std::size_t length);
+bool HexToDataWith(HexKernel kernel, const char* hex, std::uint8_t* data,
+                   std::size_t length);
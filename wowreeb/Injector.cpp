@@ -26,232 +26,244 @@
 #include "Injector.hpp"
 
 #include "Config.hpp"
-
-#include <Shlwapi.h>
+#include "ExportCache.hpp"
+#include "Log.hpp"
+#include "ProcessBackend.hpp"
+#include "SettingsChannel.hpp"
+
+#include <Windows.h>
+#include <boost/exception/diagnostic_information.hpp>
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
-#include <hadesmem/acl.hpp>
-#include <hadesmem/alloc.hpp>
-#include <hadesmem/call.hpp>
-#include <hadesmem/find_procedure.hpp>
-#include <hadesmem/injector.hpp>
-#include <hadesmem/write.hpp>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
-#pragma comment(lib, "shlwapi.lib")
-#pragma comment(lib, "asmjit.lib")
-#pragma comment(lib, "udis86.lib")
-
 namespace
 {
-void EjectionPoll(hadesmem::Process process, HMODULE dll, PVOID remoteBuffer)
+long long MicrosecondsSince(std::chrono::steady_clock::time_point start)
 {
-    auto const remoteLocation = reinterpret_cast<bool*>(
-        static_cast<PCHAR>(remoteBuffer) + offsetof(GameSettings, LoadComplete));
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
 
+void EjectionPoll(std::shared_ptr<ClientProcess> client,
+                  std::shared_ptr<SettingsChannel> settings)
+{
     do
     {
-        try
+        if (settings->HasMilestone(MilestoneLoadComplete))
         {
-            auto const complete = hadesmem::Read<bool>(process, remoteLocation);
+            // the credentials are no longer needed by the game
+            settings.reset();
 
-            if (complete)
+            // eject the dll
+            try
             {
-                // free the remotely allocated heap space
-                hadesmem::Free(process, remoteBuffer);
-
-                // eject the dll
-                try
-                {
-                    hadesmem::CloneDaclsToRemoteProcess(process.GetId());
-                    hadesmem::FreeDll(process, dll);
-                }
-                catch (std::exception const& e)
-                {
-                    std::stringstream str;
-
-                    str << "Ejection error: \n"
-                        << boost::diagnostic_information(e);
-
-                    ::MessageBoxA(nullptr, str.str().c_str(), "Ejection failure",
-                                  MB_ICONWARNING);
-                }
-
-                return;
+                client->Eject();
             }
-        }
-        catch (std::exception const& e)
-        {
-            std::stringstream str;
+            catch (std::exception const& e)
+            {
+                std::stringstream str;
 
-            str << "EjectionPoll silent exception:\n\n"
-                << boost::diagnostic_information(e);
+                str << "Ejection error: \n" << boost::diagnostic_information(e);
 
-            ::MessageBoxA(nullptr, str.str().c_str(), "DEBUG", MB_ICONERROR);
+                ::MessageBoxA(nullptr, str.str().c_str(), "Ejection failure",
+                              MB_ICONWARNING);
+            }
 
-            // can happen if the process is terminated before initialization has
-            // completed.  silently abort this thread..
             return;
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // the process may be terminated before initialization has completed.
+        // silently abort this thread.
+        if (client->WaitForExit(100))
+            return;
     } while (true);
 }
+
+void ReportBootFailures(const GameSettings& settings)
+{
+    std::stringstream str;
+
+    auto const describe = [&str](const char* step,
+                                 const SettingsStepResult& result)
+    {
+        switch (result.Status)
+        {
+            case StepNotRun:
+                str << step << " did not run\n";
+                break;
+            case StepFailed:
+                str << step << " failed with result " << result.Value << "\n";
+                break;
+            case StepLoadLibraryFailed:
+                str << step << " could not be loaded (error " << result.Value
+                    << ")\n";
+                break;
+            case StepProcedureNotFound:
+                str << step << " method not found (error " << result.Value
+                    << ")\n";
+                break;
+        }
+    };
+
+    if (settings.LoadResult.Status != StepSucceeded)
+        describe("Load", settings.LoadResult);
+
+    auto const dlls = GetSettingsNativeDlls(&settings);
+
+    for (auto i = 0u; i < settings.NativeDllCount; ++i)
+        if (dlls[i].Result.Status != StepSucceeded)
+            describe("Native DLL", dlls[i].Result);
+
+    if (settings.CLRPath.Length && settings.CLRResult.Status != StepSucceeded)
+        describe("CLRLoad", settings.CLRResult);
+
+    ::MessageBoxA(nullptr, str.str().c_str(), "Injection failure", MB_ICONERROR);
+}
 } // namespace
 
-extern std::wstring make_wstring(const std::string& in);
+PendingClient::PendingClient(std::shared_ptr<ClientProcess> client,
+                             std::shared_ptr<SettingsChannel> settings)
+    : _client(std::move(client)), _settings(std::move(settings)),
+      _id(_client->GetId())
+{
+}
+
+PendingClient::~PendingClient()
+{
+    if (!_client)
+        return;
+
+    try
+    {
+        Terminate();
+    }
+    catch (std::exception const&)
+    {
+    }
+}
+
+unsigned int PendingClient::GetId() const
+{
+    return _id;
+}
+
+void PendingClient::Resume()
+{
+    // allow WoW to continue loading
+    _client->Resume();
+
+    // create a thread whose purpose is to monitor the settings section for
+    // the game to report that it has finished loading
+    std::thread poll(EjectionPoll, std::move(_client), std::move(_settings));
+    poll.detach();
+}
 
-unsigned int Inject(const ConfigEntry& config)
+void PendingClient::Terminate()
 {
-    if (config.AuthServer.length() >= sizeof(GameSettings::AuthServer))
-        throw std::runtime_error("Authentication server address too long");
+    auto const client = std::move(_client);
+    _settings.reset();
 
+    client->Terminate();
+}
+
+std::shared_ptr<ClientProcess> CreateClient(ProcessBackend& backend,
+                                            const ConfigEntry& config)
+{
     std::vector<std::wstring> createArgs;
 
     if (config.Console)
         createArgs.emplace_back(L"-console");
 
-    try
-    {
-        auto const injectData =
-            hadesmem::CreateAndInject(config.Path, L"", createArgs.cbegin(),
-                                      createArgs.cend(), config.OurDll, "",
-                                      hadesmem::InjectFlags::kPathResolution |
-                                          hadesmem::InjectFlags::kKeepSuspended);
+    auto const start = std::chrono::steady_clock::now();
+    auto client = backend.CreateSuspended(config.Path, createArgs, config.OurDll);
 
-        auto const process = injectData.GetProcess();
-        const hadesmem::Module module(process, injectData.GetModule());
+    // creating the process and mapping our dll into it, which is what the size
+    // of the dll affects
+    std::stringstream str;
+    str << "created client " << client->GetId() << " for \"" << config.Name
+        << "\" with our dll loaded in " << MicrosecondsSince(start) << "us";
+    DebugLog(str.str());
 
-        GameSettings gameSettings;
+    return client;
+}
 
-        ::memset(&gameSettings, 0, sizeof(gameSettings));
+std::unique_ptr<PendingClient> BootClient(std::shared_ptr<ClientProcess> client,
+                                          const ConfigEntry& config,
+                                          const ProcessPlacement& placement,
+                                          const SecureBuffer& password)
+{
+    std::shared_ptr<SettingsChannel> settings;
 
-        // include null terminator
-        ::memcpy(gameSettings.AuthServer, config.AuthServer.c_str(),
-                 config.AuthServer.length() + 1);
+    try
+    {
+        // the client has not run yet, so its threads will start where they are
+        // meant to
+        client->Place(placement);
 
-        if (config.Fov > 0.1f)
-        {
-            gameSettings.FoVSet = true;
-            gameSettings.FoV = config.Fov;
-        }
+        // the settings are placed in a shared memory section which our dll
+        // will map by name, so there is no need to copy them into the process
+        settings = std::make_shared<SettingsChannel>(client->GetId(), config,
+                                                     password);
 
-        if (!config.Username.empty() && !config.Password.empty())
-        {
-            // TODO: Move this check into config parsing
-            if (config.Username.length() >= sizeof(GameSettings::Username))
-                throw std::runtime_error("Username is too long");
-
-            if (config.Password.length() >= sizeof(GameSettings::Password))
-                throw std::runtime_error("Password is too long");
-
-            gameSettings.CredentialsSet = true;
-            ::memcpy(gameSettings.Username, config.Username.c_str(),
-                     config.Username.length() + 1);
-            ::memcpy(gameSettings.Password, config.Password.c_str(),
-                     config.Password.length() + 1);
-        }
+        // the address of our boot function is resolved from the dll on disk,
+        // sparing us a walk of the remote export directory
+        auto const rva = FindExportRva(config.OurDll, config.OurMethod);
 
-        // write the game settings into wow's memory
-        auto const remoteBuffer = hadesmem::Alloc(process, sizeof(gameSettings));
-        hadesmem::Write(process, remoteBuffer, &gameSettings, 1);
+        if (!rva)
+            throw std::runtime_error("Boot function not found");
 
-        // get the address of our load function
-        auto const func = reinterpret_cast<void (*)(PVOID)>(
-            hadesmem::FindProcedure(process, module, config.OurMethod));
+        auto const start = std::chrono::steady_clock::now();
 
-        // call our load function with a pointer to our realm list
-        hadesmem::Call(process, func, hadesmem::CallConv::kDefault, remoteBuffer);
+        // a single remote call applies our hooks, loads every native dll and
+        // the CLR, reporting the result of each step in the settings section
+        auto const failed = !!client->Call(client->GetModule() + rva);
 
-        // inject all native dlls, calling methods where specified
-        for (auto const& dll : config.NativeDlls)
-        {
-            auto const nativeHandle = hadesmem::InjectDll(
-                process, dll.first, hadesmem::InjectFlags::kNone);
+        std::stringstream str;
+        str << "booted client " << client->GetId() << " in "
+            << MicrosecondsSince(start) << "us";
+        DebugLog(str.str());
 
-            if (!dll.second.empty())
-            {
-                auto const result =
-                    hadesmem::CallExport(process, nativeHandle, dll.second);
+        if (failed)
+            ReportBootFailures(*settings->Get());
+    }
+    catch (...)
+    {
+        // do not leave a suspended client behind
+        client->Terminate();
+        throw;
+    }
 
-                if (!!result.GetReturnValue())
-                    ::MessageBoxA(nullptr, "Native DLL load failed",
-                                  "Injection failure", MB_ICONERROR);
-            }
-        }
+    return std::make_unique<PendingClient>(std::move(client),
+                                           std::move(settings));
+}
 
-        // if a CLR domain manager dll was specified, create a CLR instance in the
-        // remote process
-        if (!config.CLRDll.empty())
-        {
-            fs::path domainDllPath(config.CLRDll);
-
-            // if the path is relative, make it relative to the wow executable
-            if (domainDllPath.is_relative())
-                domainDllPath = config.Path.parent_path() / domainDllPath;
-
-            auto const domainFullPath = domainDllPath.wstring();
-
-            // allocate enough memory in the remote process to write the path to
-            // the dll, type name, and method name
-            auto const clrPathBufferSize =
-                sizeof(wchar_t) * (domainFullPath.length() + 1);
-            auto const clrPathBuffer =
-                hadesmem::Alloc(process, clrPathBufferSize);
-
-            auto const clrTypeName = make_wstring(config.CLRTypeName);
-
-            auto const typeNameBufferSize =
-                sizeof(wchar_t) * (clrTypeName.length() + 1);
-            auto const typeNameBuffer =
-                hadesmem::Alloc(process, typeNameBufferSize);
-
-            auto const clrMethodName = make_wstring(config.CLRMethodName);
-
-            auto const methodNameBufferSize =
-                sizeof(wchar_t) * (clrMethodName.length() + 1);
-            auto const methodNameBuffer =
-                hadesmem::Alloc(process, methodNameBufferSize);
-
-            // write the path to the dll, the type name, and the method name
-            hadesmem::Write(process, clrPathBuffer, domainFullPath.c_str(),
-                            clrPathBufferSize);
-            hadesmem::Write(process, typeNameBuffer, clrTypeName.c_str(),
-                            typeNameBufferSize);
-            hadesmem::Write(process, methodNameBuffer, clrMethodName.c_str(),
-                            methodNameBufferSize);
-
-            // call our CLR load in the remote process
-            auto const clrLoad =
-                reinterpret_cast<unsigned int (*)(PVOID, PVOID, PVOID)>(
-                    hadesmem::FindProcedure(process, module, "CLRLoad"));
-            auto const result =
-                hadesmem::Call(process, clrLoad, hadesmem::CallConv::kDefault,
-                               clrPathBuffer, typeNameBuffer, methodNameBuffer);
-
-            if (!!result.GetReturnValue())
-                ::MessageBoxA(nullptr, "CLRLoad failed", "Injection failure",
-                              MB_ICONERROR);
-
-            // free the remote buffers
-            hadesmem::Free(process, clrPathBuffer);
-            hadesmem::Free(process, typeNameBuffer);
-            hadesmem::Free(process, methodNameBuffer);
-        }
+std::unique_ptr<PendingClient> PrepareClient(ProcessBackend& backend,
+                                             const ConfigEntry& config,
+                                             const ProcessPlacement& placement,
+                                             const SecureBuffer& password)
+{
+    return BootClient(CreateClient(backend, config), config, placement,
+                      password);
+}
 
-        // allow WoW to continue loading
-        injectData.ResumeThread();
+unsigned int Inject(ProcessBackend& backend, const ConfigEntry& config,
+                    const ProcessPlacement& placement,
+                    const SecureBuffer& password)
+{
+    try
+    {
+        auto const client = PrepareClient(backend, config, placement, password);
 
-        // create a thread whose purpose is to monitor our remote heap allocated
-        // space for the completion byte to be toggled
-        std::thread poll(EjectionPoll, process, injectData.GetModule(),
-                         remoteBuffer);
-        poll.detach();
+        client->Resume();
 
-        return static_cast<unsigned int>(injectData.GetProcess().GetId());
+        return client->GetId();
     }
     catch (std::exception const& e)
     {
@@ -25,28 +25,60 @@
 
 #pragma once
 
-#include <filesystem>
-#include <string>
+#include <memory>
 
-namespace fs = std::filesystem;
+class ClientProcess;
+class ProcessBackend;
+class SecureBuffer;
+class SettingsChannel;
+struct ConfigEntry;
+struct ProcessPlacement;
 
-// this structure is used within the game so it knows what we have told it to do
-#pragma pack(push, 1)
-struct GameSettings
+// a client which has been created and booted, but which has not yet been allowed
+// to run.  if it is destroyed before being resumed, the client is terminated.
+class PendingClient
 {
-    char AuthServer[128];
+private:
+    std::shared_ptr<ClientProcess> _client;
+    std::shared_ptr<SettingsChannel> _settings;
+
+    unsigned int _id;
+
+public:
+    PendingClient(std::shared_ptr<ClientProcess> client,
+                  std::shared_ptr<SettingsChannel> settings);
+    ~PendingClient();
+
+    PendingClient(const PendingClient&) = delete;
+    PendingClient& operator=(const PendingClient&) = delete;
 
-    bool FoVSet;
-    float FoV;
+    unsigned int GetId() const;
 
-    bool CredentialsSet;
-    char Username[64];
-    char Password[64];
+    // allow the client to run, and unload our dll once it has finished loading
+    void Resume();
 
-    bool LoadComplete;
+    void Terminate();
 };
-#pragma pack(pop)
 
-struct ConfigEntry;
+// create the client suspended with our dll loaded into it.  throws on failure.
+std::shared_ptr<ClientProcess> CreateClient(ProcessBackend& backend,
+                                            const ConfigEntry& config);
+
+// place and boot a client made by CreateClient, handing it the decrypted
+// password.  throws on failure, in which case the client is terminated.
+std::unique_ptr<PendingClient> BootClient(std::shared_ptr<ClientProcess> client,
+                                          const ConfigEntry& config,
+                                          const ProcessPlacement& placement,
+                                          const SecureBuffer& password);
+
+// create the client suspended, place it and boot it.  throws on failure.
+std::unique_ptr<PendingClient> PrepareClient(ProcessBackend& backend,
+                                             const ConfigEntry& config,
+                                             const ProcessPlacement& placement,
+                                             const SecureBuffer& password);
 
-unsigned int Inject(const ConfigEntry& config);
+// create, place, boot and resume the client, returning its process id or zero
+// on failure.  errors are reported to the user.
+unsigned int Inject(ProcessBackend& backend, const ConfigEntry& config,
+                    const ProcessPlacement& placement,
+                    const SecureBuffer& password);
@@ -0,0 +1,835 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Kdf.hpp"
+
+#include "Crypto.hpp"
+#include "Hex.hpp"
+#include "PicoSHA2/picosha2.h"
+#include "Platform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// argon2id version 1.3, from RFC 9106
+static constexpr std::uint32_t Argon2Version = 0x13;
+static constexpr std::uint32_t Argon2Type = 2;
+static constexpr std::uint32_t SyncPoints = 4;
+
+// calibration starts from 8 MiB, well below the 64 MiB of the second
+// recommendation of RFC 9106 so that slow machines still use argon2id, and grows
+// memory before passes as memory is what makes guessing costly.  memory is held
+// to what the 32 bit launcher can allocate, as either launcher may derive a key
+// chosen by the other.
+static constexpr std::uint32_t MinMemory = 8 * 1024;
+static constexpr std::uint32_t MaxMemory = 256 * 1024;
+static constexpr std::uint32_t MinPasses = 3;
+static constexpr std::uint32_t MaxPasses = 64;
+static constexpr std::uint32_t MaxLanes = 8;
+
+// OWASP's figure for pbkdf2-sha256, below which a fallback is not worth having
+static constexpr std::uint32_t MinPbkdf2Iterations = 600000;
+
+std::uint64_t Load64(const std::uint8_t* data)
+{
+    std::uint64_t result;
+    ::memcpy(&result, data, sizeof(result));
+    return result;
+}
+
+std::uint64_t Rotate(std::uint64_t value, int bits)
+{
+    return (value >> bits) | (value << (64 - bits));
+}
+
+// BLAKE2b from RFC 7693, without a key, as argon2 uses it
+class Blake2b
+{
+private:
+    static constexpr std::size_t BlockLength = 128;
+
+    std::uint64_t _h[8];
+    std::uint64_t _t[2];
+    std::uint8_t _buffer[BlockLength];
+    std::size_t _used;
+    std::size_t _outLength;
+
+    void Compress(bool last)
+    {
+        static constexpr std::uint64_t iv[8] = {
+            0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b,
+            0xa54ff53a5f1d36f1, 0x510e527fade682d1, 0x9b05688c2b3e6c1f,
+            0x1f83d9abfb41bd6b, 0x5be0cd19137e2179};
+        static constexpr std::uint8_t sigma[10][16] = {
+            {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+            {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+            {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+            {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+            {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+            {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+            {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+            {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+            {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+            {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0}};
+
+        std::uint64_t m[16], v[16];
+
+        for (auto i = 0; i < 16; ++i)
+            m[i] = Load64(&_buffer[i * 8]);
+
+        for (auto i = 0; i < 8; ++i)
+        {
+            v[i] = _h[i];
+            v[i + 8] = iv[i];
+        }
+
+        v[12] ^= _t[0];
+        v[13] ^= _t[1];
+
+        if (last)
+            v[14] = ~v[14];
+
+        auto const g = [&v](int a, int b, int c, int d, std::uint64_t x,
+                            std::uint64_t y)
+        {
+            v[a] = v[a] + v[b] + x;
+            v[d] = Rotate(v[d] ^ v[a], 32);
+            v[c] = v[c] + v[d];
+            v[b] = Rotate(v[b] ^ v[c], 24);
+            v[a] = v[a] + v[b] + y;
+            v[d] = Rotate(v[d] ^ v[a], 16);
+            v[c] = v[c] + v[d];
+            v[b] = Rotate(v[b] ^ v[c], 63);
+        };
+
+        for (auto round = 0; round < 12; ++round)
+        {
+            auto const s = sigma[round % 10];
+
+            g(0, 4, 8, 12, m[s[0]], m[s[1]]);
+            g(1, 5, 9, 13, m[s[2]], m[s[3]]);
+            g(2, 6, 10, 14, m[s[4]], m[s[5]]);
+            g(3, 7, 11, 15, m[s[6]], m[s[7]]);
+            g(0, 5, 10, 15, m[s[8]], m[s[9]]);
+            g(1, 6, 11, 12, m[s[10]], m[s[11]]);
+            g(2, 7, 8, 13, m[s[12]], m[s[13]]);
+            g(3, 4, 9, 14, m[s[14]], m[s[15]]);
+        }
+
+        for (auto i = 0; i < 8; ++i)
+            _h[i] ^= v[i] ^ v[i + 8];
+    }
+
+    void Count(std::size_t length)
+    {
+        _t[0] += length;
+
+        if (_t[0] < length)
+            ++_t[1];
+    }
+
+public:
+    explicit Blake2b(std::size_t outLength)
+        : _t {0, 0}, _used(0), _outLength(outLength)
+    {
+        static constexpr std::uint64_t iv[8] = {
+            0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b,
+            0xa54ff53a5f1d36f1, 0x510e527fade682d1, 0x9b05688c2b3e6c1f,
+            0x1f83d9abfb41bd6b, 0x5be0cd19137e2179};
+
+        ::memcpy(_h, iv, sizeof(_h));
+        _h[0] ^= 0x01010000 ^ outLength;
+    }
+
+    ~Blake2b()
+    {
+        ::SecureZeroMemory(_buffer, sizeof(_buffer));
+        ::SecureZeroMemory(_h, sizeof(_h));
+    }
+
+    void Update(const void* data, std::size_t length)
+    {
+        auto in = static_cast<const std::uint8_t*>(data);
+
+        while (length)
+        {
+            // the final block must be compressed differently, so a full
+            // buffer is only compressed once more input arrives
+            if (_used == BlockLength)
+            {
+                Count(BlockLength);
+                Compress(false);
+                _used = 0;
+            }
+
+            auto const n = (std::min)(BlockLength - _used, length);
+
+            ::memcpy(&_buffer[_used], in, n);
+            _used += n;
+            in += n;
+            length -= n;
+        }
+    }
+
+    void Update(std::uint32_t value)
+    {
+        std::uint8_t bytes[4];
+        ::memcpy(bytes, &value, sizeof(bytes));
+        Update(bytes, sizeof(bytes));
+    }
+
+    void Final(std::uint8_t* out)
+    {
+        Count(_used);
+        ::memset(&_buffer[_used], 0, BlockLength - _used);
+        Compress(true);
+
+        std::uint8_t digest[sizeof(_h)];
+        ::memcpy(digest, _h, sizeof(digest));
+        ::memcpy(out, digest, _outLength);
+        ::SecureZeroMemory(digest, sizeof(digest));
+    }
+};
+
+// the variable length hash H' from RFC 9106, section 3.3
+void HashLong(const std::uint8_t* in, std::size_t inLength, std::uint8_t* out,
+              std::uint32_t outLength)
+{
+    if (outLength <= 64)
+    {
+        Blake2b h(outLength);
+        h.Update(outLength);
+        h.Update(in, inLength);
+        h.Final(out);
+        return;
+    }
+
+    std::uint8_t v[64];
+
+    {
+        Blake2b h(64);
+        h.Update(outLength);
+        h.Update(in, inLength);
+        h.Final(v);
+    }
+
+    // each intermediate hash contributes its first half
+    auto const r = (outLength + 31) / 32 - 2;
+
+    ::memcpy(out, v, 32);
+
+    for (auto i = 1u; i < r; ++i)
+    {
+        Blake2b h(64);
+        h.Update(v, sizeof(v));
+        h.Final(v);
+
+        ::memcpy(out + i * 32, v, 32);
+    }
+
+    Blake2b h(outLength - 32 * r);
+    h.Update(v, sizeof(v));
+    h.Final(out + r * 32);
+
+    ::SecureZeroMemory(v, sizeof(v));
+}
+
+struct Block
+{
+    std::uint64_t V[128];
+};
+
+void Mix(std::uint64_t& a, std::uint64_t& b, std::uint64_t& c, std::uint64_t& d)
+{
+    // BLAKE2b's mixing function, with multiplication for hardness
+    auto const mul = [](std::uint64_t x, std::uint64_t y)
+    { return 2 * (x & 0xFFFFFFFF) * (y & 0xFFFFFFFF); };
+
+    a = a + b + mul(a, b);
+    d = Rotate(d ^ a, 32);
+    c = c + d + mul(c, d);
+    b = Rotate(b ^ c, 24);
+    a = a + b + mul(a, b);
+    d = Rotate(d ^ a, 16);
+    c = c + d + mul(c, d);
+    b = Rotate(b ^ c, 63);
+}
+
+// the permutation P over sixteen words given by their indices into the block
+void Permute(Block& b, const std::size_t (&i)[16])
+{
+    auto& v = b.V;
+
+    Mix(v[i[0]], v[i[4]], v[i[8]], v[i[12]]);
+    Mix(v[i[1]], v[i[5]], v[i[9]], v[i[13]]);
+    Mix(v[i[2]], v[i[6]], v[i[10]], v[i[14]]);
+    Mix(v[i[3]], v[i[7]], v[i[11]], v[i[15]]);
+    Mix(v[i[0]], v[i[5]], v[i[10]], v[i[15]]);
+    Mix(v[i[1]], v[i[6]], v[i[11]], v[i[12]]);
+    Mix(v[i[2]], v[i[7]], v[i[8]], v[i[13]]);
+    Mix(v[i[3]], v[i[4]], v[i[9]], v[i[14]]);
+}
+
+// the compression function G, which from the second pass on is combined with
+// the block being overwritten
+void FillBlock(const Block& prev, const Block& ref, Block& next, bool combine)
+{
+    Block r, z;
+
+    for (auto i = 0; i < 128; ++i)
+        r.V[i] = prev.V[i] ^ ref.V[i];
+
+    z = r;
+
+    // rows of eight sixteen byte registers
+    for (std::size_t row = 0; row < 8; ++row)
+    {
+        std::size_t i[16];
+
+        for (std::size_t j = 0; j < 16; ++j)
+            i[j] = 16 * row + j;
+
+        Permute(z, i);
+    }
+
+    // then columns of them
+    for (std::size_t col = 0; col < 8; ++col)
+    {
+        std::size_t i[16];
+
+        for (std::size_t j = 0; j < 8; ++j)
+        {
+            i[2 * j] = 2 * col + 16 * j;
+            i[2 * j + 1] = 2 * col + 16 * j + 1;
+        }
+
+        Permute(z, i);
+    }
+
+    for (auto i = 0; i < 128; ++i)
+        next.V[i] = (combine ? next.V[i] : 0) ^ r.V[i] ^ z.V[i];
+}
+
+class Argon2
+{
+private:
+    std::vector<Block> _memory;
+
+    std::uint32_t _passes;
+    std::uint32_t _lanes;
+    std::uint32_t _laneLength;
+    std::uint32_t _segmentLength;
+
+    // RFC 9106, section 3.4.2
+    std::uint32_t ReferenceIndex(std::uint32_t pass, std::uint32_t slice,
+                                 std::uint32_t index, std::uint32_t random,
+                                 bool sameLane) const
+    {
+        // every block filled so far, other than the one just before this
+        std::uint32_t area =
+            pass ? _laneLength - _segmentLength : slice * _segmentLength;
+
+        if (sameLane)
+            area += index - 1;
+        else if (!index)
+            --area;
+
+        std::uint64_t relative = random;
+        relative = relative * relative >> 32;
+        relative = area - 1 - (area * relative >> 32);
+
+        auto const start =
+            pass && slice != SyncPoints - 1 ? (slice + 1) * _segmentLength : 0;
+
+        return static_cast<std::uint32_t>((start + relative) % _laneLength);
+    }
+
+    void FillSegment(std::uint32_t pass, std::uint32_t lane, std::uint32_t slice)
+    {
+        // argon2id uses data independent addressing for the first half of its
+        // first pass, hindering side channels, and data dependent after
+        auto const independent = !pass && slice < SyncPoints / 2;
+
+        Block zero {}, input {}, address {};
+
+        auto const nextAddresses = [&]()
+        {
+            ++input.V[6];
+            FillBlock(zero, input, address, false);
+            FillBlock(zero, address, address, false);
+        };
+
+        if (independent)
+        {
+            input.V[0] = pass;
+            input.V[1] = lane;
+            input.V[2] = slice;
+            input.V[3] = _memory.size();
+            input.V[4] = _passes;
+            input.V[5] = Argon2Type;
+        }
+
+        std::uint32_t start = 0;
+
+        // the first two blocks of each lane are filled from the initial hash
+        if (!pass && !slice)
+        {
+            start = 2;
+
+            if (independent)
+                nextAddresses();
+        }
+
+        auto current = lane * _laneLength + slice * _segmentLength + start;
+        auto previous =
+            current % _laneLength ? current - 1 : current + _laneLength - 1;
+
+        for (auto i = start; i < _segmentLength; ++i, ++current, ++previous)
+        {
+            if (current % _laneLength == 1)
+                previous = current - 1;
+
+            std::uint64_t random;
+
+            if (independent)
+            {
+                if (!(i % 128))
+                    nextAddresses();
+
+                random = address.V[i % 128];
+            }
+            else
+                random = _memory[previous].V[0];
+
+            auto refLane = static_cast<std::uint32_t>((random >> 32) % _lanes);
+
+            if (!pass && !slice)
+                refLane = lane;
+
+            auto const refIndex = ReferenceIndex(
+                pass, slice, i, static_cast<std::uint32_t>(random),
+                refLane == lane);
+
+            FillBlock(_memory[previous],
+                      _memory[refLane * _laneLength + refIndex],
+                      _memory[current], pass != 0);
+        }
+    }
+
+public:
+    Argon2(std::uint32_t memory, std::uint32_t passes, std::uint32_t lanes)
+        : _passes(passes), _lanes(lanes)
+    {
+        auto const blocks = (std::max)(memory, 2 * SyncPoints * lanes) /
+                            (SyncPoints * lanes) * (SyncPoints * lanes);
+
+        _laneLength = blocks / lanes;
+        _segmentLength = _laneLength / SyncPoints;
+        _memory.resize(blocks);
+    }
+
+    ~Argon2()
+    {
+        ::SecureZeroMemory(_memory.data(), _memory.size() * sizeof(Block));
+    }
+
+    // the launcher gives neither a secret nor associated data, which RFC 9106
+    // allows, but its test vector uses
+    void Hash(const std::string& password, const std::vector<std::uint8_t>& salt,
+              std::uint32_t memory, std::uint8_t* out, std::uint32_t outLength,
+              const std::vector<std::uint8_t>& secret = {},
+              const std::vector<std::uint8_t>& data = {})
+    {
+        std::uint8_t h0[64 + 8];
+
+        {
+            Blake2b h(64);
+            h.Update(_lanes);
+            h.Update(outLength);
+            h.Update(memory);
+            h.Update(_passes);
+            h.Update(Argon2Version);
+            h.Update(Argon2Type);
+            h.Update(static_cast<std::uint32_t>(password.length()));
+            h.Update(password.data(), password.length());
+            h.Update(static_cast<std::uint32_t>(salt.size()));
+            h.Update(salt.data(), salt.size());
+            h.Update(static_cast<std::uint32_t>(secret.size()));
+            h.Update(secret.data(), secret.size());
+            h.Update(static_cast<std::uint32_t>(data.size()));
+            h.Update(data.data(), data.size());
+            h.Final(h0);
+        }
+
+        for (auto lane = 0u; lane < _lanes; ++lane)
+        {
+            for (auto i = 0u; i < 2; ++i)
+            {
+                ::memcpy(&h0[64], &i, 4);
+                ::memcpy(&h0[68], &lane, 4);
+
+                HashLong(h0, sizeof(h0),
+                         reinterpret_cast<std::uint8_t*>(
+                             _memory[lane * _laneLength + i].V),
+                         sizeof(Block));
+            }
+        }
+
+        ::SecureZeroMemory(h0, sizeof(h0));
+
+        // lanes only meet at the end of each slice, so each is given a thread
+        for (auto pass = 0u; pass < _passes; ++pass)
+        {
+            for (auto slice = 0u; slice < SyncPoints; ++slice)
+            {
+                std::vector<std::thread> threads;
+
+                for (auto lane = 1u; lane < _lanes; ++lane)
+                    threads.emplace_back(&Argon2::FillSegment, this, pass, lane,
+                                         slice);
+
+                FillSegment(pass, 0, slice);
+
+                for (auto& thread : threads)
+                    thread.join();
+            }
+        }
+
+        Block final = _memory[_laneLength - 1];
+
+        for (auto lane = 1u; lane < _lanes; ++lane)
+            for (auto i = 0; i < 128; ++i)
+                final.V[i] ^= _memory[lane * _laneLength + _laneLength - 1].V[i];
+
+        HashLong(reinterpret_cast<const std::uint8_t*>(final.V), sizeof(Block),
+                 out, outLength);
+
+        ::SecureZeroMemory(&final, sizeof(final));
+    }
+};
+
+// RFC 8018, with HMAC-SHA256 as its pseudorandom function
+void Pbkdf2(const std::string& password, const std::vector<std::uint8_t>& salt,
+            std::uint32_t iterations, std::uint8_t* out, std::size_t outLength)
+{
+    static constexpr std::size_t BlockLength = 64;
+
+    std::uint8_t key[BlockLength] = {};
+
+    if (password.length() > BlockLength)
+        picosha2::hash256(password.begin(), password.end(), key,
+                          key + picosha2::k_digest_size);
+    else
+        ::memcpy(key, password.data(), password.length());
+
+    // the padded key is the same for every hmac, so its hash state is kept
+    picosha2::hash256_one_by_one inner, outer;
+
+    std::uint8_t pad[BlockLength];
+
+    for (auto i = 0u; i < BlockLength; ++i)
+        pad[i] = key[i] ^ 0x36;
+
+    inner.process(pad, pad + BlockLength);
+
+    for (auto i = 0u; i < BlockLength; ++i)
+        pad[i] = key[i] ^ 0x5c;
+
+    outer.process(pad, pad + BlockLength);
+
+    ::SecureZeroMemory(pad, sizeof(pad));
+    ::SecureZeroMemory(key, sizeof(key));
+
+    auto const hmac = [&inner, &outer](const std::uint8_t* data,
+                                       std::size_t length, std::uint8_t* mac)
+    {
+        auto in = inner;
+        in.process(data, data + length);
+        in.finish();
+        in.get_hash_bytes(mac, mac + picosha2::k_digest_size);
+
+        auto out = outer;
+        out.process(mac, mac + picosha2::k_digest_size);
+        out.finish();
+        out.get_hash_bytes(mac, mac + picosha2::k_digest_size);
+    };
+
+    for (std::uint32_t block = 1; outLength; ++block)
+    {
+        std::vector<std::uint8_t> first(salt);
+
+        for (auto shift = 24; shift >= 0; shift -= 8)
+            first.push_back(static_cast<std::uint8_t>(block >> shift));
+
+        std::uint8_t u[picosha2::k_digest_size], t[picosha2::k_digest_size];
+
+        hmac(first.data(), first.size(), u);
+        ::memcpy(t, u, sizeof(t));
+
+        for (auto i = 1u; i < iterations; ++i)
+        {
+            hmac(u, sizeof(u), u);
+
+            for (auto j = 0u; j < sizeof(t); ++j)
+                t[j] ^= u[j];
+        }
+
+        auto const n = (std::min)(outLength, sizeof(t));
+
+        ::memcpy(out, t, n);
+        out += n;
+        outLength -= n;
+
+        ::SecureZeroMemory(u, sizeof(u));
+        ::SecureZeroMemory(t, sizeof(t));
+    }
+}
+
+// as DeriveKey, but lets std::bad_alloc through for calibration to handle
+void Derive(const std::string& password, const KdfParams& params,
+            std::uint8_t* key)
+{
+    if (params.Algorithm == KdfAlgorithm::Argon2id)
+        Argon2(params.Memory, params.Iterations, params.Lanes)
+            .Hash(password, params.Salt, params.Memory, key,
+                  CryptoProvider::KeyLength);
+    else
+        Pbkdf2(password, params.Salt, params.Iterations, key,
+               CryptoProvider::KeyLength);
+}
+
+std::chrono::milliseconds Time(const KdfParams& params)
+{
+    std::uint8_t key[CryptoProvider::KeyLength];
+
+    auto const start = std::chrono::steady_clock::now();
+    Derive("calibration", params, key);
+
+    return (std::max)(std::chrono::milliseconds(1),
+                      std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - start));
+}
+
+// how many iterations would take the target time, if these took as long as was
+// measured
+std::uint64_t Scale(std::uint32_t iterations, std::chrono::milliseconds target,
+                    std::chrono::milliseconds elapsed)
+{
+    return static_cast<std::uint64_t>(iterations) * target.count() /
+           elapsed.count();
+}
+} // namespace
+
+void DeriveKey(const std::string& password, const KdfParams& params,
+               std::uint8_t* key)
+{
+    try
+    {
+        Derive(password, params, key);
+    }
+    catch (std::bad_alloc const&)
+    {
+        throw std::runtime_error("Not enough memory to derive the key");
+    }
+}
+
+KdfParams CalibrateKdf(std::chrono::milliseconds target)
+{
+    KdfParams params;
+
+    params.Algorithm = KdfAlgorithm::Argon2id;
+    params.Iterations = MinPasses;
+    params.Memory = MinMemory;
+    params.Lanes = (std::max)(
+        1u, (std::min)(MaxLanes, std::thread::hardware_concurrency()));
+    params.Salt.resize(KdfParams::SaltLength);
+
+    RandomBytes(params.Salt.data(), params.Salt.size());
+
+    std::chrono::milliseconds elapsed;
+
+    try
+    {
+        elapsed = Time(params);
+
+        while (elapsed * 2 <= target && params.Memory * 2 <= MaxMemory)
+        {
+            params.Memory *= 2;
+
+            try
+            {
+                elapsed = Time(params);
+            }
+            catch (std::bad_alloc const&)
+            {
+                params.Memory /= 2;
+                break;
+            }
+        }
+    }
+    catch (std::bad_alloc const&)
+    {
+        // even the least memory cannot be had, so fall back to pbkdf2
+        params.Algorithm = KdfAlgorithm::Pbkdf2Sha256;
+        params.Memory = 0;
+        params.Lanes = 1;
+        params.Iterations = MinPbkdf2Iterations / 10;
+
+        elapsed = Time(params);
+
+        params.Iterations = static_cast<std::uint32_t>(
+            (std::max)(std::uint64_t {MinPbkdf2Iterations},
+                       Scale(params.Iterations, target, elapsed)));
+
+        return params;
+    }
+
+    // spend whatever time remains on further passes
+    params.Iterations = static_cast<std::uint32_t>((std::min)(
+        std::uint64_t {MaxPasses},
+        (std::max)(std::uint64_t {MinPasses},
+                   Scale(params.Iterations, target, elapsed))));
+
+    return params;
+}
+
+std::string FormatKdfParams(const KdfParams& params)
+{
+    std::stringstream str;
+
+    if (params.Algorithm == KdfAlgorithm::Argon2id)
+        str << "$argon2id$v=" << Argon2Version << "$m=" << params.Memory
+            << ",t=" << params.Iterations << ",p=" << params.Lanes;
+    else
+        str << "$pbkdf2-sha256$i=" << params.Iterations;
+
+    str << "$" << DataToHex(params.Salt);
+
+    return str.str();
+}
+
+bool ParseKdfParams(const std::string& text, KdfParams& params)
+{
+    std::vector<std::string> fields;
+    std::stringstream in(text);
+    std::string field;
+
+    while (std::getline(in, field, '$'))
+        fields.push_back(field);
+
+    if (fields.size() < 4 || !fields[0].empty())
+        return false;
+
+    auto const& salt = fields.back();
+
+    if (salt.length() != 2 * KdfParams::SaltLength ||
+        !HexToData(salt, params.Salt))
+        return false;
+
+    unsigned long long m, t, p, v;
+    char sep1, sep2;
+
+    if (fields[1] == "argon2id" && fields.size() == 5)
+    {
+        std::stringstream version(fields[2]), costs(fields[3]);
+
+        if (version.get() != 'v' || version.get() != '=' || !(version >> v) ||
+            v != Argon2Version)
+            return false;
+
+        if (costs.get() != 'm' || costs.get() != '=' || !(costs >> m) ||
+            !(costs >> sep1) || sep1 != ',' || costs.get() != 't' ||
+            costs.get() != '=' || !(costs >> t) || !(costs >> sep2) ||
+            sep2 != ',' || costs.get() != 'p' || costs.get() != '=' ||
+            !(costs >> p))
+            return false;
+
+        // RFC 9106 requires at least eight blocks for each lane
+        if (!t || t > MaxPasses || !p || p > 255 || m < 8 * p ||
+            m > MaxMemory)
+            return false;
+
+        params.Algorithm = KdfAlgorithm::Argon2id;
+        params.Memory = static_cast<std::uint32_t>(m);
+        params.Iterations = static_cast<std::uint32_t>(t);
+        params.Lanes = static_cast<std::uint32_t>(p);
+
+        return true;
+    }
+
+    if (fields[1] == "pbkdf2-sha256" && fields.size() == 4)
+    {
+        std::stringstream costs(fields[2]);
+
+        if (costs.get() != 'i' || costs.get() != '=' || !(costs >> t) || !t ||
+            t > 0xFFFFFFFF)
+            return false;
+
+        params.Algorithm = KdfAlgorithm::Pbkdf2Sha256;
+        params.Memory = 0;
+        params.Iterations = static_cast<std::uint32_t>(t);
+        params.Lanes = 1;
+
+        return true;
+    }
+
+    return false;
+}
+
+void RandomBytes(std::uint8_t* buffer, std::size_t length)
+{
+    if (!SystemRandom(buffer, length))
+        throw std::runtime_error("Failed to generate random bytes");
+}
+
+void Blake2bHash(const void* data, std::size_t length, std::uint8_t* out,
+                 std::size_t outLength)
+{
+    Blake2b h(outLength);
+    h.Update(data, length);
+    h.Final(out);
+}
+
+void Argon2idHash(const std::string& password,
+                  const std::vector<std::uint8_t>& salt,
+                  const std::vector<std::uint8_t>& secret,
+                  const std::vector<std::uint8_t>& data, std::uint32_t memory,
+                  std::uint32_t passes, std::uint32_t lanes, std::uint8_t* out,
+                  std::uint32_t outLength)
+{
+    Argon2(memory, passes, lanes)
+        .Hash(password, salt, memory, out, outLength, secret, data);
+}
@@ -0,0 +1,89 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class KdfAlgorithm
+{
+    Argon2id,
+    Pbkdf2Sha256, // for machines which cannot spare the memory argon2id needs
+};
+
+struct KdfParams
+{
+    static constexpr std::size_t SaltLength = 16;
+
+    KdfAlgorithm Algorithm;
+
+    // passes over memory for argon2id, or iterations for pbkdf2
+    std::uint32_t Iterations;
+
+    // kibibytes of memory, for argon2id only
+    std::uint32_t Memory;
+
+    // independent lanes of memory, each filled by a thread of its own
+    std::uint32_t Lanes;
+
+    std::vector<std::uint8_t> Salt;
+};
+
+// derive a key of CryptoProvider::KeyLength bytes from the password.  throws
+// std::runtime_error if the memory it needs cannot be allocated.
+void DeriveKey(const std::string& password, const KdfParams& params,
+               std::uint8_t* key);
+
+// choose the strongest parameters with which a key is derived in about the
+// target time on this machine, along with a fresh salt
+KdfParams CalibrateKdf(std::chrono::milliseconds target);
+
+// parameters and salt in the style of the PHC string format, such as
+// "$argon2id$v=19$m=65536,t=3,p=4$<salt>", with the salt in hex
+std::string FormatKdfParams(const KdfParams& params);
+
+// returns false if the text is not a valid parameter string
+bool ParseKdfParams(const std::string& text, KdfParams& params);
+
+// fill the buffer from the system's cryptographic random number generator
+void RandomBytes(std::uint8_t* buffer, std::size_t length);
+
+// the primitives beneath DeriveKey, for the known-answer tests.  BLAKE2b from
+// RFC 7693 without a key, giving up to 64 bytes.
+void Blake2bHash(const void* data, std::size_t length, std::uint8_t* out,
+                 std::size_t outLength);
+
+// argon2id from RFC 9106 with the optional secret and associated data, which
+// the launcher itself never uses
+void Argon2idHash(const std::string& password,
+                  const std::vector<std::uint8_t>& salt,
+                  const std::vector<std::uint8_t>& secret,
+                  const std::vector<std::uint8_t>& data, std::uint32_t memory,
+                  std::uint32_t passes, std::uint32_t lanes, std::uint8_t* out,
+                  std::uint32_t outLength);
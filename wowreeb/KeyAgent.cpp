@@ -0,0 +1,498 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "KeyAgent.hpp"
+
+#include "Credentials.hpp"
+#include "Crypto.hpp"
+#include "ProcessBackend.hpp"
+#include "SecureBuffer.hpp"
+#include "UserSecurity.hpp"
+
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tchar.h>
+#include <vector>
+
+namespace
+{
+// every request and response is a single message of at most this size
+static constexpr DWORD MaxMessage = 4096;
+
+// how long the agent waits on a launcher which has connected to it
+static constexpr DWORD IoTimeout = 5000;
+
+// how long a launcher waits for an agent it has started to begin serving
+static constexpr DWORD StartTimeout = 5000;
+
+// how long a launcher waits while the agent serves others, such as the other
+// clients of a group being launched at once.  each is served in turn.
+static constexpr DWORD BusyTimeout = 2 * IoTimeout;
+
+enum class AgentRequest : std::uint8_t
+{
+    // the parameters, a nul, then the key derived for them
+    Store = 1,
+
+    // a credential
+    Decrypt = 2,
+};
+
+// the first byte of every response.  a successful decryption is followed by
+// the plaintext.
+enum class AgentStatus : std::uint8_t
+{
+    Failed = 0,
+    Succeeded = 1,
+};
+
+// each user has their own agent
+std::wstring PipeName(const std::wstring& sid)
+{
+    return L"\\\\.\\pipe\\wowreeb-agent-" + sid;
+}
+
+// finish an overlapped operation, cancelling it if it outlasts the timeout
+bool Finish(HANDLE pipe, OVERLAPPED& overlapped, DWORD timeout,
+            DWORD& transferred)
+{
+    if (::WaitForSingleObject(overlapped.hEvent, timeout) != WAIT_OBJECT_0)
+        ::CancelIoEx(pipe, &overlapped);
+
+    // this waits for any cancellation to complete
+    return !!::GetOverlappedResult(pipe, &overlapped, &transferred, TRUE);
+}
+
+bool Connect(HANDLE pipe, HANDLE event, DWORD timeout)
+{
+    OVERLAPPED overlapped;
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    overlapped.hEvent = event;
+
+    if (::ConnectNamedPipe(pipe, &overlapped))
+        return true;
+
+    auto const error = ::GetLastError();
+
+    if (error == ERROR_PIPE_CONNECTED)
+        return true;
+
+    DWORD transferred;
+
+    return error == ERROR_IO_PENDING &&
+           Finish(pipe, overlapped, timeout, transferred);
+}
+
+// a message larger than the buffer fails, rather than being read in parts
+bool Transfer(HANDLE pipe, HANDLE event, std::uint8_t* buffer, DWORD length,
+              bool write, DWORD& transferred)
+{
+    OVERLAPPED overlapped;
+    ZeroMemory(&overlapped, sizeof(overlapped));
+    overlapped.hEvent = event;
+
+    auto const started =
+        write ? ::WriteFile(pipe, buffer, length, nullptr, &overlapped) :
+                ::ReadFile(pipe, buffer, length, nullptr, &overlapped);
+
+    if (!started && ::GetLastError() != ERROR_IO_PENDING)
+        return false;
+
+    return Finish(pipe, overlapped, IoTimeout, transferred);
+}
+
+// returns the length of the response, and whether the request succeeded
+DWORD Handle(std::map<std::string, SecureBuffer>& keys,
+             const std::uint8_t* request, DWORD length,
+             std::uint8_t* response, bool& succeeded)
+{
+    response[0] = static_cast<std::uint8_t>(AgentStatus::Failed);
+    succeeded = false;
+
+    if (!length)
+        return 1;
+
+    auto const data = reinterpret_cast<const char*>(request + 1);
+    auto const size = length - 1;
+
+    switch (static_cast<AgentRequest>(request[0]))
+    {
+        case AgentRequest::Store:
+        {
+            auto const nul = static_cast<const char*>(::memchr(data, 0, size));
+
+            if (!nul || data + size - nul - 1 != CryptoProvider::KeyLength)
+                return 1;
+
+            SecureBuffer derived(CryptoProvider::KeyLength);
+            ::memcpy(derived.Data(), nul + 1, derived.Size());
+
+            keys.insert_or_assign(std::string(data, nul), std::move(derived));
+            break;
+        }
+
+        case AgentRequest::Decrypt:
+        {
+            const std::string credential(data, size);
+            auto const key = keys.find(CredentialParams(credential));
+
+            SecureBuffer plaintext(0);
+
+            if (key == keys.end() ||
+                !DecryptDerived(key->second, credential, plaintext) ||
+                plaintext.Size() >= MaxMessage)
+                return 1;
+
+            if (plaintext.Size())
+                ::memcpy(response + 1, plaintext.Data(), plaintext.Size());
+
+            response[0] = static_cast<std::uint8_t>(AgentStatus::Succeeded);
+            succeeded = true;
+
+            return static_cast<DWORD>(1 + plaintext.Size());
+        }
+
+        default:
+            return 1;
+    }
+
+    response[0] = static_cast<std::uint8_t>(AgentStatus::Succeeded);
+    succeeded = true;
+
+    return 1;
+}
+
+// the milliseconds left until the deadline, or zero once it has passed
+DWORD Remaining(std::chrono::steady_clock::time_point deadline)
+{
+    auto const now = std::chrono::steady_clock::now();
+
+    return now >= deadline
+               ? 0
+               : static_cast<DWORD>(
+                     std::chrono::duration_cast<std::chrono::milliseconds>(
+                         deadline - now)
+                         .count());
+}
+
+// connect to the agent, waiting as long as the timeout for one which has not
+// yet started, and a while longer should it be busy.  returns
+// INVALID_HANDLE_VALUE if there is none, or if the pipe belongs to another user.
+HANDLE Open(DWORD startTimeout)
+{
+    std::wstring sid;
+
+    if (!ProcessSid(::GetCurrentProcess(), sid))
+        return INVALID_HANDLE_VALUE;
+
+    auto const name = PipeName(sid);
+    auto const start = std::chrono::steady_clock::now();
+    auto const startDeadline = start + std::chrono::milliseconds(startTimeout);
+    auto const busyDeadline = start + std::chrono::milliseconds(BusyTimeout);
+
+    for (;;)
+    {
+        // the agent may identify us, but not act as us
+        auto const pipe = ::CreateFileW(
+            name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+            OPEN_EXISTING, SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION,
+            nullptr);
+
+        if (pipe != INVALID_HANDLE_VALUE)
+        {
+            // the name is not ours alone, so check that the agent runs as us
+            // before trusting it with anything
+            ULONG serverId = 0;
+            std::wstring serverSid;
+
+            auto trusted = !!::GetNamedPipeServerProcessId(pipe, &serverId);
+
+            if (trusted)
+            {
+                auto const server = ::OpenProcess(
+                    PROCESS_QUERY_LIMITED_INFORMATION, FALSE, serverId);
+
+                trusted = !!server && ProcessSid(server, serverSid) &&
+                          serverSid == sid;
+
+                if (server)
+                    ::CloseHandle(server);
+            }
+
+            DWORD mode = PIPE_READMODE_MESSAGE;
+
+            if (trusted && ::SetNamedPipeHandleState(pipe, &mode, nullptr,
+                                                     nullptr))
+                return pipe;
+
+            ::CloseHandle(pipe);
+            return INVALID_HANDLE_VALUE;
+        }
+
+        auto const error = ::GetLastError();
+
+        // serving another launcher.  should it exit meanwhile, the wait fails
+        // and the pipe is then not found.
+        if (error == ERROR_PIPE_BUSY)
+        {
+            auto const remaining = Remaining(busyDeadline);
+
+            if (!remaining)
+                return INVALID_HANDLE_VALUE;
+
+            ::WaitNamedPipeW(name.c_str(), remaining);
+        }
+        // not yet started
+        else if (error == ERROR_FILE_NOT_FOUND)
+        {
+            auto const remaining = Remaining(startDeadline);
+
+            if (!remaining)
+                return INVALID_HANDLE_VALUE;
+
+            ::Sleep((std::min)(remaining, static_cast<DWORD>(50)));
+        }
+        else
+            return INVALID_HANDLE_VALUE;
+    }
+}
+
+bool Transact(HANDLE pipe, const std::vector<std::uint8_t>& request,
+              SecureBuffer& response, DWORD& length)
+{
+    return !!::TransactNamedPipe(
+               pipe, const_cast<std::uint8_t*>(&request[0]),
+               static_cast<DWORD>(request.size()), response.Data(),
+               static_cast<DWORD>(response.Size()), &length, nullptr) &&
+           length >= 1 &&
+           response.Data()[0] ==
+               static_cast<std::uint8_t>(AgentStatus::Succeeded);
+}
+} // namespace
+
+int RunKeyAgent(std::chrono::minutes idle)
+{
+    std::wstring sid;
+
+    if (!ProcessSid(::GetCurrentProcess(), sid))
+        return EXIT_FAILURE;
+
+    // only this user may open the pipe
+    UserOnlySecurity security(sid);
+
+    if (!security.Get())
+        return EXIT_FAILURE;
+
+    // should an agent already be running, this fails and leaves it to serve
+    auto const pipe = ::CreateNamedPipeW(
+        PipeName(sid).c_str(),
+        PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT |
+            PIPE_REJECT_REMOTE_CLIENTS,
+        1, MaxMessage, MaxMessage, 0, security.Get());
+
+    if (pipe == INVALID_HANDLE_VALUE)
+        return EXIT_FAILURE;
+
+    auto const event = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    // the derived keys, by the parameters they were derived with
+    std::map<std::string, SecureBuffer> keys;
+
+    SecureBuffer request(MaxMessage);
+    SecureBuffer response(MaxMessage);
+
+    // only a request which succeeds keeps the agent alive, so that a launcher
+    // which cannot use it does not hold the keys in memory forever
+    auto lastUsed = std::chrono::steady_clock::now();
+
+    while (!!event)
+    {
+        auto const idleFor = std::chrono::steady_clock::now() - lastUsed;
+
+        if (idleFor >= idle)
+            break;
+
+        auto const remaining = static_cast<DWORD>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(idle -
+                                                                  idleFor)
+                .count());
+
+        if (!Connect(pipe, event, remaining))
+        {
+            ::DisconnectNamedPipe(pipe);
+            continue;
+        }
+
+        DWORD length;
+
+        // a launcher may make several requests before it closes the pipe
+        while (Transfer(pipe, event, request.Data(), MaxMessage, false,
+                        length))
+        {
+            bool succeeded;
+            auto const responseLength = Handle(keys, request.Data(), length,
+                                               response.Data(), succeeded);
+
+            ::SecureZeroMemory(request.Data(), length);
+
+            auto const sent = Transfer(pipe, event, response.Data(),
+                                       responseLength, true, length);
+
+            ::SecureZeroMemory(response.Data(), responseLength);
+
+            if (!sent)
+                break;
+
+            if (succeeded)
+                lastUsed = std::chrono::steady_clock::now();
+        }
+
+        ::DisconnectNamedPipe(pipe);
+    }
+
+    if (event)
+        ::CloseHandle(event);
+
+    ::CloseHandle(pipe);
+
+    // the keys are wiped as they are released
+    return EXIT_SUCCESS;
+}
+
+bool ShareKey(const std::string& key,
+              const std::vector<std::string>& credentials,
+              std::chrono::minutes idle)
+{
+    // one key is derived for each set of parameters.  legacy credentials are
+    // encrypted with the key itself, so the agent cannot hold a key for them.
+    std::map<std::string, const std::string*> distinct;
+
+    for (auto const& credential : credentials)
+    {
+        auto params = CredentialParams(credential);
+
+        if (!params.empty())
+            distinct.emplace(std::move(params), &credential);
+    }
+
+    if (distinct.empty())
+        return false;
+
+    auto pipe = Open(0);
+
+    if (pipe == INVALID_HANDLE_VALUE)
+    {
+        TCHAR path[MAX_PATH];
+
+        if (!::GetModuleFileName(nullptr, path, MAX_PATH))
+            return false;
+
+        try
+        {
+            GetProcessBackend().StartDetached(
+                fs::path(path), {{EnvAgent, std::to_string(idle.count())}});
+        }
+        catch (std::runtime_error const&)
+        {
+            return false;
+        }
+
+        pipe = Open(StartTimeout);
+
+        if (pipe == INVALID_HANDLE_VALUE)
+            return false;
+    }
+
+    auto result = true;
+    SecureBuffer response(MaxMessage);
+
+    for (auto const& params : distinct)
+    {
+        SecureBuffer derived(0);
+
+        if (!DeriveCredentialKey(key, *params.second, derived))
+            continue;
+
+        std::vector<std::uint8_t> request;
+        request.reserve(1 + params.first.length() + 1 + derived.Size());
+
+        request.push_back(static_cast<std::uint8_t>(AgentRequest::Store));
+        request.insert(request.end(), params.first.begin(), params.first.end());
+        request.push_back(0);
+        request.insert(request.end(), derived.Data(),
+                       derived.Data() + derived.Size());
+
+        DWORD length;
+        result = Transact(pipe, request, response, length) && result;
+
+        ::SecureZeroMemory(&request[0], request.size());
+    }
+
+    ::CloseHandle(pipe);
+
+    return result;
+}
+
+bool AgentDecrypt(const std::string& credential, SecureBuffer& plaintext)
+{
+    if (credential.length() >= MaxMessage)
+        return false;
+
+    auto const pipe = Open(0);
+
+    if (pipe == INVALID_HANDLE_VALUE)
+        return false;
+
+    std::vector<std::uint8_t> request;
+    request.reserve(1 + credential.length());
+    request.push_back(static_cast<std::uint8_t>(AgentRequest::Decrypt));
+    request.insert(request.end(), credential.begin(), credential.end());
+
+    SecureBuffer response(MaxMessage);
+    DWORD length;
+
+    auto const result = Transact(pipe, request, response, length);
+
+    ::CloseHandle(pipe);
+
+    if (result)
+    {
+        plaintext = SecureBuffer(length - 1);
+
+        if (plaintext.Size())
+            ::memcpy(plaintext.Data(), response.Data() + 1, plaintext.Size());
+    }
+
+    return result;
+}
@@ -0,0 +1,55 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+class SecureBuffer;
+
+// the key agent keeps the keys derived from the user's key, so that launchers
+// started later, of either architecture, can decrypt credentials without the
+// key being entered or derived again.  the key itself never reaches it.  it is
+// a launcher started in the background with this variable set to its idle
+// timeout in minutes, serving launchers over a named pipe which only the same
+// user may open, and it exits once it has gone unused for that long.
+static constexpr char EnvAgent[] = "WOWREEB_AGENT";
+
+// serve requests until the agent has been idle for the timeout.  returns the
+// exit code of the process.
+int RunKeyAgent(std::chrono::minutes idle);
+
+// give the agent the keys derived for the parameters of the credentials,
+// starting it if it is not already running.  returns false if it could not be
+// reached.
+bool ShareKey(const std::string& key,
+              const std::vector<std::string>& credentials,
+              std::chrono::minutes idle);
+
+// returns false if there is no agent, or it holds no key which decrypts the
+// credential
+bool AgentDecrypt(const std::string& credential, SecureBuffer& plaintext);
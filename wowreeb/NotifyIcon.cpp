@@ -103,6 +103,13 @@ void NotifyIcon::ToggleMenu()
                 InsertMenu(menu, -1, MF_BYPOSITION, buttonId,
                            _menuEntries[i].text);
             }
+
+            if (!_menuEntries[i].details)
+                continue;
+
+            for (auto const& line : _menuEntries[i].details())
+                InsertMenu(menu, -1, MF_BYPOSITION | MF_GRAYED, 0,
+                           line.c_str());
         }
     }
 
@@ -120,7 +127,7 @@ void NotifyIcon::ClearMenu()
 }
 
 void NotifyIcon::AddMenu(const TCHAR* text, std::function<void()> callback,
-                         int position)
+                         int position, MenuDetails details)
 {
     constexpr int maxEntries = (1 << MenuBits) - 1;
 
@@ -134,7 +141,7 @@ void NotifyIcon::AddMenu(const TCHAR* text, std::function<void()> callback,
             (_menuEntries.end()) :
             (_menuEntries.begin() + position);
 
-    _menuEntries.emplace(pos, text, callback);
+    _menuEntries.emplace(pos, text, callback, details);
 }
 
 void NotifyIcon::ClickMenu(unsigned int menuId) const
@@ -28,6 +28,7 @@
 #include <Windows.h>
 #include <functional>
 #include <mutex>
+#include <string>
 #include <strsafe.h>
 #include <vector>
 
@@ -37,6 +38,9 @@ public:
     static constexpr int IconBits = 7;
     static constexpr int MenuBits = 14 - IconBits;
 
+    // informational lines shown beneath a menu entry each time the menu opens
+    using MenuDetails = std::function<std::vector<std::basic_string<TCHAR>>()>;
+
 private:
     static_assert(IconBits > 0 && MenuBits > 0 && IconBits + MenuBits == 14,
                   "IconBits + MenuBits must be 14");
@@ -50,8 +54,10 @@ private:
     {
         TCHAR text[32];
         std::function<void()> callback;
+        MenuDetails details;
 
-        MenuEntry(const TCHAR* t, std::function<void()> cb) : callback(cb)
+        MenuEntry(const TCHAR* t, std::function<void()> cb, MenuDetails d)
+            : callback(cb), details(d)
         {
             StringCchCopy(text, ARRAYSIZE(text), t);
         }
@@ -71,6 +77,6 @@ public:
 
     void ClearMenu();
     void AddMenu(const TCHAR* text, std::function<void()> callback = nullptr,
-                 int position = -1);
+                 int position = -1, MenuDetails details = nullptr);
     void ClickMenu(unsigned int menuId) const;
 };
\ No newline at end of file
@@ -0,0 +1,137 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Placement.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+unsigned int ParseProcessor(const std::string& text)
+{
+    std::size_t end = 0;
+    unsigned long result;
+
+    try
+    {
+        result = std::stoul(text, &end);
+    }
+    catch (std::logic_error const&)
+    {
+        end = 0;
+    }
+
+    if (!end || text.find_first_not_of(" \t", end) != std::string::npos ||
+        result > 0xFFFF)
+    {
+        std::stringstream str;
+        str << "Invalid logical processor \"" << text << "\"";
+        throw std::runtime_error(str.str());
+    }
+
+    return static_cast<unsigned int>(result);
+}
+} // namespace
+
+std::vector<unsigned int> ParseProcessorList(const std::string& list)
+{
+    std::vector<unsigned int> result;
+    std::stringstream str(list);
+    std::string range;
+
+    while (std::getline(str, range, ','))
+    {
+        if (range.find_first_not_of(" \t") == std::string::npos)
+            continue;
+
+        auto const dash = range.find('-');
+
+        if (dash == std::string::npos)
+        {
+            result.push_back(ParseProcessor(range));
+            continue;
+        }
+
+        auto const first = ParseProcessor(range.substr(0, dash));
+        auto const last = ParseProcessor(range.substr(dash + 1));
+
+        if (last < first)
+        {
+            std::stringstream msg;
+            msg << "Invalid logical processor range \"" << range << "\"";
+            throw std::runtime_error(msg.str());
+        }
+
+        for (auto i = first; i <= last; ++i)
+            result.push_back(i);
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+
+    return result;
+}
+
+std::string FormatProcessorList(const std::vector<unsigned int>& processors)
+{
+    std::stringstream str;
+
+    for (auto i = 0u; i < processors.size(); ++i)
+    {
+        if (i)
+            str << ',';
+
+        str << processors[i];
+    }
+
+    return str.str();
+}
+
+std::vector<unsigned int> PlanAffinity(const CoreTopology& cores,
+                                       std::size_t clients, std::size_t index)
+{
+    std::vector<unsigned int> result;
+
+    // a lone client may as well use the whole machine
+    if (cores.empty() || clients < 2)
+        return result;
+
+    if (clients >= cores.size())
+        result = cores[index % cores.size()];
+    else
+    {
+        for (auto i = index; i < cores.size(); i += clients)
+            result.insert(result.end(), cores[i].begin(), cores[i].end());
+    }
+
+    std::sort(result.begin(), result.end());
+
+    return result;
+}
@@ -0,0 +1,71 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class ProcessPriority
+{
+    Default, // inherited from the launcher
+    Idle,
+    BelowNormal,
+    Normal,
+    AboveNormal,
+    High,
+};
+
+// where and at what priority a client runs, applied before it is resumed
+struct ProcessPlacement
+{
+    // logical processors the client may run on.  empty to leave unrestricted.
+    std::vector<unsigned int> Affinity;
+
+    // when launched as part of a group, spread the clients across physical
+    // cores rather than using a fixed affinity
+    bool AutoAffinity;
+
+    ProcessPriority Priority;
+
+    // logical processors whose cpu sets the client prefers.  unlike the
+    // affinity, the system may still schedule the client elsewhere.
+    std::vector<unsigned int> CpuSets;
+};
+
+// every physical core, given as the logical processors which belong to it
+using CoreTopology = std::vector<std::vector<unsigned int>>;
+
+// parse a list of logical processors such as "0,2,4-7".  throws on error.
+std::vector<unsigned int> ParseProcessorList(const std::string& list);
+
+std::string FormatProcessorList(const std::vector<unsigned int>& processors);
+
+// choose the logical processors for one client of a group.  physical cores are
+// dealt to the clients in turn, so no two clients share a core unless there
+// are more clients than cores.  an empty result leaves the client unrestricted.
+std::vector<unsigned int> PlanAffinity(const CoreTopology& cores,
+                                       std::size_t clients, std::size_t index);
@@ -0,0 +1,90 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+// the few services of windows used by code which the tests also build
+// elsewhere, such as the cryptography and the cache folders
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <Windows.h>
+
+// this depends on the types declared by windows.h
+#include <bcrypt.h>
+
+#pragma comment(lib, "bcrypt.lib")
+#else
+#include <fstream>
+
+#include <unistd.h>
+
+// wipe memory in a way the compiler may not remove as a dead store
+inline void* SecureZeroMemory(void* data, std::size_t length)
+{
+    auto bytes = static_cast<volatile std::uint8_t*>(data);
+
+    while (length--)
+        *bytes++ = 0;
+
+    return data;
+}
+#endif
+
+inline unsigned long CurrentProcessId()
+{
+#ifdef _WIN32
+    return ::GetCurrentProcessId();
+#else
+    return static_cast<unsigned long>(::getpid());
+#endif
+}
+
+// lower both the cpu and i/o priority of the calling thread, for work nobody is
+// waiting on.  elsewhere the thread is left as it is.
+inline void BeginBackgroundWork()
+{
+#ifdef _WIN32
+    ::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+}
+
+// fill the buffer from the system's cryptographically secure generator.
+// returns false if it could not be read.
+inline bool SystemRandom(std::uint8_t* buffer, std::size_t length)
+{
+#ifdef _WIN32
+    return BCRYPT_SUCCESS(::BCryptGenRandom(nullptr, buffer,
+                                            static_cast<ULONG>(length),
+                                            BCRYPT_USE_SYSTEM_PREFERRED_RNG));
+#else
+    std::ifstream random("/dev/urandom", std::ios::binary);
+
+    return !!random.read(reinterpret_cast<char*>(buffer),
+                         static_cast<std::streamsize>(length));
+#endif
+}
@@ -0,0 +1,307 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Predictor.hpp"
+
+#include <Windows.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// each launch counts for a little less than the one after it, so that the
+// history follows changes in habit
+static constexpr double Decay = 0.95;
+
+// the likelihood of a realm halves for every week in which it is not launched
+static constexpr double HalfLifeDays = 7.0;
+
+// realms scoring less than this are never predicted
+static constexpr double MinScore = 0.15;
+
+// a realm prepared but not launched within this time was prepared in vain
+static constexpr auto PreparedWindow = std::chrono::hours(2);
+
+struct RealmHistory
+{
+    std::time_t Last;
+
+    // decayed launch counts for each hour of the day
+    std::array<double, 24> Hours;
+};
+
+struct Preparation
+{
+    std::chrono::steady_clock::time_point Time;
+    std::uint64_t Bytes;
+};
+
+std::mutex historyMutex;
+bool historyLoaded = false;
+std::map<std::string, RealmHistory> history;
+
+std::map<std::string, Preparation> prepared;
+PredictionStats stats {};
+
+fs::path HistoryPath()
+{
+    wchar_t path[MAX_PATH];
+
+    if (!::GetModuleFileNameW(nullptr, path, MAX_PATH))
+        throw std::runtime_error("GetModuleFileName failed");
+
+    return fs::path(path).parent_path() / "wowreeb.history";
+}
+
+// each line holds the time of the last launch of a realm, its hourly counts
+// and its name
+void LoadHistory()
+{
+    std::ifstream fd(HistoryPath());
+    std::string line;
+
+    while (std::getline(fd, line))
+    {
+        std::stringstream str(line);
+        RealmHistory realm;
+        std::string name;
+
+        if (!(str >> realm.Last))
+            continue;
+
+        auto valid = true;
+
+        for (auto& count : realm.Hours)
+            valid = valid && !!(str >> count);
+
+        if (!valid || str.get() != '\t' || !std::getline(str, name) ||
+            name.empty())
+            continue;
+
+        history[name] = realm;
+    }
+}
+
+void SaveHistory()
+{
+    auto const path = HistoryPath();
+    auto temp = path;
+    temp += "." + std::to_string(::GetCurrentProcessId());
+
+    {
+        std::ofstream fd(temp, std::ios::trunc);
+
+        for (auto const& realm : history)
+        {
+            fd << realm.second.Last;
+
+            for (auto const count : realm.second.Hours)
+                fd << ' ' << count;
+
+            fd << '\t' << realm.first << '\n';
+        }
+
+        if (!fd)
+            return;
+    }
+
+    if (!::MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+        ::DeleteFileW(temp.c_str());
+}
+
+void EnsureLoaded()
+{
+    if (historyLoaded)
+        return;
+
+    LoadHistory();
+    historyLoaded = true;
+}
+
+int LocalHour(std::time_t time)
+{
+    std::tm local;
+
+    if (localtime_s(&local, &time))
+        return 0;
+
+    return local.tm_hour;
+}
+
+// the share of a realm's launches which happened around this hour, reduced
+// according to how long ago it was last launched
+double Score(const RealmHistory& realm, std::time_t now)
+{
+    double total = 0.0;
+
+    for (auto const count : realm.Hours)
+        total += count;
+
+    if (total <= 0.0)
+        return 0.0;
+
+    auto const hour = LocalHour(now);
+    auto const& hours = realm.Hours;
+
+    auto const around = hours[hour] + 0.5 * hours[(hour + 23) % 24] +
+                        0.5 * hours[(hour + 1) % 24];
+
+    auto const days = std::max(0.0, std::difftime(now, realm.Last) / 86400.0);
+
+    return std::min(1.0, around / total) * std::pow(0.5, days / HalfLifeDays);
+}
+
+// preparations which have outlived the window were wasted
+void ExpirePrepared()
+{
+    auto const now = std::chrono::steady_clock::now();
+
+    for (auto i = prepared.begin(); i != prepared.end();)
+    {
+        if (now - i->second.Time < PreparedWindow)
+        {
+            ++i;
+            continue;
+        }
+
+        stats.WastedBytes += i->second.Bytes;
+        i = prepared.erase(i);
+    }
+}
+} // namespace
+
+void RecordLaunch(const std::string& realm)
+{
+    std::lock_guard<std::mutex> guard(historyMutex);
+
+    EnsureLoaded();
+    ExpirePrepared();
+
+    ++stats.Launches;
+
+    auto const i = prepared.find(realm);
+
+    if (i != prepared.end())
+    {
+        ++stats.Hits;
+        prepared.erase(i);
+    }
+
+    auto const now = std::time(nullptr);
+    auto const hour = LocalHour(now);
+
+    auto& entry = history[realm];
+
+    for (auto h = 0; h < 24; ++h)
+        entry.Hours[h] = entry.Hours[h] * Decay + (h == hour ? 1.0 : 0.0);
+
+    entry.Last = now;
+
+    SaveHistory();
+}
+
+std::vector<std::string> PredictLaunches(std::size_t count)
+{
+    std::lock_guard<std::mutex> guard(historyMutex);
+
+    EnsureLoaded();
+
+    auto const now = std::time(nullptr);
+
+    std::vector<std::pair<double, std::string>> scores;
+
+    for (auto const& realm : history)
+    {
+        auto const score = Score(realm.second, now);
+
+        if (score >= MinScore)
+            scores.emplace_back(score, realm.first);
+    }
+
+    std::sort(scores.begin(), scores.end(),
+              [](const std::pair<double, std::string>& a,
+                 const std::pair<double, std::string>& b)
+              { return a.first > b.first; });
+
+    std::vector<std::string> result;
+
+    for (auto i = 0u; i < scores.size() && i < count; ++i)
+        result.push_back(scores[i].second);
+
+    return result;
+}
+
+bool RecordPrepared(const std::string& realm)
+{
+    std::lock_guard<std::mutex> guard(historyMutex);
+
+    ExpirePrepared();
+
+    if (prepared.find(realm) != prepared.end())
+        return false;
+
+    prepared[realm] = {std::chrono::steady_clock::now(), 0};
+    ++stats.Predictions;
+
+    return true;
+}
+
+void RecordPrefetched(const std::string& realm, std::uint64_t bytes)
+{
+    std::lock_guard<std::mutex> guard(historyMutex);
+
+    stats.PrefetchedBytes += bytes;
+
+    // if the realm has already been launched, the bytes were put to use
+    auto const i = prepared.find(realm);
+
+    if (i != prepared.end())
+        i->second.Bytes += bytes;
+}
+
+PredictionStats GetPredictionStats()
+{
+    std::lock_guard<std::mutex> guard(historyMutex);
+
+    ExpirePrepared();
+
+    return stats;
+}
@@ -0,0 +1,64 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct PredictionStats
+{
+    // launches recorded since the launcher started
+    unsigned int Launches;
+
+    // realms prepared ahead of a predicted launch
+    unsigned int Predictions;
+
+    // launches of a realm which had been prepared for it
+    unsigned int Hits;
+
+    std::uint64_t PrefetchedBytes;
+
+    // bytes read ahead for realms which were not then launched
+    std::uint64_t WastedBytes;
+};
+
+// remember that the realm was launched at this time of day
+void RecordLaunch(const std::string& realm);
+
+// the realms most likely to be launched soon, most likely first.  realms which
+// are unlikely to be launched are not included at all.
+std::vector<std::string> PredictLaunches(std::size_t count);
+
+// note that the realm has been prepared ahead of a predicted launch.  returns
+// false if it already was, and that preparation has not yet expired.
+bool RecordPrepared(const std::string& realm);
+
+// add to the bytes read ahead for a prepared realm
+void RecordPrefetched(const std::string& realm, std::uint64_t bytes);
+
+PredictionStats GetPredictionStats();
@@ -0,0 +1,225 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Prefetcher.hpp"
+
+#include "Platform.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// never prefetch more than this fraction of the memory which is available
+static constexpr unsigned int MemoryDivisor = 2;
+static constexpr unsigned int ThreadCount = 2;
+static constexpr std::size_t ChunkSize = 1024 * 1024;
+
+std::mutex inFlightMutex;
+std::set<fs::path> inFlight;
+
+bool IsArchive(const fs::path& file)
+{
+    auto ext = file.extension().string();
+
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    return ext == ".mpq";
+}
+
+// the archives in the data folder itself, followed by those in the locale
+// folders beneath it
+std::vector<std::pair<fs::path, std::uintmax_t>>
+FindArchives(const fs::path& clientDir)
+{
+    std::vector<std::pair<fs::path, std::uintmax_t>> result;
+    std::vector<fs::path> locales;
+    std::error_code ec;
+
+    for (auto const& entry : fs::directory_iterator(clientDir / "Data", ec))
+    {
+        if (entry.is_directory(ec))
+            locales.push_back(entry.path());
+        else if (IsArchive(entry.path()))
+            result.emplace_back(entry.path(), entry.file_size(ec));
+    }
+
+    for (auto const& locale : locales)
+        for (auto const& entry : fs::directory_iterator(locale, ec))
+            if (!entry.is_directory(ec) && IsArchive(entry.path()))
+                result.emplace_back(entry.path(), entry.file_size(ec));
+
+    return result;
+}
+
+// the data is discarded.  what we want is for it to be in the page cache.
+std::uint64_t ReadFile(const fs::path& file, std::vector<std::uint8_t>& buffer)
+{
+    std::uint64_t total = 0;
+
+#ifdef _WIN32
+    auto const handle = ::CreateFileW(
+        file.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (handle == INVALID_HANDLE_VALUE)
+        return 0;
+
+    DWORD read;
+
+    while (::ReadFile(handle, &buffer[0], static_cast<DWORD>(ChunkSize), &read,
+                      nullptr) &&
+           read > 0)
+        total += read;
+
+    ::CloseHandle(handle);
+#else
+    auto const fd = ::open(file.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return 0;
+
+    // as FILE_FLAG_SEQUENTIAL_SCAN, this widens the kernel's read ahead
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    ssize_t read;
+
+    while ((read = ::read(fd, &buffer[0], ChunkSize)) > 0)
+        total += static_cast<std::uint64_t>(read);
+
+    ::close(fd);
+#endif
+
+    return total;
+}
+
+// memory which could be given to the page cache without paging anything out
+std::uint64_t AvailableMemory()
+{
+#ifdef _WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+
+    return ::GlobalMemoryStatusEx(&status) ? status.ullAvailPhys : 0;
+#else
+    auto const pages = ::sysconf(_SC_AVPHYS_PAGES);
+    auto const pageSize = ::sysconf(_SC_PAGESIZE);
+
+    return pages > 0 && pageSize > 0 ? static_cast<std::uint64_t>(pages) *
+                                           static_cast<std::uint64_t>(pageSize)
+                                     : 0;
+#endif
+}
+
+void PrefetchThread(fs::path clientDir,
+                    std::function<void(std::uint64_t)> done)
+{
+    // so that the client itself is always served first
+    BeginBackgroundWork();
+
+    auto archives = FindArchives(clientDir);
+    auto budget = AvailableMemory() / MemoryDivisor;
+
+    // take archives in order for as long as they fit within the budget
+    std::vector<fs::path> work;
+
+    for (auto const& archive : archives)
+    {
+        if (archive.second > budget)
+            continue;
+
+        budget -= archive.second;
+        work.push_back(archive.first);
+    }
+
+    std::atomic<size_t> next {0};
+    std::atomic<std::uint64_t> total {0};
+
+    auto const worker = [&work, &next, &total]()
+    {
+        BeginBackgroundWork();
+
+        std::vector<std::uint8_t> buffer(ChunkSize);
+
+        for (auto i = next++; i < work.size(); i = next++)
+            total += ReadFile(work[i], buffer);
+    };
+
+    std::vector<std::thread> threads;
+
+    for (auto i = 1u; i < ThreadCount; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for (auto& thread : threads)
+        thread.join();
+
+    {
+        std::lock_guard<std::mutex> guard(inFlightMutex);
+        inFlight.erase(clientDir);
+    }
+
+    if (done)
+        done(total);
+}
+} // namespace
+
+void PrefetchClientData(const fs::path& clientDir,
+                        std::function<void(std::uint64_t)> done)
+{
+    {
+        std::lock_guard<std::mutex> guard(inFlightMutex);
+
+        // this client's data is already being prefetched
+        if (!inFlight.insert(clientDir).second)
+        {
+            if (done)
+                done(0);
+
+            return;
+        }
+    }
+
+    std::thread prefetch(PrefetchThread, clientDir, std::move(done));
+    prefetch.detach();
+}
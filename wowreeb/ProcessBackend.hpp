@@ -0,0 +1,181 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Governor.hpp"
+#include "Placement.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// counts every operation which crosses into another process, so that the cost
+// of a launch can be expressed in round-trips
+struct BackendCounters
+{
+    std::atomic<unsigned int> Launches {0};
+    std::atomic<unsigned int> Injections {0};
+    std::atomic<unsigned int> RemoteCalls {0};
+    std::atomic<unsigned int> Resumes {0};
+    std::atomic<unsigned int> Terminations {0};
+    std::atomic<unsigned int> Ejections {0};
+
+    // the memory operations performed within the client by the round-trips
+    // above.  they are not round-trips of their own.
+    std::atomic<unsigned int> Reads {0};
+    std::atomic<unsigned int> Writes {0};
+    std::atomic<unsigned int> Allocations {0};
+
+    unsigned int RoundTrips() const
+    {
+        return Injections + RemoteCalls + Resumes + Terminations + Ejections;
+    }
+};
+
+// a client process which was created suspended with our dll loaded into it
+class ClientProcess
+{
+public:
+    virtual ~ClientProcess() = default;
+
+    virtual unsigned int GetId() const = 0;
+
+    // base address of our dll within the client
+    virtual std::uint8_t* GetModule() const = 0;
+
+    // call a function within the client which takes no arguments
+    virtual std::uintptr_t Call(const std::uint8_t* func) = 0;
+
+    // memory committed by the client which is not shared with other processes
+    virtual std::size_t GetPrivateBytes() const = 0;
+
+    // apply the affinity, priority and cpu sets.  throws on failure.
+    virtual void Place(const ProcessPlacement& placement) = 0;
+
+    // while tied, the client is ended should the launcher exit for any reason,
+    // including a crash.  throws on failure.
+    virtual void TieToLauncher(bool tied) = 0;
+
+    virtual void Resume() = 0;
+    virtual void Terminate() = 0;
+
+    // unload our dll from the client
+    virtual void Eject() = 0;
+
+    // returns true if the client has exited within the given time
+    virtual bool WaitForExit(unsigned int milliseconds) = 0;
+};
+
+// resource usage of a process, accumulated over its lifetime where that makes
+// sense
+struct ProcessSample
+{
+    std::chrono::microseconds CpuTime;
+    std::uint64_t WorkingSet;
+    std::uint64_t PrivateBytes;
+    unsigned int Handles;
+    std::uint64_t ReadBytes;
+    std::uint64_t WriteBytes;
+};
+
+// a client which is already running, opened by its id
+class RunningProcess
+{
+public:
+    virtual ~RunningProcess() = default;
+
+    virtual bool HasExited() = 0;
+
+    // only meaningful once the process has exited
+    virtual unsigned int GetExitCode() = 0;
+
+    // returns false if the usage could not be read
+    virtual bool Sample(ProcessSample& sample) = 0;
+
+    // replace any restraints previously applied.  this is best effort, and
+    // restraints which the system does not support are ignored.
+    virtual void Apply(const ClientThrottle& throttle) = 0;
+};
+
+// every interaction the launcher has with other processes goes through this
+// interface
+class ProcessBackend
+{
+public:
+    BackendCounters Counters;
+
+    virtual ~ProcessBackend() = default;
+
+    virtual bool Is32Bit(const fs::path& exe) = 0;
+
+    virtual CoreTopology GetPhysicalCores() = 0;
+
+    // bytes of physical memory which are available.  returns false if this
+    // cannot be measured.
+    virtual bool GetAvailableMemory(std::uint64_t& bytes) = 0;
+
+    // the number of requests waiting on the disks.  returns false if this
+    // cannot be measured.
+    virtual bool GetDiskQueueLength(double& length) = 0;
+
+    // the id of the process which owns the foreground window
+    virtual unsigned int GetForegroundProcess() = 0;
+
+    virtual std::unique_ptr<RunningProcess> Open(unsigned int pid) = 0;
+
+    virtual std::unique_ptr<ClientProcess>
+    CreateSuspended(const fs::path& exe, const std::vector<std::wstring>& args,
+                    const fs::path& dll) = 0;
+
+    // run another launcher executable with our environment plus the given
+    // variables, without waiting for it.  the result becomes the id of the
+    // client which it reports with ReportToLauncher, or zero if it exits
+    // without reporting one.
+    virtual std::shared_future<unsigned int> StartLauncher(
+        const fs::path& exe,
+        const std::vector<std::pair<std::string, std::string>>& env) = 0;
+
+    // tell the launcher which started us with StartLauncher the id of the
+    // client we created.  returns false if we were not started that way.
+    virtual bool ReportToLauncher(unsigned int pid) = 0;
+
+    // as above, but in the background without a console, and without waiting
+    virtual void StartDetached(
+        const fs::path& exe,
+        const std::vector<std::pair<std::string, std::string>>& env) = 0;
+};
+
+// the backend used to launch real clients, implemented with hadesmem
+ProcessBackend& GetProcessBackend();
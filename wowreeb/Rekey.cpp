@@ -0,0 +1,316 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Rekey.hpp"
+
+#include "Credentials.hpp"
+#include "Kdf.hpp"
+#include "SecureBuffer.hpp"
+#include "Vault.hpp"
+#include "rapidxml/rapidxml.hpp"
+
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// rapidxml_print calls its printers before declaring them, which a conforming
+// compiler will not look up from the point of instantiation
+namespace rapidxml
+{
+namespace internal
+{
+template <class OutIt, class Ch>
+inline OutIt print_children(OutIt out, const xml_node<Ch>* node, int flags,
+                            int indent);
+template <class OutIt, class Ch>
+inline OutIt print_element_node(OutIt out, const xml_node<Ch>* node, int flags,
+                                int indent);
+template <class OutIt, class Ch>
+inline OutIt print_data_node(OutIt out, const xml_node<Ch>* node, int flags,
+                             int indent);
+template <class OutIt, class Ch>
+inline OutIt print_cdata_node(OutIt out, const xml_node<Ch>* node, int flags,
+                              int indent);
+template <class OutIt, class Ch>
+inline OutIt print_declaration_node(OutIt out, const xml_node<Ch>* node,
+                                    int flags, int indent);
+template <class OutIt, class Ch>
+inline OutIt print_comment_node(OutIt out, const xml_node<Ch>* node, int flags,
+                                int indent);
+template <class OutIt, class Ch>
+inline OutIt print_doctype_node(OutIt out, const xml_node<Ch>* node, int flags,
+                                int indent);
+template <class OutIt, class Ch>
+inline OutIt print_pi_node(OutIt out, const xml_node<Ch>* node, int flags,
+                           int indent);
+} // namespace internal
+} // namespace rapidxml
+
+#include "rapidxml/rapidxml_print.hpp"
+
+namespace
+{
+// credentials claimed by a worker at once, so that workers do not contend on
+// the counter
+static constexpr std::size_t Batch = 64;
+
+std::vector<char> ReadFile(const fs::path& file)
+{
+    std::ifstream fd(file);
+
+    if (!fd)
+        throw std::runtime_error("Failed to open config file");
+
+    std::vector<char> text((std::istreambuf_iterator<char>(fd)),
+                           std::istreambuf_iterator<char>());
+
+    // rapidxml parses until it finds a nul
+    text.push_back('\0');
+
+    return text;
+}
+
+void WriteFile(const fs::path& file, const std::string& text)
+{
+    auto temp = file;
+    temp += "." + std::to_string(::GetCurrentProcessId());
+
+    {
+        std::ofstream fd(temp, std::ios::trunc);
+        fd << text;
+
+        if (!fd)
+        {
+            fd.close();
+            ::DeleteFileW(temp.c_str());
+            throw std::runtime_error("Failed to write config file");
+        }
+    }
+
+    // replace the file atomically so that the credentials are never left half
+    // encrypted by one key and half by the other
+    if (!::MoveFileExW(temp.c_str(), file.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        ::DeleteFileW(temp.c_str());
+        throw std::runtime_error("Failed to replace config file");
+    }
+}
+
+// the attributes holding every credential in the document
+std::vector<rapidxml::xml_attribute<>*>
+FindCredentials(const rapidxml::xml_node<>* root)
+{
+    std::vector<rapidxml::xml_attribute<>*> result;
+
+    for (auto n = root->first_node(); !!n; n = n->next_sibling())
+    {
+        if (n->type() != rapidxml::node_element)
+            continue;
+
+        const std::string name(n->name());
+
+        if (name == "Realm")
+        {
+            for (auto c = n->first_node("Credentials"); !!c;
+                 c = c->next_sibling("Credentials"))
+            {
+                auto const password = c->first_attribute("Password");
+
+                if (!!password && password->value_size())
+                    result.push_back(password);
+            }
+        }
+        else if (name == "Config")
+        {
+            auto const configName = n->first_attribute("Name");
+            auto const configValue = n->first_attribute("Value");
+
+            if (!!configName && std::string(configName->value()) == "KeyCheck" &&
+                !!configValue && configValue->value_size())
+                result.push_back(configValue);
+        }
+    }
+
+    return result;
+}
+
+// the vault named by the config file, if any
+fs::path FindVault(const fs::path& file, const rapidxml::xml_node<>* root)
+{
+    for (auto n = root->first_node("Config"); !!n;
+         n = n->next_sibling("Config"))
+    {
+        auto const configName = n->first_attribute("Name");
+        auto const configValue = n->first_attribute("Value");
+
+        if (!configName || std::string(configName->value()) != "Vault" ||
+            !configValue)
+            continue;
+
+        fs::path vault(configValue->value());
+
+        return vault.is_relative() ? file.parent_path() / vault : vault;
+    }
+
+    return {};
+}
+} // namespace
+
+RekeyResult RekeyConfig(const fs::path& file, const std::string& oldKey,
+                        const std::string& newKey)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    auto text = ReadFile(file);
+
+    rapidxml::xml_document<> doc;
+    doc.parse<rapidxml::parse_comment_nodes |
+              rapidxml::parse_declaration_node | rapidxml::parse_doctype_node>(
+        &text[0]);
+
+    auto const root = doc.first_node("wowreeb");
+
+    if (!root)
+        throw std::runtime_error("No wowreeb node found in config file");
+
+    auto const credentials = FindCredentials(root);
+    auto const vaultPath = FindVault(file, root);
+
+    std::vector<VaultRecord> records;
+
+    if (!vaultPath.empty())
+        records = Vault(vaultPath).Records();
+
+    // those in the config file, followed by those in the vault
+    std::vector<std::string> existing;
+    existing.reserve(credentials.size() + records.size());
+
+    for (auto const credential : credentials)
+        existing.emplace_back(credential->value(), credential->value_size());
+
+    for (auto const& record : records)
+        existing.push_back(record.Credential);
+
+    // the new key gets parameters of its own, rather than those of the
+    // credentials it replaces, which may have been calibrated elsewhere
+    auto const params = CalibrateCredentialKdf();
+
+    std::vector<std::string> encrypted(existing.size());
+    std::atomic<std::size_t> next {0};
+    std::atomic<bool> failed {false};
+
+    // each key is derived once for its parameters, by whichever worker needs
+    // it first, while the others wait
+    auto const worker = [&]()
+    {
+        SecureBuffer plaintext(0);
+
+        while (!failed)
+        {
+            auto const first = next.fetch_add(Batch);
+
+            if (first >= existing.size())
+                return;
+
+            auto const last = (std::min)(first + Batch, existing.size());
+
+            for (auto i = first; i < last; ++i)
+            {
+                if (!DecryptCredential(oldKey, existing[i], plaintext))
+                {
+                    failed = true;
+                    return;
+                }
+
+                encrypted[i] = EncryptCredential(newKey, plaintext, params);
+            }
+        }
+    };
+
+    auto const threads =
+        (std::max)(1u, (std::min)(std::thread::hardware_concurrency(),
+                                  static_cast<unsigned int>(
+                                      existing.size() / Batch + 1)));
+
+    std::vector<std::future<void>> workers;
+
+    for (auto i = 1u; i < threads; ++i)
+        workers.push_back(std::async(std::launch::async, worker));
+
+    worker();
+
+    for (auto& w : workers)
+        w.get();
+
+    if (failed)
+        throw std::runtime_error("Old key does not decrypt every credential");
+
+    for (auto i = 0u; i < credentials.size(); ++i)
+        credentials[i]->value(doc.allocate_string(encrypted[i].c_str()),
+                              encrypted[i].length());
+
+    for (auto i = 0u; i < records.size(); ++i)
+        records[i].Credential = std::move(encrypted[credentials.size() + i]);
+
+    std::string output;
+    rapidxml::print(std::back_inserter(output), doc);
+
+    // the two files cannot be replaced together, so the user must be told if
+    // only the vault was
+    if (!vaultPath.empty())
+    {
+        Vault::Write(vaultPath, std::move(records));
+
+        try
+        {
+            WriteFile(file, output);
+        }
+        catch (std::runtime_error const& e)
+        {
+            throw std::runtime_error(
+                std::string(e.what()) +
+                ".  The vault is already encrypted with the new key");
+        }
+    }
+    else
+        WriteFile(file, output);
+
+    return {existing.size(),
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start)};
+}
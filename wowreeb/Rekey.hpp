@@ -0,0 +1,51 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+struct RekeyResult
+{
+    // credentials which were encrypted again, including the key check and
+    // those in the vault
+    std::size_t Credentials;
+
+    // time taken to derive both keys and encrypt every credential
+    std::chrono::milliseconds Elapsed;
+};
+
+// decrypt every credential in a config file and the vault it names with the
+// old key and encrypt it with the new one, spread across the processors, then
+// replace the files.  they are left as they were if any credential is not
+// decrypted by the old key.  comments and the order of the config file are
+// kept, though not its whitespace.
+RekeyResult RekeyConfig(const fs::path& file, const std::string& oldKey,
+                        const std::string& newKey);
@@ -0,0 +1,154 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Scheduler.hpp"
+
+#include "ProcessBackend.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// a launch held for longer than this proceeds anyway, rather than leaving the
+// user wondering why nothing has happened
+static constexpr auto AdmissionTimeout = std::chrono::seconds(30);
+static constexpr auto AdmissionInterval = std::chrono::milliseconds(250);
+
+bool Admissible(ProcessBackend& backend, const GroupPolicy& policy)
+{
+    std::uint64_t available;
+
+    if (policy.MinFreeMemory && backend.GetAvailableMemory(available) &&
+        available / (1024 * 1024) < policy.MinFreeMemory)
+        return false;
+
+    double length;
+
+    if (policy.MaxDiskQueue > 0.f && backend.GetDiskQueueLength(length) &&
+        length > policy.MaxDiskQueue)
+        return false;
+
+    return true;
+}
+
+// wait until the system has the resources for another client.  returns false
+// if it did not have them in time.
+bool Admit(ProcessBackend& backend, const GroupPolicy& policy)
+{
+    if (!policy.MinFreeMemory && policy.MaxDiskQueue <= 0.f)
+        return true;
+
+    auto const deadline = std::chrono::steady_clock::now() + AdmissionTimeout;
+
+    while (!Admissible(backend, policy))
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+
+        std::this_thread::sleep_for(AdmissionInterval);
+    }
+
+    return true;
+}
+} // namespace
+
+GroupReport LaunchGroup(ProcessBackend& backend, const GroupPolicy& policy,
+                        const std::vector<std::string>& names,
+                        const std::function<void(std::size_t)>& launch)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    GroupReport report {};
+
+    // the dispatch lock is held while a launch waits for admission, so that
+    // only one launch at a time claims the resources which are free
+    std::mutex dispatchMutex;
+    std::size_t next = 0;
+    auto nextStart = start;
+
+    std::mutex errorsMutex;
+
+    auto const worker = [&]()
+    {
+        for (;;)
+        {
+            std::size_t index;
+
+            {
+                std::lock_guard<std::mutex> guard(dispatchMutex);
+
+                if (next == names.size())
+                    return;
+
+                index = next++;
+
+                std::this_thread::sleep_until(nextStart);
+
+                if (!Admit(backend, policy))
+                    ++report.AdmissionTimeouts;
+
+                nextStart = std::chrono::steady_clock::now() +
+                            std::chrono::milliseconds(policy.Stagger);
+            }
+
+            try
+            {
+                launch(index);
+            }
+            catch (std::exception const& e)
+            {
+                std::lock_guard<std::mutex> guard(errorsMutex);
+                report.Errors.push_back(names[index] + ": " + e.what());
+            }
+        }
+    };
+
+    auto const threadCount = std::min<std::size_t>(
+        std::max(policy.Parallelism, 1u), names.size());
+
+    std::vector<std::thread> workers;
+
+    for (auto i = 1u; i < threadCount; ++i)
+        workers.emplace_back(worker);
+
+    worker();
+
+    for (auto& thread : workers)
+        thread.join();
+
+    report.Elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    return report;
+}
@@ -0,0 +1,74 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+class ProcessBackend;
+
+// how the clients of a group are launched
+struct GroupPolicy
+{
+    static constexpr unsigned int DefaultParallelism = 2;
+
+    // how many clients may be launched at once
+    unsigned int Parallelism;
+
+    // minimum milliseconds between starting each launch
+    unsigned int Stagger;
+
+    // megabytes of physical memory which must be free before the next client
+    // is launched.  zero to disable.
+    unsigned int MinFreeMemory;
+
+    // disk queue length above which the next client is held.  zero to disable.
+    float MaxDiskQueue;
+};
+
+// the outcome of launching a group
+struct GroupReport
+{
+    std::chrono::milliseconds Elapsed;
+
+    // launches which were held for as long as is allowed and then went ahead
+    // without the resources they were waiting for
+    std::size_t AdmissionTimeouts;
+
+    // the name of each client which failed to launch, and why
+    std::vector<std::string> Errors;
+};
+
+// launch each of the named clients, at most policy.Parallelism at a time.  each
+// launch is held until the stagger has elapsed and the backend reports enough
+// free memory and disk bandwidth.  failures do not stop the remaining launches.
+// the launch function is given the position of the client within the group.
+GroupReport LaunchGroup(ProcessBackend& backend, const GroupPolicy& policy,
+                        const std::vector<std::string>& names,
+                        const std::function<void(std::size_t)>& launch);
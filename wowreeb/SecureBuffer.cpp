@@ -0,0 +1,90 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "SecureBuffer.hpp"
+
+#include "Log.hpp"
+
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+SecureBuffer::SecureBuffer(std::size_t size) : _data(nullptr), _size(size)
+{
+    if (!_size)
+        return;
+
+    _data = static_cast<std::uint8_t*>(::VirtualAlloc(
+        nullptr, _size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+
+    if (!_data)
+        throw std::runtime_error("VirtualAlloc failed");
+
+    // the working set may be too small to lock more, in which case the secret
+    // is still wiped on release
+    if (!::VirtualLock(_data, _size))
+        DebugLog("VirtualLock failed");
+}
+
+SecureBuffer::~SecureBuffer()
+{
+    Release();
+}
+
+SecureBuffer::SecureBuffer(SecureBuffer&& other) noexcept
+    : _data(other._data), _size(other._size)
+{
+    other._data = nullptr;
+    other._size = 0;
+}
+
+SecureBuffer& SecureBuffer::operator=(SecureBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+
+        _data = other._data;
+        _size = other._size;
+        other._data = nullptr;
+        other._size = 0;
+    }
+
+    return *this;
+}
+
+void SecureBuffer::Release()
+{
+    if (!_data)
+        return;
+
+    ::SecureZeroMemory(_data, _size);
+    ::VirtualUnlock(_data, _size);
+    ::VirtualFree(_data, 0, MEM_RELEASE);
+
+    _data = nullptr;
+    _size = 0;
+}
@@ -0,0 +1,258 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "SettingsChannel.hpp"
+
+#include "Config.hpp"
+#include "GameSettings.hpp"
+#include "HashCache.hpp"
+#include "SecureBuffer.hpp"
+#include "UserSecurity.hpp"
+
+#include <Windows.h>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+extern std::wstring make_wstring(const std::string& in);
+
+namespace
+{
+// accumulates the variable length data which follows the settings header
+class SettingsBuilder
+{
+private:
+    std::vector<std::uint8_t> _data;
+
+    SettingsString Append(const void* data, size_t length, size_t charSize)
+    {
+        auto const offset = sizeof(GameSettings) + _data.size();
+        auto const size = (length + 1) * charSize;
+
+        if (offset + size > (std::numeric_limits<std::uint32_t>::max)())
+            throw std::runtime_error("Game settings too large");
+
+        _data.resize(_data.size() + size, 0);
+
+        if (length > 0)
+            ::memcpy(&_data[offset - sizeof(GameSettings)], data,
+                     length * charSize);
+
+        return {static_cast<std::uint32_t>(offset),
+                static_cast<std::uint32_t>(length)};
+    }
+
+public:
+    SettingsString Add(const std::string& str)
+    {
+        return Append(str.c_str(), str.length(), sizeof(char));
+    }
+
+    SettingsString Add(const std::wstring& str)
+    {
+        return Append(str.c_str(), str.length(), sizeof(wchar_t));
+    }
+
+    SettingsString Add(const SecureBuffer& secret)
+    {
+        return Append(secret.Data(), secret.Size(), sizeof(char));
+    }
+
+    template <typename T> std::uint32_t Add(const std::vector<T>& items)
+    {
+        // keep the array aligned for the benefit of the reader
+        _data.resize((_data.size() + 3) & ~3, 0);
+
+        auto const offset =
+            static_cast<std::uint32_t>(sizeof(GameSettings) + _data.size());
+
+        if (!items.empty())
+        {
+            auto const size = items.size() * sizeof(T);
+            _data.resize(_data.size() + size);
+            ::memcpy(&_data[offset - sizeof(GameSettings)], &items[0], size);
+        }
+
+        return offset;
+    }
+
+    const std::vector<std::uint8_t>& Data() const { return _data; }
+
+    // the data holds the credentials, so must not be left on the heap
+    ~SettingsBuilder()
+    {
+        if (!_data.empty())
+            ::SecureZeroMemory(&_data[0], _data.size());
+    }
+};
+} // namespace
+
+SettingsChannel::SettingsChannel(unsigned int processId, const ConfigEntry& entry,
+                                 const SecureBuffer& password)
+    : _mapping(nullptr), _view(nullptr)
+{
+    GameSettings header;
+    SettingsBuilder builder;
+
+    ::memset(&header, 0, sizeof(header));
+
+    header.Magic = GAME_SETTINGS_MAGIC;
+    header.Version = GAME_SETTINGS_VERSION;
+
+    header.AuthServer = builder.Add(entry.AuthServer);
+
+    if (entry.Fov > 0.1f)
+    {
+        header.FoVSet = true;
+        header.FoV = entry.Fov;
+    }
+
+    header.CredentialsSet = !entry.Username.empty() && !!password.Size();
+    header.Username = builder.Add(header.CredentialsSet ? entry.Username : "");
+    header.Password = header.CredentialsSet ? builder.Add(password) :
+                                              builder.Add(std::string());
+
+    if (!entry.CLRDll.empty())
+    {
+        fs::path domainDllPath(entry.CLRDll);
+
+        // if the path is relative, make it relative to the wow executable
+        if (domainDllPath.is_relative())
+            domainDllPath = entry.Path.parent_path() / domainDllPath;
+
+        header.CLRPath = builder.Add(domainDllPath.wstring());
+        header.CLRTypeName = builder.Add(make_wstring(entry.CLRTypeName));
+        header.CLRMethodName = builder.Add(make_wstring(entry.CLRMethodName));
+    }
+    else
+    {
+        header.CLRPath = builder.Add(std::wstring());
+        header.CLRTypeName = builder.Add(std::wstring());
+        header.CLRMethodName = builder.Add(std::wstring());
+    }
+
+    std::vector<SettingsNativeDll> dlls;
+
+    for (auto const& dll : entry.NativeDlls)
+    {
+        SettingsNativeDll ins {};
+        ins.Path = builder.Add(dll.Path.wstring());
+        ins.Method = builder.Add(dll.Method);
+        dlls.push_back(ins);
+    }
+
+    header.NativeDllCount = static_cast<std::uint32_t>(dlls.size());
+    header.NativeDlls = builder.Add(dlls);
+
+    // the dll remembers where each signature matched under the hash of the
+    // executable, so that it need only search a given build once
+    if (!entry.Signatures.empty())
+    {
+        auto const hash = HashFile(entry.Path);
+
+        header.ExeHashSet = true;
+        ::memcpy(header.ExeHash, &hash[0], sizeof(header.ExeHash));
+    }
+
+    std::vector<SettingsSignature> signatures;
+
+    for (auto const& signature : entry.Signatures)
+    {
+        SettingsSignature ins {};
+        ins.Target = signature.Target;
+        ins.Kind = signature.Kind;
+        ins.Displacement = signature.Displacement;
+        ins.Section = builder.Add(signature.Section);
+        ins.Pattern = builder.Add(signature.Pattern);
+        signatures.push_back(ins);
+    }
+
+    header.SignatureCount = static_cast<std::uint32_t>(signatures.size());
+    header.Signatures = builder.Add(signatures);
+
+    auto const& data = builder.Data();
+    header.Size = static_cast<std::uint32_t>(sizeof(header) + data.size());
+
+    auto const name = GameSettingsSectionName(processId);
+
+    // the section holds the password and its name is predictable, so only this
+    // user, whom the client runs as, may open it
+    std::wstring sid;
+
+    if (!ProcessSid(::GetCurrentProcess(), sid))
+        throw std::runtime_error("Failed to read the user's SID");
+
+    UserOnlySecurity security(sid);
+
+    if (!security.Get())
+        throw std::runtime_error("Failed to build the settings security");
+
+    _mapping = ::CreateFileMappingW(INVALID_HANDLE_VALUE, security.Get(),
+                                    PAGE_READWRITE, 0, header.Size,
+                                    name.c_str());
+
+    if (!_mapping)
+        throw std::runtime_error("CreateFileMapping failed");
+
+    // a section by this name should never exist before we create it
+    if (::GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        ::CloseHandle(_mapping);
+        throw std::runtime_error("Game settings section already exists");
+    }
+
+    _view = static_cast<GameSettings*>(
+        ::MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, header.Size));
+
+    if (!_view)
+    {
+        ::CloseHandle(_mapping);
+        throw std::runtime_error("MapViewOfFile failed");
+    }
+
+    ::memcpy(_view, &header, sizeof(header));
+
+    if (!data.empty())
+        ::memcpy(_view + 1, &data[0], data.size());
+}
+
+SettingsChannel::~SettingsChannel()
+{
+    ClearCredentials();
+
+    ::UnmapViewOfFile(_view);
+    ::CloseHandle(_mapping);
+}
+
+void SettingsChannel::ClearCredentials()
+{
+    ::SecureZeroMemory(GetSettingsString(_view, _view->Username),
+                       _view->Username.Length);
+    ::SecureZeroMemory(GetSettingsString(_view, _view->Password),
+                       _view->Password.Length);
+}
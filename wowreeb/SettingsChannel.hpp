@@ -0,0 +1,61 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "GameSettings.hpp"
+
+#include <Windows.h>
+
+class SecureBuffer;
+struct ConfigEntry;
+
+// owns the named shared memory section through which the launcher passes its
+// settings to a particular game process
+class SettingsChannel
+{
+private:
+    HANDLE _mapping;
+    GameSettings* _view;
+
+public:
+    // the password is the entry's, already decrypted
+    SettingsChannel(unsigned int processId, const ConfigEntry& entry,
+                    const SecureBuffer& password);
+    ~SettingsChannel();
+
+    SettingsChannel(const SettingsChannel&) = delete;
+    SettingsChannel& operator=(const SettingsChannel&) = delete;
+
+    const GameSettings* Get() const { return _view; }
+
+    bool HasMilestone(Milestone milestone) const
+    {
+        return (_view->Milestones & milestone) == milestone;
+    }
+
+    // scrub the credentials from the section once the game no longer needs them
+    void ClearCredentials();
+};
@@ -0,0 +1,126 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "StatCache.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+namespace
+{
+// long enough to cover every check made by one launch, short enough that a
+// file which is replaced is noticed on the next
+static constexpr auto StatLifetime = std::chrono::seconds(5);
+
+struct StatRecord
+{
+    bool Exists;
+    std::chrono::steady_clock::time_point Checked;
+};
+
+std::mutex statMutex;
+std::map<fs::path, StatRecord> stats;
+std::map<fs::path, std::shared_future<bool>> inFlight;
+
+// must be called with statMutex held
+std::shared_future<bool> Probe(const fs::path& file)
+{
+    auto const now = std::chrono::steady_clock::now();
+
+    auto const cached = stats.find(file);
+
+    if (cached != stats.end() && now - cached->second.Checked < StatLifetime)
+    {
+        std::promise<bool> known;
+        known.set_value(cached->second.Exists);
+        return known.get_future().share();
+    }
+
+    auto const pending = inFlight.find(file);
+
+    if (pending != inFlight.end())
+        return pending->second;
+
+    std::promise<bool> promise;
+    auto future = promise.get_future().share();
+
+    inFlight[file] = future;
+
+    // the check runs on a thread of its own, as a stalled network share must
+    // not hold up anyone waiting on it.  std::async would block as its future
+    // is destroyed.
+    std::thread(
+        [file, promise = std::move(promise)]() mutable
+        {
+            // a path which cannot be reached is treated as missing
+            std::error_code ec;
+            auto const exists = fs::exists(file, ec);
+
+            {
+                std::lock_guard<std::mutex> guard(statMutex);
+                stats[file] = {exists, std::chrono::steady_clock::now()};
+                inFlight.erase(file);
+            }
+
+            promise.set_value(exists);
+        })
+        .detach();
+
+    return future;
+}
+} // namespace
+
+void ProbeFile(const fs::path& file)
+{
+    std::lock_guard<std::mutex> guard(statMutex);
+    Probe(file);
+}
+
+bool FileExists(const fs::path& file, std::chrono::milliseconds timeout)
+{
+    std::shared_future<bool> future;
+
+    {
+        std::lock_guard<std::mutex> guard(statMutex);
+        future = Probe(file);
+    }
+
+    if (future.wait_for(timeout) == std::future_status::timeout)
+    {
+        std::stringstream str;
+        str << "Timed out checking " << file;
+        throw std::runtime_error(str.str());
+    }
+
+    return future.get();
+}
@@ -0,0 +1,242 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Supervisor.hpp"
+
+#include "Log.hpp"
+#include "ProcessBackend.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// sampling a client costs a handful of system calls.  even at this interval,
+// sampling_benchmark puts the supervisor's own share for 64 clients at a few
+// hundredths of a percent of one processor.
+static constexpr auto MinInterval = std::chrono::milliseconds(250);
+
+struct SupervisedClient
+{
+    std::string Realm;
+    std::unique_ptr<RunningProcess> Process;
+    RestartPolicy Policy;
+    std::function<void()> Restart;
+
+    std::chrono::steady_clock::time_point Launched;
+    bool Started;
+
+    std::chrono::steady_clock::time_point SampleTime;
+    ProcessSample Sample;
+    bool Sampled;
+
+    ClientStats Stats;
+};
+
+std::mutex clientsMutex;
+std::vector<SupervisedClient> clients;
+bool sampling = false;
+
+auto interval = std::chrono::milliseconds(2000);
+
+// consecutive startup crashes of each realm
+std::map<std::string, unsigned int> crashes;
+
+void Update(SupervisedClient& client, std::chrono::steady_clock::time_point now)
+{
+    ProcessSample sample;
+
+    if (!client.Process->Sample(sample))
+        return;
+
+    client.Stats.Uptime = std::chrono::duration_cast<std::chrono::seconds>(
+        now - client.Launched);
+    client.Stats.WorkingSet = sample.WorkingSet;
+    client.Stats.PrivateBytes = sample.PrivateBytes;
+    client.Stats.Handles = sample.Handles;
+
+    if (client.Sampled)
+    {
+        auto const elapsed =
+            std::chrono::duration<double>(now - client.SampleTime).count();
+
+        if (elapsed > 0.0)
+        {
+            auto const cpu = std::chrono::duration<double>(
+                                 sample.CpuTime - client.Sample.CpuTime)
+                                 .count();
+
+            client.Stats.Cpu = 100.0 * cpu / elapsed;
+            client.Stats.ReadRate =
+                (sample.ReadBytes - client.Sample.ReadBytes) / elapsed;
+            client.Stats.WriteRate =
+                (sample.WriteBytes - client.Sample.WriteBytes) / elapsed;
+        }
+    }
+
+    client.Sample = sample;
+    client.SampleTime = now;
+    client.Sampled = true;
+}
+
+// decide whether a client which has exited should be restarted
+bool ShouldRestart(const SupervisedClient& client,
+                   std::chrono::steady_clock::time_point now)
+{
+    if (!client.Policy.Enabled || !client.Restart ||
+        now - client.Launched >= std::chrono::seconds(client.Policy.Window))
+        return false;
+
+    auto const exitCode = client.Process->GetExitCode();
+
+    if (!exitCode)
+        return false;
+
+    auto const count = ++crashes[client.Realm];
+
+    std::stringstream str;
+    str << "client " << client.Stats.Id << " for \"" << client.Realm
+        << "\" exited with code 0x" << std::hex << exitCode << std::dec
+        << " during startup (" << count << " in a row)";
+    DebugLog(str.str());
+
+    return count <= client.Policy.Limit;
+}
+
+// a single thread samples every client, and exits once none remain
+void Sample()
+{
+    for (;;)
+    {
+        std::chrono::milliseconds wait;
+
+        {
+            std::lock_guard<std::mutex> guard(clientsMutex);
+            wait = (std::max)(interval, MinInterval);
+        }
+
+        std::this_thread::sleep_for(wait);
+
+        std::vector<std::function<void()>> restarts;
+
+        {
+            std::lock_guard<std::mutex> guard(clientsMutex);
+
+            auto const now = std::chrono::steady_clock::now();
+
+            for (auto i = clients.begin(); i != clients.end();)
+            {
+                if (i->Process->HasExited())
+                {
+                    if (ShouldRestart(*i, now))
+                        restarts.push_back(std::move(i->Restart));
+
+                    i = clients.erase(i);
+                    continue;
+                }
+
+                // a client which survives its startup ends any run of crashes
+                if (!i->Started &&
+                    now - i->Launched >= std::chrono::seconds(i->Policy.Window))
+                {
+                    i->Started = true;
+                    crashes.erase(i->Realm);
+                }
+
+                Update(*i, now);
+                ++i;
+            }
+        }
+
+        // restarting launches a client, which must not happen with the lock
+        // held.  each restart supervises the new client in turn.
+        for (auto& restart : restarts)
+            std::thread(std::move(restart)).detach();
+
+        std::lock_guard<std::mutex> guard(clientsMutex);
+
+        // restarted clients start a new thread when they are supervised
+        if (clients.empty())
+        {
+            sampling = false;
+            return;
+        }
+    }
+}
+} // namespace
+
+void ConfigureSupervisor(std::chrono::milliseconds sampleInterval)
+{
+    std::lock_guard<std::mutex> guard(clientsMutex);
+    interval = sampleInterval;
+}
+
+void Supervise(const std::string& realm, unsigned int pid,
+               const RestartPolicy& policy, std::function<void()> restart)
+{
+    SupervisedClient client;
+
+    client.Realm = realm;
+    client.Process = GetProcessBackend().Open(pid);
+    client.Policy = policy;
+    client.Restart = std::move(restart);
+    client.Launched = std::chrono::steady_clock::now();
+    client.Started = false;
+    client.Sampled = false;
+    client.Stats = {};
+    client.Stats.Id = pid;
+
+    std::lock_guard<std::mutex> guard(clientsMutex);
+
+    clients.push_back(std::move(client));
+
+    if (!sampling)
+    {
+        sampling = true;
+        std::thread(Sample).detach();
+    }
+}
+
+std::vector<ClientStats> GetClientStats(const std::string& realm)
+{
+    std::lock_guard<std::mutex> guard(clientsMutex);
+
+    std::vector<ClientStats> result;
+
+    for (auto const& client : clients)
+        if (client.Realm == realm)
+            result.push_back(client.Stats);
+
+    return result;
+}
@@ -0,0 +1,74 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// restart a client which exits abnormally soon after it was launched
+struct RestartPolicy
+{
+    bool Enabled;
+
+    // seconds after launch within which an abnormal exit counts as a crash
+    // during startup
+    unsigned int Window;
+
+    // consecutive startup crashes after which the realm is not restarted again
+    unsigned int Limit;
+};
+
+struct ClientStats
+{
+    unsigned int Id;
+
+    std::chrono::seconds Uptime;
+
+    // percentage of one processor used since the previous sample
+    double Cpu;
+
+    std::uint64_t WorkingSet;
+    std::uint64_t PrivateBytes;
+    unsigned int Handles;
+
+    // bytes per second since the previous sample
+    double ReadRate;
+    double WriteRate;
+};
+
+// sample every supervised client this often
+void ConfigureSupervisor(std::chrono::milliseconds interval);
+
+// watch a client launched for the realm until it exits.  if it crashes during
+// startup and the policy allows, restart is called from the background.
+void Supervise(const std::string& realm, unsigned int pid,
+               const RestartPolicy& policy, std::function<void()> restart);
+
+// the running clients of the realm, as of the latest sample
+std::vector<ClientStats> GetClientStats(const std::string& realm);
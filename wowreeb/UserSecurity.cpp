@@ -0,0 +1,87 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "UserSecurity.hpp"
+
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// this depends on the types declared by windows.h
+#include <sddl.h>
+
+#pragma comment(lib, "advapi32.lib")
+
+bool ProcessSid(HANDLE process, std::wstring& sid)
+{
+    HANDLE token;
+
+    if (!::OpenProcessToken(process, TOKEN_QUERY, &token))
+        return false;
+
+    DWORD size = 0;
+    ::GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+
+    std::vector<std::uint8_t> buffer(size ? size : 1);
+    auto result =
+        !!::GetTokenInformation(token, TokenUser, &buffer[0], size, &size);
+
+    ::CloseHandle(token);
+
+    LPWSTR str = nullptr;
+
+    result = result &&
+             !!::ConvertSidToStringSidW(
+                 reinterpret_cast<TOKEN_USER*>(&buffer[0])->User.Sid, &str);
+
+    if (result)
+    {
+        sid = str;
+        ::LocalFree(str);
+    }
+
+    return result;
+}
+
+UserOnlySecurity::UserOnlySecurity(const std::wstring& sid)
+    : _descriptor(nullptr)
+{
+    auto const sddl = L"D:P(A;;GA;;;" + sid + L")";
+
+    if (!::ConvertStringSecurityDescriptorToSecurityDescriptorW(
+            sddl.c_str(), SDDL_REVISION_1, &_descriptor, nullptr))
+        _descriptor = nullptr;
+
+    _attributes.nLength = sizeof(_attributes);
+    _attributes.lpSecurityDescriptor = _descriptor;
+    _attributes.bInheritHandle = FALSE;
+}
+
+UserOnlySecurity::~UserOnlySecurity()
+{
+    if (_descriptor)
+        ::LocalFree(_descriptor);
+}
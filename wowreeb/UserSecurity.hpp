@@ -0,0 +1,51 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <Windows.h>
+#include <string>
+
+// the sid of the user running a process, as a string
+bool ProcessSid(HANDLE process, std::wstring& sid);
+
+// security attributes which grant the given user, and no one else, access to
+// the object they are used to create.  the rules are not inherited.  Get()
+// returns nullptr if the descriptor could not be built.
+class UserOnlySecurity
+{
+private:
+    PSECURITY_DESCRIPTOR _descriptor;
+    SECURITY_ATTRIBUTES _attributes;
+
+public:
+    explicit UserOnlySecurity(const std::wstring& sid);
+    ~UserOnlySecurity();
+
+    UserOnlySecurity(const UserOnlySecurity&) = delete;
+    UserOnlySecurity& operator=(const UserOnlySecurity&) = delete;
+
+    SECURITY_ATTRIBUTES* Get() { return _descriptor ? &_attributes : nullptr; }
+};
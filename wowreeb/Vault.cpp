@@ -0,0 +1,281 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "Vault.hpp"
+
+#include <Windows.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+std::string MakeKey(const std::string& realm, const std::string& username)
+{
+    std::string key(realm);
+    key += '\0';
+    key += username;
+    return key;
+}
+
+std::string_view Slice(const std::uint8_t* view, std::size_t size,
+                       std::uint32_t offset, std::uint32_t length)
+{
+    if (static_cast<std::uint64_t>(offset) + length > size)
+        throw std::runtime_error("Vault is corrupt");
+
+    return {reinterpret_cast<const char*>(view + offset), length};
+}
+} // namespace
+
+Vault::Vault(const fs::path& file)
+    : _file(INVALID_HANDLE_VALUE), _mapping(nullptr), _view(nullptr), _size(0)
+{
+    _file = ::CreateFileW(file.c_str(), GENERIC_READ,
+                          FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                          OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+    if (_file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to open vault");
+
+    LARGE_INTEGER size;
+
+    if (!::GetFileSizeEx(_file, &size) ||
+        size.QuadPart < static_cast<LONGLONG>(sizeof(VaultHeader)) ||
+        size.QuadPart > (std::numeric_limits<std::uint32_t>::max)())
+    {
+        Release();
+        throw std::runtime_error("Vault is corrupt");
+    }
+
+    _size = static_cast<std::size_t>(size.QuadPart);
+    _mapping =
+        ::CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (_mapping)
+        _view = static_cast<const std::uint8_t*>(
+            ::MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+
+    if (!_view)
+    {
+        Release();
+        throw std::runtime_error("Failed to map vault");
+    }
+
+    auto const header = reinterpret_cast<const VaultHeader*>(_view);
+
+    if (::memcmp(header->Magic, VaultMagic, sizeof(VaultMagic)) ||
+        header->Version != VaultVersion ||
+        sizeof(VaultHeader) +
+                static_cast<std::uint64_t>(header->Count) * sizeof(VaultIndex) >
+            _size)
+    {
+        Release();
+        throw std::runtime_error("Vault is corrupt");
+    }
+}
+
+Vault::~Vault()
+{
+    Release();
+}
+
+void Vault::Release()
+{
+    if (_view)
+        ::UnmapViewOfFile(_view);
+
+    if (_mapping)
+        ::CloseHandle(_mapping);
+
+    if (_file != INVALID_HANDLE_VALUE)
+        ::CloseHandle(_file);
+
+    _view = nullptr;
+    _mapping = nullptr;
+    _file = INVALID_HANDLE_VALUE;
+}
+
+std::string_view Vault::Key(std::size_t index) const
+{
+    auto const& entry =
+        reinterpret_cast<const VaultIndex*>(_view + sizeof(VaultHeader))[index];
+
+    return Slice(_view, _size, entry.KeyOffset, entry.KeyLength);
+}
+
+std::string_view Vault::Record(std::size_t index) const
+{
+    auto const& entry =
+        reinterpret_cast<const VaultIndex*>(_view + sizeof(VaultHeader))[index];
+
+    return Slice(_view, _size, entry.RecordOffset, entry.RecordLength);
+}
+
+std::size_t Vault::Count() const
+{
+    return reinterpret_cast<const VaultHeader*>(_view)->Count;
+}
+
+bool Vault::Find(const std::string& realm, const std::string& username,
+                 std::string& credential) const
+{
+    auto const key = MakeKey(realm, username);
+
+    // only the index entries visited by the search are read from the file
+    std::size_t low = 0, high = Count();
+
+    while (low < high)
+    {
+        auto const mid = low + (high - low) / 2;
+        auto const order = Key(mid).compare(key);
+
+        if (!order)
+        {
+            credential = std::string(Record(mid));
+            return true;
+        }
+
+        if (order < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return false;
+}
+
+std::vector<VaultRecord> Vault::Records() const
+{
+    std::vector<VaultRecord> result;
+    result.reserve(Count());
+
+    for (auto i = 0u; i < Count(); ++i)
+    {
+        auto const key = Key(i);
+        auto const split = key.find('\0');
+
+        if (split == std::string_view::npos)
+            throw std::runtime_error("Vault is corrupt");
+
+        result.push_back({std::string(key.substr(0, split)),
+                          std::string(key.substr(split + 1)),
+                          std::string(Record(i))});
+    }
+
+    return result;
+}
+
+void Vault::Write(const fs::path& file, std::vector<VaultRecord> records)
+{
+    auto const less = [](const VaultRecord& a, const VaultRecord& b)
+    {
+        return a.Realm < b.Realm ||
+               (a.Realm == b.Realm && a.Username < b.Username);
+    };
+
+    std::stable_sort(records.begin(), records.end(), less);
+
+    std::vector<VaultRecord> unique;
+    unique.reserve(records.size());
+
+    for (auto& record : records)
+    {
+        if (record.Realm.find('\0') != std::string::npos ||
+            record.Username.find('\0') != std::string::npos)
+            throw std::runtime_error("Vault names may not contain a nul");
+
+        if (!unique.empty() && !less(unique.back(), record))
+            unique.back() = std::move(record);
+        else
+            unique.push_back(std::move(record));
+    }
+
+    VaultHeader header;
+    ::memcpy(header.Magic, VaultMagic, sizeof(VaultMagic));
+    header.Version = VaultVersion;
+    header.Count = static_cast<std::uint32_t>(unique.size());
+
+    std::vector<VaultIndex> index(unique.size());
+    std::string data;
+
+    auto offset = sizeof(VaultHeader) + index.size() * sizeof(VaultIndex);
+
+    for (auto i = 0u; i < unique.size(); ++i)
+    {
+        auto const key = MakeKey(unique[i].Realm, unique[i].Username);
+        auto const& record = unique[i].Credential;
+
+        if (offset + data.size() + key.length() + record.length() >
+            (std::numeric_limits<std::uint32_t>::max)())
+            throw std::runtime_error("Vault too large");
+
+        index[i].KeyOffset = static_cast<std::uint32_t>(offset + data.size());
+        index[i].KeyLength = static_cast<std::uint32_t>(key.length());
+        data += key;
+
+        index[i].RecordOffset = static_cast<std::uint32_t>(offset + data.size());
+        index[i].RecordLength = static_cast<std::uint32_t>(record.length());
+        data += record;
+    }
+
+    auto temp = file;
+    temp += "." + std::to_string(::GetCurrentProcessId());
+
+    {
+        std::ofstream fd(temp, std::ios::binary | std::ios::trunc);
+
+        fd.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        if (!index.empty())
+            fd.write(reinterpret_cast<const char*>(&index[0]),
+                     index.size() * sizeof(VaultIndex));
+
+        fd.write(data.data(), data.size());
+
+        if (!fd)
+        {
+            fd.close();
+            ::DeleteFileW(temp.c_str());
+            throw std::runtime_error("Failed to write vault");
+        }
+    }
+
+    // replace the vault atomically so that a launcher never maps it half written
+    if (!::MoveFileExW(temp.c_str(), file.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        ::DeleteFileW(temp.c_str());
+        throw std::runtime_error("Failed to replace vault");
+    }
+}
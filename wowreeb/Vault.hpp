@@ -0,0 +1,109 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// a vault keeps credentials out of the config file, so that it stays small
+// however many accounts there are.  the file begins with a header, followed by
+// an index sorted by realm and username and then the strings it refers to.
+// each record is a credential as encrypted by EncryptCredential, so only the
+// one being launched is ever decrypted.
+
+static constexpr char VaultMagic[8] = {'W', 'R', 'B', 'V', 'A', 'U', 'L', 'T'};
+static constexpr std::uint32_t VaultVersion = 1;
+
+struct VaultHeader
+{
+    char Magic[sizeof(VaultMagic)];
+    std::uint32_t Version;
+    std::uint32_t Count;
+};
+
+// the key is the realm and username separated by a nul, so that comparing
+// keys orders them by realm and then username
+struct VaultIndex
+{
+    std::uint32_t KeyOffset;
+    std::uint32_t KeyLength;
+    std::uint32_t RecordOffset;
+    std::uint32_t RecordLength;
+};
+
+struct VaultRecord
+{
+    std::string Realm;
+    std::string Username;
+    std::string Credential;
+};
+
+// a read only view of a vault file, which is mapped rather than read so that
+// opening it costs the same however large it is
+class Vault
+{
+private:
+    HANDLE _file;
+    HANDLE _mapping;
+    const std::uint8_t* _view;
+    std::size_t _size;
+
+    void Release();
+
+    // the key of an index entry, after checking it lies in the file
+    std::string_view Key(std::size_t index) const;
+
+public:
+    explicit Vault(const fs::path& file);
+    ~Vault();
+
+    Vault(const Vault&) = delete;
+    Vault& operator=(const Vault&) = delete;
+
+    std::size_t Count() const;
+
+    // the encrypted credential of an index entry, which is valid for as long as
+    // the vault is open
+    std::string_view Record(std::size_t index) const;
+
+    // find the encrypted credential of an account, returning false if there is
+    // none
+    bool Find(const std::string& realm, const std::string& username,
+              std::string& credential) const;
+
+    std::vector<VaultRecord> Records() const;
+
+    // replace the file with one holding the records.  where several share a
+    // realm and username, the last is kept.
+    static void Write(const fs::path& file, std::vector<VaultRecord> records);
+};
@@ -0,0 +1,313 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "WDBCache.hpp"
+
+#include "Platform.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+static constexpr char TrashPrefix[] = "WDB.wowreeb-trash-";
+static constexpr char SnapshotFolder[] = "WDB.wowreeb";
+static constexpr char OwnerFile[] = "current";
+
+// relative to the client folder
+std::vector<fs::path> CacheFolders()
+{
+    return {"WDB", fs::path("Cache") / "WDB"};
+}
+
+std::vector<fs::path> CacheFolders(const fs::path& clientDir)
+{
+    std::vector<fs::path> result;
+
+    for (auto const& folder : CacheFolders())
+        result.push_back(clientDir / folder);
+
+    return result;
+}
+
+fs::path TrashName(const fs::path& folder)
+{
+    static std::atomic<unsigned int> sequence {0};
+
+    auto const now = std::chrono::system_clock::now().time_since_epoch();
+    auto const name = std::string(TrashPrefix) +
+                      std::to_string(CurrentProcessId()) + "-" +
+                      std::to_string(now.count()) + "-" +
+                      std::to_string(sequence++);
+
+    // renaming within the same parent keeps the trash on the same volume, which
+    // is what makes this atomic and immediate
+    return folder.parent_path() / name;
+}
+
+void DeleteTrash(std::vector<fs::path> trash)
+{
+    BeginBackgroundWork();
+
+    // spread the top level of each folder over a few threads.  the cache holds
+    // one folder per locale, each of which can hold many files.
+    std::vector<fs::path> work;
+    std::error_code ec;
+
+    for (auto const& folder : trash)
+        for (auto const& entry : fs::directory_iterator(folder, ec))
+            work.push_back(entry.path());
+
+    std::atomic<size_t> next {0};
+    auto const worker = [&work, &next]()
+    {
+        BeginBackgroundWork();
+
+        for (auto i = next++; i < work.size(); i = next++)
+        {
+            std::error_code ec;
+            fs::remove_all(work[i], ec);
+        }
+    };
+
+    auto const cores = (std::max)(1u, std::thread::hardware_concurrency() / 2);
+    auto const threadCount = (std::min)(work.size(), static_cast<size_t>(cores));
+
+    std::vector<std::thread> threads;
+
+    for (auto i = 1u; i < threadCount; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for (auto& thread : threads)
+        thread.join();
+
+    // failures are ignored.  whatever remains will be swept on the next run.
+    for (auto const& folder : trash)
+        fs::remove_all(folder, ec);
+}
+
+void DeleteInBackground(std::vector<fs::path> trash)
+{
+    if (trash.empty())
+        return;
+
+    std::thread cleaner(DeleteTrash, std::move(trash));
+    cleaner.detach();
+}
+
+// snapshots are stored in a folder per realm.  the realm name is reduced to
+// characters which are safe in a file name, and suffixed with a hash of the full
+// name to keep distinct realms apart.
+std::string RealmKey(const std::string& realm)
+{
+    std::string result;
+
+    for (auto const c : realm)
+        result += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+
+    std::uint32_t hash = 2166136261u;
+
+    for (auto const c : realm)
+        hash = (hash ^ static_cast<std::uint8_t>(c)) * 16777619u;
+
+    char suffix[10];
+    ::snprintf(suffix, sizeof(suffix), "-%08x", hash);
+
+    return result + suffix;
+}
+
+std::string ReadOwner(const fs::path& snapshots)
+{
+    std::ifstream fd(snapshots / OwnerFile);
+    std::string result;
+
+    std::getline(fd, result);
+
+    return result;
+}
+
+void WriteOwner(const fs::path& snapshots, const std::string& owner)
+{
+    std::ofstream fd(snapshots / OwnerFile, std::ios::trunc);
+    fd << owner;
+
+    if (!fd)
+        throw std::runtime_error("Failed to record cache owner");
+}
+
+} // namespace
+
+void ClearWDB(const fs::path& clientDir)
+{
+    std::vector<fs::path> trash;
+
+    for (auto const& folder : CacheFolders(clientDir))
+    {
+        if (!fs::exists(folder))
+            continue;
+
+        auto const destination = TrashName(folder);
+
+        std::error_code ec;
+        fs::rename(folder, destination, ec);
+
+        // the folder may be in use by a running client
+        if (ec)
+        {
+            DeleteInBackground(std::move(trash));
+            throw std::runtime_error("Failed to clear cache folder");
+        }
+
+        trash.push_back(destination);
+    }
+
+    DeleteInBackground(std::move(trash));
+}
+
+void SweepWDBTrash(const fs::path& clientDir)
+{
+    std::vector<fs::path> trash;
+    std::error_code ec;
+
+    // trash is left beside the live cache folders, and beside the snapshots of
+    // each realm
+    std::vector<fs::path> parents;
+
+    for (auto const& folder : CacheFolders(clientDir))
+        parents.push_back(folder.parent_path());
+
+    for (auto const& entry :
+         fs::directory_iterator(clientDir / SnapshotFolder, ec))
+        if (entry.is_directory())
+            for (auto const& folder : CacheFolders(entry.path()))
+                parents.push_back(folder.parent_path());
+
+    for (auto const& parent : parents)
+    {
+        for (auto const& entry : fs::directory_iterator(parent, ec))
+        {
+            auto const name = entry.path().filename().string();
+
+            if (name.compare(0, sizeof(TrashPrefix) - 1, TrashPrefix) == 0)
+                trash.push_back(entry.path());
+        }
+    }
+
+    DeleteInBackground(std::move(trash));
+}
+
+void SwitchWDB(const fs::path& clientDir, const std::string& realm)
+{
+    auto const snapshots = clientDir / SnapshotFolder;
+    auto const key = RealmKey(realm);
+
+    try
+    {
+        fs::create_directories(snapshots);
+
+        auto const owner = ReadOwner(snapshots);
+
+        // step 1: stash the live cache as the snapshot of the realm which last
+        // used it.  a cache with no known owner was made by running the client
+        // some other way, and is adopted by this realm rather than discarded.
+        if (owner != key)
+        {
+            std::vector<fs::path> trash;
+
+            for (auto const& folder : CacheFolders())
+            {
+                auto const live = clientDir / folder;
+
+                if (owner.empty() || !fs::exists(live))
+                    continue;
+
+                auto const stash = snapshots / owner / folder;
+
+                if (fs::exists(stash))
+                {
+                    auto const destination = TrashName(stash);
+                    fs::rename(stash, destination);
+                    trash.push_back(destination);
+                }
+
+                fs::create_directories(stash.parent_path());
+                fs::rename(live, stash);
+            }
+
+            DeleteInBackground(std::move(trash));
+
+            // the owner is recorded before the snapshot is restored, so that
+            // if we are interrupted the cache of one realm is never taken for
+            // that of another
+            WriteOwner(snapshots, key);
+        }
+
+        // step 2: move the snapshot of this realm into place.  the client then
+        // writes to the realm's own files, which are moved back when another
+        // realm is launched.  this also completes a switch which was
+        // interrupted.  a live cache which was adopted supersedes the snapshot.
+        std::vector<fs::path> trash;
+
+        for (auto const& folder : CacheFolders())
+        {
+            auto const live = clientDir / folder;
+            auto const snapshot = snapshots / key / folder;
+
+            if (!fs::exists(snapshot))
+                continue;
+
+            if (fs::exists(live))
+            {
+                auto const destination = TrashName(snapshot);
+                fs::rename(snapshot, destination);
+                trash.push_back(destination);
+                continue;
+            }
+
+            fs::create_directories(live.parent_path());
+            fs::rename(snapshot, live);
+        }
+
+        DeleteInBackground(std::move(trash));
+    }
+    catch (fs::filesystem_error const&)
+    {
+        // the live folders may be in use by a running client
+        throw std::runtime_error("Failed to switch cache folder");
+    }
+}
\ No newline at end of file
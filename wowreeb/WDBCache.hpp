@@ -0,0 +1,46 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// clear the WDB cache folders belonging to the client in the given folder.  the
+// folders are renamed out of the way, which is immediate, and then deleted by a
+// low priority background thread so that the launch does not have to wait.
+void ClearWDB(const fs::path& clientDir);
+
+// delete any renamed cache folders which a previous run did not get to finish
+// deleting.  this also happens in the background.
+void SweepWDBTrash(const fs::path& clientDir);
+
+// make the live WDB cache folders of the client those belonging to the given
+// realm.  the live folders are stashed as a snapshot for the realm which last
+// used them, and the snapshot for the requested realm is moved into their
+// place.  both are renames, so this does not depend on the size of the cache.
+void SwitchWDB(const fs::path& clientDir, const std::string& realm);
@@ -0,0 +1,231 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#include "WarmPool.hpp"
+
+#include "Log.hpp"
+#include "ProcessBackend.hpp"
+
+#include <Windows.h>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace
+{
+static constexpr auto ExpiryInterval = std::chrono::seconds(1);
+
+struct ParkedClient
+{
+    std::shared_ptr<ClientProcess> Client;
+    std::size_t Bytes;
+    std::chrono::steady_clock::time_point Parked;
+};
+
+std::mutex poolMutex;
+std::map<std::string, ParkedClient> parked;
+std::set<std::string> filling;
+std::size_t parkedBytes = 0;
+
+std::size_t memoryCap = 0;
+std::chrono::seconds expiry {0};
+bool expiring = false;
+bool drained = false;
+
+void Log(const std::string& realm, const char* message)
+{
+    DebugLog("warm client for \"" + realm + "\" " + message);
+}
+
+// a single thread terminates clients which have been parked for too long, and
+// exits once none remain.  an expired client is not replaced until the realm
+// is next launched.
+void Expire()
+{
+    for (;;)
+    {
+        std::this_thread::sleep_for(ExpiryInterval);
+
+        std::lock_guard<std::mutex> guard(poolMutex);
+
+        auto const now = std::chrono::steady_clock::now();
+
+        for (auto i = parked.begin(); i != parked.end();)
+        {
+            if (now - i->second.Parked < expiry)
+            {
+                ++i;
+                continue;
+            }
+
+            Log(i->first, "expired");
+
+            i->second.Client->Terminate();
+            parkedBytes -= i->second.Bytes;
+            i = parked.erase(i);
+        }
+
+        if (parked.empty())
+        {
+            expiring = false;
+            return;
+        }
+    }
+}
+
+void Fill(std::string realm, ClientFactory factory)
+{
+    std::shared_ptr<ClientProcess> client;
+    std::size_t bytes = 0;
+
+    try
+    {
+        client = factory();
+
+        // a parked client is of no use to anyone once we are gone, so it must
+        // not be left behind should we exit without draining the pool
+        client->TieToLauncher(true);
+
+        bytes = client->GetPrivateBytes();
+    }
+    catch (std::exception const& e)
+    {
+        if (client)
+            client->Terminate();
+
+        std::stringstream str;
+        str << "could not be created: " << e.what();
+        Log(realm, str.str().c_str());
+
+        std::lock_guard<std::mutex> guard(poolMutex);
+        filling.erase(realm);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(poolMutex);
+
+    filling.erase(realm);
+
+    if (drained)
+    {
+        client->Terminate();
+        return;
+    }
+
+    if (memoryCap && parkedBytes + bytes > memoryCap)
+    {
+        Log(realm, "would exceed the memory cap");
+        client->Terminate();
+        return;
+    }
+
+    parkedBytes += bytes;
+    parked[realm] = {std::move(client), bytes, std::chrono::steady_clock::now()};
+
+    if (expiry.count() && !expiring)
+    {
+        expiring = true;
+        std::thread(Expire).detach();
+    }
+}
+} // namespace
+
+void ConfigureWarmPool(std::size_t cap, std::chrono::seconds idle)
+{
+    std::lock_guard<std::mutex> guard(poolMutex);
+
+    memoryCap = cap;
+    expiry = idle;
+}
+
+void FillWarmPool(const std::string& realm, ClientFactory factory)
+{
+    {
+        std::lock_guard<std::mutex> guard(poolMutex);
+
+        if (drained || parked.find(realm) != parked.end() ||
+            !filling.insert(realm).second)
+            return;
+    }
+
+    std::thread(Fill, realm, std::move(factory)).detach();
+}
+
+std::shared_ptr<ClientProcess> TakeWarmClient(const std::string& realm)
+{
+    std::shared_ptr<ClientProcess> client;
+
+    {
+        std::lock_guard<std::mutex> guard(poolMutex);
+
+        auto const i = parked.find(realm);
+
+        if (i == parked.end())
+            return nullptr;
+
+        client = std::move(i->second.Client);
+        parkedBytes -= i->second.Bytes;
+        parked.erase(i);
+    }
+
+    // the client may have been ended by something other than us while it was
+    // parked
+    if (client->WaitForExit(0))
+        return nullptr;
+
+    // once launched, the client outlives us
+    try
+    {
+        client->TieToLauncher(false);
+    }
+    catch (std::exception const& e)
+    {
+        Log(realm, e.what());
+        client->Terminate();
+        return nullptr;
+    }
+
+    return client;
+}
+
+void DrainWarmPool()
+{
+    std::lock_guard<std::mutex> guard(poolMutex);
+
+    for (auto const& client : parked)
+        client.second.Client->Terminate();
+
+    parked.clear();
+    parkedBytes = 0;
+    drained = true;
+}
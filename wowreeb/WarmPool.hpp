@@ -0,0 +1,53 @@
+/*
+  MIT License
+
+  Copyright (c) 2018-2023 namreeb http://github.com/namreeb legal@namreeb.org
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+class ClientProcess;
+
+using ClientFactory = std::function<std::shared_ptr<ClientProcess>()>;
+
+// limit the memory held by parked clients, and how long they may be held
+// without being used.  zero disables either limit.
+void ConfigureWarmPool(std::size_t cap, std::chrono::seconds idle);
+
+// create a suspended client for the realm in the background, unless one is
+// already parked or being created.  parked clients are tied to the launcher, so
+// that they are ended should it exit without draining the pool.
+void FillWarmPool(const std::string& realm, ClientFactory factory);
+
+// take the client parked for the realm, or nullptr if there is none.  the
+// client is no longer tied to the launcher.
+std::shared_ptr<ClientProcess> TakeWarmClient(const std::string& realm);
+
+// terminate every parked client, including those still being created, and
+// park no more
+void DrainWarmPool();
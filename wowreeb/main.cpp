@@ -24,26 +24,48 @@
 */
 
 #include "Config.hpp"
+#include "Credentials.hpp"
+#include "ExportCache.hpp"
+#include "Governor.hpp"
+#include "HashCache.hpp"
 #include "Injector.hpp"
 #include "InputWindow.hpp"
+#include "KeyAgent.hpp"
+#include "Log.hpp"
 #include "NotifyIcon.hpp"
 #include "NotifyIconMgr.hpp"
-#include "PicoSHA2/picosha2.h"
+#include "Placement.hpp"
+#include "Predictor.hpp"
+#include "Prefetcher.hpp"
+#include "ProcessBackend.hpp"
+#include "Rekey.hpp"
+#include "Scheduler.hpp"
+#include "SecureBuffer.hpp"
+#include "StatCache.hpp"
+#include "Supervisor.hpp"
+#include "Vault.hpp"
+#include "WDBCache.hpp"
+#include "WarmPool.hpp"
 #include "resource.h"
-#include "tiny-AES-c/aes.hpp"
 
 #include <ImageHlp.h>
 #include <Windows.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <cstdlib>
 #include <filesystem>
-#include <fstream>
-#include <iomanip>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
 #include <tchar.h>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #pragma comment(lib, "imagehlp.lib")
@@ -54,93 +76,149 @@ namespace
 {
 static constexpr char EnvEntry[] = "WOWREEB_ENTRY";
 static constexpr char EnvKey[] = "WOWREEB_KEY";
+static constexpr char EnvAffinity[] = "WOWREEB_AFFINITY";
+static constexpr char EnvParent[] = "WOWREEB_PARENT";
+static constexpr char EnvRekey[] = "WOWREEB_REKEY";
+static constexpr char EnvVault[] = "WOWREEB_VAULT";
 
-std::vector<std::uint8_t> ReadFile(const fs::path& file)
-{
-    std::ifstream fd(file, std::ios::binary | std::ios::ate);
-    const size_t size = static_cast<size_t>(fd.tellg());
-    fd.seekg(0, std::ios::beg);
-
-    std::vector<std::uint8_t> result(size);
+// while idle, the realms most likely to be launched next are checked this
+// often, and as many as this are prepared
+static constexpr unsigned int PredictInterval = 60;
+static constexpr std::size_t PredictedRealms = 2;
+static constexpr double IdleThreshold = 0.8;
 
-    if (size > 0)
-        fd.read(reinterpret_cast<char*>(&result[0]), result.size());
+std::atomic<bool> preparing {false};
 
-    return std::move(result);
-}
+// clients of a group may be launched concurrently, and must not prepare the
+// same cache at once
+std::mutex wdbMutex;
 
-void Launch(const ConfigEntry& entry, bool clearWDB, const std::string& key)
+// verify checksum, if present
+void VerifyExe(const ConfigEntry& entry)
 {
-    // step 1: ensure exe exists
-    if (!fs::exists(entry.Path))
-        throw std::runtime_error("Exe file not found");
+    if (!entry.SHA256[0])
+        return;
 
-    // step 2: determine whether the launcher and target binary are running in 32
-    // bit mode
-    DWORD themType;
+    if (!VerifyFile(entry.Path, entry.SHA256))
+        throw std::runtime_error("Checksum failed");
+}
 
-    if (!::GetBinaryTypeA(entry.Path.string().c_str(), &themType))
-        throw std::runtime_error("GetBinaryType failed");
+void CheckModules(const ConfigEntry& entry)
+{
+    // like the client, resolve a relative clr dll against the wow executable
+    fs::path clrDll(entry.CLRDll);
 
-    const bool them32 = themType == SCS_32BIT_BINARY;
-    const bool us32 = sizeof(void*) == 4;
+    if (!clrDll.empty() && clrDll.is_relative())
+        clrDll = entry.Path.parent_path() / clrDll;
 
-    // step 3: verify checksum, if present, only if the platform matches
-    if (them32 == us32 && !!entry.SHA256[0])
-    {
-        auto const data = ReadFile(entry.Path);
-        std::vector<std::uint8_t> hash(picosha2::k_digest_size);
+    // the modules may live on a network share, so check them all at once
+    ProbeFile(entry.OurDll);
 
-        picosha2::hash256(data, hash);
+    for (auto const& dll : entry.NativeDlls)
+        ProbeFile(dll.Path);
 
-        if (!!memcmp(entry.SHA256, &hash[0], hash.size()))
-            throw std::runtime_error("Checksum failed");
-    }
+    if (!clrDll.empty())
+        ProbeFile(clrDll);
 
-    // step 4: ensure our dll exists
-    if (!fs::exists(entry.OurDll))
+    // ensure our dll exists
+    if (!FileExists(entry.OurDll))
         throw std::runtime_error("wowreeb.dll not found");
 
-    // step 5: ensure native dlls exists, if present
+    // ensure native dlls exists, if present, and that they export the methods we
+    // are asked to call
     for (auto const& dll : entry.NativeDlls)
-        if (!fs::exists(dll.first))
+    {
+        if (!FileExists(dll.Path))
             throw std::runtime_error("Native DLL not found");
 
-    // step 6: ensure clr dll exists, if present
-    if (!entry.CLRDll.empty() && !fs::exists(entry.CLRDll))
+        if (!dll.Method.empty() && !FindExportRva(dll.Path, dll.Method))
+            throw std::runtime_error("Native DLL method not found");
+    }
+
+    // ensure clr dll exists, if present
+    if (!clrDll.empty() && !FileExists(clrDll))
         throw std::runtime_error("CLR DLL not found");
 
-    // step 7: reset cache if requested
-    if (clearWDB)
-    {
-        try
-        {
-            auto const wdb1 = entry.Path.parent_path() / "WDB";
-            auto const wdb2 = entry.Path.parent_path() / "Cache" / "WDB";
+    // verify the checksums of those modules which have them, all at once
+    std::vector<std::pair<const char*, std::future<bool>>> checks;
 
-            if (fs::exists(wdb1))
-                fs::remove_all(wdb1);
+    for (auto const& dll : entry.NativeDlls)
+        if (dll.SHA256[0])
+            checks.emplace_back("Native DLL checksum failed",
+                                std::async(std::launch::async, VerifyFile,
+                                           std::cref(dll.Path), dll.SHA256));
+
+    if (!clrDll.empty() && entry.CLRSHA256[0])
+        checks.emplace_back("CLR DLL checksum failed",
+                            std::async(std::launch::async, VerifyFile,
+                                       std::cref(clrDll), entry.CLRSHA256));
+
+    for (auto& check : checks)
+        if (!check.second.get())
+            throw std::runtime_error(check.first);
+}
 
-            if (fs::exists(wdb2))
-                fs::remove_all(wdb2);
-        }
-        catch (fs::filesystem_error const&)
-        {
-            throw std::runtime_error("Failed to clear cache folder");
-        }
+// decrypt the realm's password, which is only kept until the client has it
+SecureBuffer DecryptPassword(const ConfigEntry& entry, const Config& config)
+{
+    SecureBuffer password(0);
+
+    if (entry.Username.empty())
+        return password;
+
+    auto credential = entry.Password;
+
+    if (!entry.VaultRealm.empty() &&
+        !config.vault->Find(entry.VaultRealm, entry.Username, credential))
+    {
+        std::stringstream str;
+        str << "Account \"" << entry.Username << "\" for realm \""
+            << entry.VaultRealm << "\" not found in vault";
+        throw std::runtime_error(str.str());
     }
 
-    // step 8: if the architectures match, inject and stop
-    if (us32 == them32)
+    if (credential.empty())
+        return password;
+
+    // without the key, the agent is asked instead
+    if (config.key.empty() && config.useAgent)
     {
-        ::Inject(entry);
-        return;
+        if (!AgentDecrypt(credential, password))
+            throw std::runtime_error(
+                "Failed to decrypt password.  The key agent may have timed out");
     }
+    else if (!DecryptCredential(config.key, credential, password))
+        throw std::runtime_error("Failed to decrypt password");
 
-    // if we reach here it is because we need to run the other launcher executable
-    // so that we can inject the right dll.  find the launcher and setup the
-    // environment...
+    return password;
+}
 
+// prepare the cache as requested
+void PrepareWDB(const ConfigEntry& entry, bool clearWDB)
+{
+    auto wdb = entry.WDB;
+
+    if (wdb == WDBMode::Default)
+        wdb = clearWDB ? WDBMode::Clear : WDBMode::Keep;
+
+    std::lock_guard<std::mutex> guard(wdbMutex);
+
+    // the deletion itself happens in the background, so this does not depend
+    // on the size of the cache
+    if (wdb == WDBMode::Clear)
+        ClearWDB(entry.Path.parent_path());
+    // give each realm its own cache rather than letting them poison each other
+    else if (wdb == WDBMode::Snapshot)
+        SwitchWDB(entry.Path.parent_path(), entry.Name);
+}
+
+// run the other launcher executable so that it can inject the right dll.  the
+// result becomes the id of the client it created, or zero if it failed.
+std::shared_future<unsigned int> LaunchOther(const ConfigEntry& entry,
+                                             const std::string& key, bool us32,
+                                             const ProcessPlacement& placement)
+{
+    // find the launcher and setup the environment...
     auto const hmod = ::GetModuleHandle(nullptr);
     TCHAR path[MAX_PATH];
     ::GetModuleFileName(hmod, path, MAX_PATH);
@@ -156,99 +234,497 @@ void Launch(const ConfigEntry& entry, bool clearWDB, const std::string& key)
         throw std::runtime_error(msg.str());
     }
 
-    std::string envEntry(EnvEntry);
-    envEntry += "=" + entry.Name;
+    // setup environment so the other launcher executable knows not to load the
+    // GUI.  an affinity planned for a group cannot be derived from the entry
+    // alone, and an empty value leaves it unset.
+    return GetProcessBackend().StartLauncher(
+        exe, {{EnvEntry, entry.Name},
+              {EnvKey, key},
+              {EnvAffinity, FormatProcessorList(placement.Affinity)},
+              {EnvParent, std::to_string(::GetCurrentProcessId())}});
+}
+
+unsigned int Launch(const ConfigEntry& entry, const Config& config,
+                    const ProcessPlacement& placement, bool wait = false);
+
+// restrain the client while it is in the background, and sample the resources
+// it uses, restarting it should it crash while starting up.  if we were started
+// by the other launcher, it does this instead, as we are about to exit.
+void WatchClient(const ConfigEntry& entry, const Config& config,
+                 const ProcessPlacement& placement, unsigned int pid)
+{
+    if (!pid || getenv(EnvParent))
+        return;
+
+    try
+    {
+        Govern(pid, entry.Background);
+
+        // the restart happens long after this launch, by which time the realm
+        // may have been reloaded, so it is found again by name
+        Supervise(entry.Name, pid, entry.Restart,
+                  [realm = entry.Name, config = config.shared_from_this(),
+                   placement]()
+                  {
+                      try
+                      {
+                          auto const entry = config->FindEntry(realm);
+
+                          if (!entry)
+                              throw std::runtime_error("Realm \"" + realm +
+                                                       "\" no longer exists");
+
+                          Launch(*entry, *config, placement);
+                      }
+                      catch (std::exception const& e)
+                      {
+                          MessageBoxA(nullptr, e.what(), "Restart Exception",
+                                      MB_ICONERROR);
+                      }
+                  });
+    }
+    catch (std::exception const& e)
+    {
+        DebugLog("unable to watch \"" + entry.Name + "\": " + e.what());
+    }
+}
+
+// one line of the tray menu describing a running client
+std::basic_string<TCHAR> FormatStats(const ClientStats& stats)
+{
+    std::stringstream str;
+    str.setf(std::ios::fixed);
+    str.precision(1);
 
-    std::string envKey(EnvKey);
-    envKey += "=" + key;
+    str << "    " << stats.Id << ": " << stats.Cpu << "% cpu, "
+        << stats.WorkingSet / (1024 * 1024) << " MB working set, "
+        << stats.PrivateBytes / (1024 * 1024) << " MB private, "
+        << stats.Handles << " handles, " << stats.ReadRate / 1024
+        << " KB/s read, " << stats.WriteRate / 1024 << " KB/s written, up "
+        << stats.Uptime.count() / 60 << "m";
 
-    // step 9: setup environment so the other launcher executable knows not to
-    // load the GUI
-    _putenv(envEntry.c_str());
-    _putenv(envKey.c_str());
+#ifdef UNICODE
+    return make_wstring(str.str());
+#else
+    return str.str();
+#endif
+}
 
-    STARTUPINFOA si;
-    PROCESS_INFORMATION pi;
+// park a suspended client for the realm, if it asks for one, so that the next
+// launch need only boot and resume it
+void Prewarm(const ConfigEntry& entry)
+{
+    if (!entry.Prewarm)
+        return;
 
-    ZeroMemory(&si, sizeof(si));
-    ZeroMemory(&pi, sizeof(pi));
+    FillWarmPool(entry.Name,
+                 [&entry]()
+                 {
+                     VerifyExe(entry);
+                     CheckModules(entry);
 
-    // step 10: run the other launcher executable
-    if (!::CreateProcessA(exe.string().c_str(), nullptr, nullptr, nullptr, FALSE,
-                          0, nullptr, nullptr, &si, &pi))
-        throw std::runtime_error("CreateProcess failed");
+                     return CreateClient(GetProcessBackend(), entry);
+                 });
 }
 
-template <typename T>
-T RoundUp(T val, T mul)
+// returns the id of the client, or zero if it is not known.  a client launched
+// by the other launcher is only known if we wait for it to be.
+unsigned int Launch(const ConfigEntry& entry, const Config& config,
+                    const ProcessPlacement& placement, bool wait)
 {
-    return mul * (1 + ((val - 1) / mul));
+    auto& backend = GetProcessBackend();
+
+    // step 1: ensure exe exists
+    if (!FileExists(entry.Path))
+        throw std::runtime_error("Exe file not found");
+
+    // a launch by the other launcher was recorded by the one which started it
+    if (config.predictLaunches && !getenv(EnvParent))
+        RecordLaunch(entry.Name);
+
+    // the client spends most of its startup reading its archives, so begin
+    // reading them ahead as early as possible.  if we were started by the other
+    // launcher, it has already begun, and our threads would not outlive us.
+    if (entry.Prefetch && !getenv(EnvParent))
+        PrefetchClientData(entry.Path.parent_path());
+
+    // step 2: determine whether the launcher and target binary are running in 32
+    // bit mode.  if they differ, the other launcher executable performs the
+    // remaining steps.
+    const bool them32 = backend.Is32Bit(entry.Path);
+    const bool us32 = sizeof(void*) == 4;
+
+    if (us32 != them32)
+    {
+        // the other launcher gets the keys from the agent, if it has them
+        auto const reported = LaunchOther(
+            entry, config.useAgent ? std::string() : config.key, us32,
+            placement);
+
+        // it may show errors of its own, so unless told to wait, the client
+        // is watched once it reports without holding up the menu meanwhile
+        auto watch = [realm = entry.Name, config = config.shared_from_this(),
+                      placement, reported]()
+        {
+            auto const pid = reported.get();
+
+            if (auto const entry = config->FindEntry(realm))
+                WatchClient(*entry, *config, placement, pid);
+
+            return pid;
+        };
+
+        if (wait)
+            return watch();
+
+        std::thread(watch).detach();
+        return 0;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    auto const roundTrips = backend.Counters.RoundTrips();
+
+    unsigned int pid;
+
+    auto password = DecryptPassword(entry, config);
+
+    if (auto warm = entry.Prewarm ? TakeWarmClient(entry.Name) : nullptr)
+    {
+        // the client was verified and created ahead of time, leaving only its
+        // cache and settings to prepare.  the dlls it is about to load may have
+        // changed since it was parked, so they are checked again.
+        try
+        {
+            CheckModules(entry);
+            PrepareWDB(entry, config.clearWDB);
+        }
+        catch (...)
+        {
+            warm->Terminate();
+            throw;
+        }
+
+        auto const client =
+            BootClient(std::move(warm), entry, placement, password);
+
+        client->Resume();
+
+        pid = client->GetId();
+    }
+    else if (config.pipelinedLaunch)
+    {
+        // only the suspended process is created alongside the checksum and the
+        // cache.  booting loads the native dlls and runs their code, so it
+        // waits until every check has passed.
+        auto verify = std::async(std::launch::async, VerifyExe, std::cref(entry));
+        auto wdb = std::async(std::launch::async, PrepareWDB, std::cref(entry),
+                              config.clearWDB);
+
+        CheckModules(entry);
+
+        auto process = CreateClient(backend, entry);
+
+        try
+        {
+            verify.get();
+            wdb.get();
+        }
+        catch (...)
+        {
+            process->Terminate();
+            throw;
+        }
+
+        auto const client =
+            BootClient(std::move(process), entry, placement, password);
+
+        client->Resume();
+
+        pid = client->GetId();
+    }
+    else
+    {
+        // step 3: verify checksum
+        VerifyExe(entry);
+
+        // step 4: ensure our dll, native dlls and clr dll exist
+        CheckModules(entry);
+
+        // step 5: prepare the cache
+        PrepareWDB(entry, config.clearWDB);
+
+        // step 6: inject
+        pid = ::Inject(backend, entry, placement, password);
+    }
+
+    // the client has been handed its settings
+    password = SecureBuffer(0);
+
+    auto const elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    std::stringstream str;
+    str << "launched \"" << entry.Name << "\" in " << elapsed.count()
+        << "us with " << backend.Counters.RoundTrips() - roundTrips
+        << " cross-process round-trips";
+    DebugLog(str.str());
+
+    WatchClient(entry, config, placement, pid);
+
+    // replace the client which was just used, or park the first one
+    Prewarm(entry);
+
+    return pid;
 }
 
-std::string DataToHex(const std::vector<std::uint8_t>& data)
+void Launch(const ConfigGroup& group,
+            const std::vector<const ConfigEntry*>& entries, const Config& config)
 {
+    CoreTopology cores;
+
+    for (auto const entry : entries)
+    {
+        if (entry->Process.AutoAffinity)
+        {
+            cores = GetProcessBackend().GetPhysicalCores();
+            break;
+        }
+    }
+
+    std::vector<std::string> names;
+
+    for (auto const entry : entries)
+        names.push_back(entry->Name);
+
+    auto const report = LaunchGroup(
+        GetProcessBackend(), group.Policy, names,
+        [&entries, &config, &cores](std::size_t index)
+        {
+            auto const& entry = *entries[index];
+
+            // each launch holds its place in the group until its client is
+            // known, even if it is made by the other launcher
+            if (!entry.Process.AutoAffinity)
+            {
+                Launch(entry, config, entry.Process, true);
+                return;
+            }
+
+            // spread the clients of the group across the physical cores
+            auto placement = entry.Process;
+            placement.Affinity = PlanAffinity(cores, entries.size(), index);
+
+            Launch(entry, config, placement, true);
+        });
+
     std::stringstream str;
+    str << "launched " << entries.size() - report.Errors.size()
+        << " of " << entries.size() << " clients for \"" << group.Name
+        << "\" in " << report.Elapsed.count() << "ms";
 
-    str << std::hex << std::nouppercase << std::setfill('0');
+    if (report.AdmissionTimeouts)
+        str << ", " << report.AdmissionTimeouts
+            << " without waiting any longer for resources";
 
-    for (auto const& c : data)
-        str << std::setw(2) << static_cast<std::uint32_t>(c);
+    DebugLog(str.str());
 
-    return str.str();
+    if (report.Errors.empty())
+        return;
+
+    std::stringstream msg;
+    msg << "Failed to launch " << report.Errors.size() << " of "
+        << entries.size() << " clients:";
+
+    for (auto const& error : report.Errors)
+        msg << "\n" << error;
+
+    throw std::runtime_error(msg.str());
 }
 
-bool ReadAndEncryptPassword(HINSTANCE hInstance, int nCmdShow, std::string& key,
-                            std::string& result)
+void Launch(const ConfigGroup& group, const Config& config)
 {
-    // if there are not already credentials in the config file, no key will have
-    // been input yet.  therefore we must read one.
-    if (key.empty())
+    std::vector<const ConfigEntry*> entries;
+
+    for (auto const& member : group.Members)
+        entries.push_back(config.FindEntry(member));
+
+    Launch(group, entries, config);
+}
+
+// launch a comma separated list of realms and groups.  returns false if none
+// of the names are recognized.  if a single realm is named, pid receives the
+// id of its client.
+bool Launch(const std::string& names, const Config& config, unsigned int& pid)
+{
+    std::vector<std::string> unknown;
+    std::vector<const ConfigEntry*> entries;
+    const ConfigGroup* onlyGroup = nullptr;
+    std::size_t count = 0;
+
+    std::stringstream str(names);
+    std::string name;
+
+    while (std::getline(str, name, ','))
     {
-        InputWindow keyWindow(hInstance, nCmdShow, "Enter your desired key...");
+        auto const first = name.find_first_not_of(" \t");
 
-        key = keyWindow.ReadKey();
+        if (first == std::string::npos)
+            continue;
 
-        // window was aborted
-        if (key.empty())
-            return false;
+        name = name.substr(first, name.find_last_not_of(" \t") - first + 1);
+        ++count;
+
+        if (auto const entry = config.FindEntry(name))
+            entries.push_back(entry);
+        else if (auto const group = config.FindGroup(name))
+        {
+            onlyGroup = group;
+
+            for (auto const& member : group->Members)
+                entries.push_back(config.FindEntry(member));
+        }
+        else
+            unknown.push_back(name);
     }
 
-    if (key.length() > AES_KEYLEN)
+    if (entries.empty())
         return false;
 
-    InputWindow passWindow(hInstance, nCmdShow, "Enter password to encrypt...");
+    if (!unknown.empty())
+    {
+        std::stringstream msg;
+        msg << "Unknown realm or group \"" << unknown.front() << "\"";
+        throw std::runtime_error(msg.str());
+    }
 
-    // the only purpose of this is to give us a way to determine if the password
-    // is decrypted successfully later
-    auto newPass = Config::Magic + passWindow.ReadKey();
+    // a single realm is launched exactly as it would be from the menu, unless
+    // the other launcher has planned an affinity for it as part of a group
+    if (count == 1 && !onlyGroup)
+    {
+        auto placement = entries.front()->Process;
 
-    // window was aborted
-    if (newPass.empty())
-        return false;
+        if (auto const envAffinity = getenv(EnvAffinity))
+            placement.Affinity = ParseProcessorList(envAffinity);
 
-    std::uint8_t keyRaw[AES_KEYLEN];
-    ::memset(keyRaw, 0, sizeof(keyRaw));
-    ::memcpy(keyRaw, key.c_str(), key.length());
+        pid = Launch(*entries.front(), config, placement);
+        return true;
+    }
+
+    // a single group keeps its own settings.  otherwise the defaults are used.
+    ConfigGroup adhoc {};
+
+    if (count == 1)
+        adhoc = *onlyGroup;
+    else
+    {
+        adhoc.Name = names;
+        adhoc.Policy.Parallelism = GroupPolicy::DefaultParallelism;
+    }
 
-    AES_ctx ctx;
-    ZeroMemory(&ctx, sizeof(ctx));
-    AES_init_ctx_iv(&ctx, keyRaw, Config::Iv);
+    Launch(adhoc, entries, config);
 
-    std::vector<std::uint8_t> buffer(
-        RoundUp(newPass.length(), static_cast<size_t>(AES_BLOCKLEN)));
+    return true;
+}
 
-    ::memcpy(&buffer[0], newPass.c_str(), newPass.length());
+// the fraction of processor time spent idle since the previous call
+double IdleFraction()
+{
+    static std::uint64_t lastIdle = 0;
+    static std::uint64_t lastTotal = 0;
 
-    // PKCS7 padding
-    const std::uint8_t pad =
-        static_cast<std::uint8_t>(buffer.size() - newPass.length());
+    FILETIME idle, kernel, user;
 
-    if (pad > 0)
-        ::memset(&buffer[newPass.length()], pad, pad);
+    if (!::GetSystemTimes(&idle, &kernel, &user))
+        return 0.0;
 
-    AES_CBC_encrypt_buffer(&ctx, &buffer[0], buffer.size());
+    auto const value = [](const FILETIME& time)
+    {
+        return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) |
+               time.dwLowDateTime;
+    };
 
-    result = DataToHex(buffer);
+    // kernel time includes idle time
+    auto const idleNow = value(idle);
+    auto const totalNow = value(kernel) + value(user);
+
+    auto const result =
+        totalNow > lastTotal ? static_cast<double>(idleNow - lastIdle) /
+                                   static_cast<double>(totalNow - lastTotal)
+                             : 0.0;
+
+    lastIdle = idleNow;
+    lastTotal = totalNow;
+
+    return result;
+}
+
+// verify and prefetch the realms most likely to be launched next, so that
+// their launches find the checksum cached and the archives in memory
+void PrepareLikelyRealms(const Config& config)
+{
+    for (auto const& name : PredictLaunches(PredictedRealms))
+    {
+        auto const entry = config.FindEntry(name);
+
+        if (!entry || !fs::exists(entry->Path) || !RecordPrepared(name))
+            continue;
+
+        try
+        {
+            VerifyExe(*entry);
+        }
+        catch (std::exception const&)
+        {
+            // the launch itself will report the problem
+        }
+
+        PrefetchClientData(entry->Path.parent_path(),
+                           [name](std::uint64_t bytes)
+                           { RecordPrefetched(name, bytes); });
+    }
+}
+
+// the key is kept by the caller for the rest of the session, rather than in the
+// config, which launches may be reading
+bool ReadAndEncryptPassword(HINSTANCE hInstance, int nCmdShow,
+                            const Config& config, std::string& key,
+                            std::string& result)
+{
+    // no key will have been input yet if there are not already credentials in
+    // the config file, or if the agent holds the keys derived from it.
+    // therefore we must read one, and check it against any credentials.
+    if (key.empty())
+    {
+        auto const existing = !config.GetCredentials().empty();
+
+        InputWindow keyWindow(hInstance, nCmdShow,
+                              existing ? "Enter your wowreeb key..."
+                                       : "Enter your desired key...");
+
+        auto input = keyWindow.ReadKey();
+
+        // window was aborted
+        if (input.empty())
+            return false;
+
+        if (existing && !config.CheckKey(input))
+        {
+            ::MessageBoxA(nullptr, "Incorrect key", "Failure", MB_ICONERROR);
+            return false;
+        }
+
+        key = std::move(input);
+    }
+
+    InputWindow passWindow(hInstance, nCmdShow, "Enter password to encrypt...");
+
+    auto const newPass = passWindow.ReadKey();
+
+    // window was aborted
+    if (newPass.empty())
+        return false;
+
+    result = EncryptCredential(key, newPass);
 
     return true;
 }
@@ -273,12 +749,116 @@ bool SetClipboardText(const std::string& text)
 
     return true;
 }
+
+// we have no console of our own, so a headless run reports to the one which
+// started it, if any
+void Report(const std::string& message)
+{
+    DebugLog(message);
+
+    auto const out = ::GetStdHandle(STD_OUTPUT_HANDLE);
+
+    if (!out || out == INVALID_HANDLE_VALUE)
+        return;
+
+    auto const line = message + "\r\n";
+    DWORD written;
+    ::WriteFile(out, line.c_str(), static_cast<DWORD>(line.length()), &written,
+                nullptr);
+}
+
+// encrypt every credential in the config file with a new key, without showing
+// any window
+int Rekey(const Config& config, const std::string& newKey)
+{
+    ::AttachConsole(ATTACH_PARENT_PROCESS);
+
+    auto const oldKey = getenv(EnvKey);
+
+    if (!oldKey)
+    {
+        Report(std::string(EnvKey) + " must hold the current key");
+        return EXIT_FAILURE;
+    }
+
+    if (newKey.empty())
+    {
+        Report("The new key must not be empty");
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        auto const result = RekeyConfig(config.GetPath(), oldKey, newKey);
+        auto const ms =
+            (std::max)(result.Elapsed, std::chrono::milliseconds(1)).count();
+
+        std::stringstream str;
+        str << "Encrypted " << result.Credentials << " credentials with the new "
+            << "key in " << ms << "ms (" << result.Credentials * 1000 / ms
+            << " per second)";
+        Report(str.str());
+    }
+    catch (std::exception const& e)
+    {
+        Report(std::string("Failed to change key: ") + e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// copy the passwords in the config file into a vault, still encrypted, so that
+// the config file can refer to their accounts instead
+int ExportVault(const Config& config, const fs::path& file)
+{
+    ::AttachConsole(ATTACH_PARENT_PROCESS);
+
+    try
+    {
+        std::vector<VaultRecord> records;
+
+        if (fs::exists(file))
+            records = Vault(file).Records();
+
+        std::size_t exported = 0;
+
+        for (auto const& entry : config.entries)
+        {
+            if (entry.Username.empty() || entry.Password.empty())
+                continue;
+
+            records.push_back({entry.Name, entry.Username, entry.Password});
+            ++exported;
+        }
+
+        Vault::Write(file, std::move(records));
+
+        std::stringstream str;
+        str << "Stored " << exported << " passwords in the vault, which holds "
+            << Vault(file).Count() << " accounts";
+        Report(str.str());
+    }
+    catch (std::exception const& e)
+    {
+        Report(std::string("Failed to store passwords in vault: ") + e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
 } // namespace
 
 int CALLBACK WinMain(_In_ HINSTANCE hInstance, _In_ HINSTANCE hPrevInstance,
                      _In_ LPSTR lpCmdLine, _In_ int nCmdShow)
 {
-    Config config(_T("config.xml"));
+    // the key agent needs neither the config file nor any window
+    if (auto const envAgent = getenv(EnvAgent))
+        return RunKeyAgent(
+            std::chrono::minutes(std::strtoul(envAgent, nullptr, 10)));
+
+    auto const sharedConfig = std::make_shared<Config>(_T("config.xml"));
+    auto& config = *sharedConfig;
 
     try
     {
@@ -291,61 +871,132 @@ int CALLBACK WinMain(_In_ HINSTANCE hInstance, _In_ HINSTANCE hPrevInstance,
         return EXIT_FAILURE;
     }
 
-    if (auto const envKey = getenv(EnvKey))
-    {
-        if (!config.VerifyKey(envKey))
-        {
-            ::MessageBoxA(nullptr, "Incorrect key", "Failure", MB_ICONERROR);
-            return EXIT_FAILURE;
-        }
-    }
-    else
+    EnableDebugLog(config.debugLog);
+
+    // finish deleting any cache folders which a previous run left behind
     {
-        bool needAuthentication = false;
+        std::set<fs::path> clientDirs;
 
         for (auto const& entry : config.entries)
+            clientDirs.insert(entry.Path.parent_path());
+
+        for (auto const& dir : clientDirs)
+            SweepWDBTrash(dir);
+    }
+
+    if (auto const envRekey = getenv(EnvRekey))
+        return Rekey(config, envRekey);
+
+    if (auto const envVault = getenv(EnvVault))
+        return ExportVault(config, envVault);
+
+    // deriving the key needs a good deal of memory, which may not be had
+    try
+    {
+        if (auto const envKey = getenv(EnvKey))
         {
-            if (!entry.Username.empty() && !entry.Password.empty())
+            if (!config.VerifyKey(envKey))
             {
-                needAuthentication = true;
-                break;
+                ::MessageBoxA(nullptr, "Incorrect key", "Failure", MB_ICONERROR);
+                return EXIT_FAILURE;
             }
         }
-
-        // if some settings provide credentials, we must authenticate the user
-        // before we proceed
-        if (needAuthentication)
+        else
         {
-            do
+            bool needAuthentication = false;
+
+            for (auto const& entry : config.entries)
             {
-                InputWindow authWindow(hInstance, nCmdShow,
-                                       "Enter your wowreeb key...");
+                if (!entry.Username.empty() &&
+                    (!entry.Password.empty() || !entry.VaultRealm.empty()))
+                {
+                    needAuthentication = true;
+                    break;
+                }
+            }
 
-                auto const key = authWindow.ReadKey();
+            // the agent may hold the keys already, given them by an earlier run
+            if (needAuthentication && config.keyAgentTimeout &&
+                config.VerifyAgent())
+                needAuthentication = false;
 
-                // window was aborted
-                if (key.empty())
-                    return EXIT_FAILURE;
+            // if some settings provide credentials, we must authenticate the
+            // user before we proceed
+            if (needAuthentication)
+            {
+                do
+                {
+                    InputWindow authWindow(hInstance, nCmdShow,
+                                           "Enter your wowreeb key...");
 
-                if (config.VerifyKey(key))
-                    break;
+                    auto const key = authWindow.ReadKey();
 
-                ::MessageBoxA(nullptr, "Incorrect key", "Failure", MB_ICONERROR);
-            } while (true);
+                    // window was aborted
+                    if (key.empty())
+                        return EXIT_FAILURE;
+
+                    if (config.VerifyKey(key))
+                        break;
+
+                    ::MessageBoxA(nullptr, "Incorrect key", "Failure",
+                                  MB_ICONERROR);
+                } while (true);
+
+                // so that later runs, and the other launcher, need neither the
+                // key nor to derive it
+                if (config.keyAgentTimeout)
+                    config.useAgent =
+                        ShareKey(config.key, config.GetCredentials(),
+                                 std::chrono::minutes(config.keyAgentTimeout));
+            }
         }
     }
+    catch (std::exception const& e)
+    {
+        ::MessageBoxA(nullptr, e.what(), "Authentication Error", MB_ICONERROR);
+        return EXIT_FAILURE;
+    }
 
     try
     {
         if (auto const envEntry = getenv(EnvEntry))
         {
-            for (auto const& entry : config.entries)
+            // we exit as soon as the launch is done, so must not park clients
+            DrainWarmPool();
+
+            unsigned int pid = 0;
+
+            // the launcher which started us governs the client, and so must be
+            // told which it is
+            if (Launch(std::string(envEntry), config, pid))
             {
-                if (entry.Name == envEntry)
-                {
-                    Launch(entry, config.clearWDB, config.key);
-                    return EXIT_SUCCESS;
-                }
+                if (pid && getenv(EnvParent))
+                    GetProcessBackend().ReportToLauncher(pid);
+
+                return EXIT_SUCCESS;
+            }
+        }
+
+        ConfigureSupervisor(std::chrono::milliseconds(config.sampleInterval));
+
+        ConfigureWarmPool(
+            static_cast<std::size_t>(config.warmPoolMemory) * 1024 * 1024,
+            std::chrono::seconds(config.warmPoolExpiry));
+
+        // only clients of our own architecture can be parked, as the other
+        // launcher exits as soon as it has launched
+        for (auto const& entry : config.entries)
+        {
+            try
+            {
+                if (entry.Prewarm && FileExists(entry.Path) &&
+                    GetProcessBackend().Is32Bit(entry.Path) ==
+                        (sizeof(void*) == 4))
+                    Prewarm(entry);
+            }
+            catch (std::exception const&)
+            {
+                // the launch itself will report the problem
             }
         }
 
@@ -363,17 +1014,60 @@ int CALLBACK WinMain(_In_ HINSTANCE hInstance, _In_ HINSTANCE hPrevInstance,
 #else
                 entry.Name.c_str(),
 #endif
-                [&entry, clearWDB = config.clearWDB, &key = config.key]()
+                [&entry, &config]()
                 {
                     try
                     {
-                        Launch(entry, clearWDB, key);
+                        Launch(entry, config, entry.Process);
                     }
                     catch (std::exception const& e)
                     {
                         MessageBoxA(nullptr, e.what(), "Launch Exception",
                                     MB_ICONERROR);
                     }
+                },
+                -1,
+                [&entry]()
+                {
+                    std::vector<std::basic_string<TCHAR>> lines;
+
+                    for (auto const& stats : GetClientStats(entry.Name))
+                        lines.push_back(FormatStats(stats));
+
+                    return lines;
+                });
+        }
+
+        if (!config.groups.empty())
+            icon->AddMenu(_T("-"));
+
+        for (auto const& group : config.groups)
+        {
+            icon->AddMenu(
+#ifdef UNICODE
+                make_wstring(group.Name).c_str(),
+#else
+                group.Name.c_str(),
+#endif
+                [&group, &config]()
+                {
+                    // a group may take some time to launch, so do not hold up
+                    // the menu while it does.  we may exit before it finishes.
+                    std::thread(
+                        [name = group.Name, config = config.shared_from_this()]()
+                        {
+                            try
+                            {
+                                if (auto const group = config->FindGroup(name))
+                                    Launch(*group, *config);
+                            }
+                            catch (std::exception const& e)
+                            {
+                                MessageBoxA(nullptr, e.what(),
+                                            "Launch Exception", MB_ICONERROR);
+                            }
+                        })
+                        .detach();
                 });
         }
 
@@ -381,12 +1075,43 @@ int CALLBACK WinMain(_In_ HINSTANCE hInstance, _In_ HINSTANCE hPrevInstance,
 
         bool shutdown = false;
 
+        if (config.predictLaunches)
+        {
+            icon->AddMenu(
+                _T("Statistics"),
+                []()
+                {
+                    auto const stats = GetPredictionStats();
+
+                    std::stringstream str;
+                    str << "Launches: " << stats.Launches << "\n"
+                        << "Realms prepared ahead: " << stats.Predictions
+                        << "\n"
+                        << "Launches prepared for: " << stats.Hits;
+
+                    if (stats.Launches)
+                        str << " (" << 100 * stats.Hits / stats.Launches
+                            << "%)";
+
+                    str << "\n"
+                        << "Prefetched: " << stats.PrefetchedBytes / (1024 * 1024)
+                        << " MB\n"
+                        << "Prefetched in vain: "
+                        << stats.WastedBytes / (1024 * 1024) << " MB";
+
+                    ::MessageBoxA(nullptr, str.str().c_str(),
+                                  "Prediction Statistics", MB_ICONINFORMATION);
+                });
+        }
+
         icon->AddMenu(
             _T("Encrypt Password"),
-            [hInstance, nCmdShow, &key = config.key]()
+            [hInstance, nCmdShow, config = sharedConfig,
+             key = config.key]() mutable
             {
                 std::string pw;
-                if (!ReadAndEncryptPassword(hInstance, nCmdShow, key, pw))
+                if (!ReadAndEncryptPassword(hInstance, nCmdShow, *config, key,
+                                            pw))
                     return;
 
                 if (!SetClipboardText(pw))
@@ -396,18 +1121,42 @@ int CALLBACK WinMain(_In_ HINSTANCE hInstance, _In_ HINSTANCE hPrevInstance,
                     return;
                 }
 
-                ::MessageBoxA(nullptr, "Encrypted password copied to clipboard",
-                              "Success!", MB_ICONINFORMATION);
+                // the parameters were calibrated to this machine, so are worth
+                // reporting
+                auto const message =
+                    "Encrypted password copied to clipboard\n\nKey derivation: " +
+                    FormatKdfParams(GetSessionKdfParams());
+
+                ::MessageBoxA(nullptr, message.c_str(), "Success!",
+                              MB_ICONINFORMATION);
             });
 
         icon->AddMenu(_T("Exit"), [&shutdown]() { shutdown = true; });
 
         // TODO: might as well use this thread to poll the config file for changes
-        while (!shutdown)
+        for (auto tick = 1u; !shutdown; ++tick)
+        {
             std::this_thread::sleep_for(std::chrono::seconds(1));
+
+            if (!config.predictLaunches || tick % PredictInterval ||
+                IdleFraction() < IdleThreshold || preparing.exchange(true))
+                continue;
+
+            std::thread(
+                [config = sharedConfig]()
+                {
+                    PrepareLikelyRealms(*config);
+                    preparing = false;
+                })
+                .detach();
+        }
+
+        DrainWarmPool();
     }
     catch (std::exception const& e)
     {
+        DrainWarmPool();
+
         ::MessageBoxA(nullptr, e.what(), "Exception", MB_ICONERROR);
         return EXIT_FAILURE;
     }